@@ -10,124 +10,370 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <stdint.h>
 
 #include <string.h>
+#include <math.h>
 
-int read_dada_header_from_file(const char *dada_header_file_name, dada_header_t *dada_header){
+int read_dada_header_from_file(const char *fname, dada_header_t *header){
 
-  char *dada_header_buffer = (char *)malloc(DADA_DEFAULT_HEADER_SIZE);
-  memset(dada_header_buffer, 0, DADA_DEFAULT_HEADER_SIZE);
+  char *buffer = (char *)malloc(DADA_DEFAULT_HEADER_SIZE);
+  memset(buffer, 0, DADA_DEFAULT_HEADER_SIZE);
 
-  fileread(dada_header_file_name, dada_header_buffer, DADA_DEFAULT_HEADER_SIZE);
-  read_dada_header(dada_header_buffer, dada_header);
+  fileread(fname, buffer, DADA_DEFAULT_HEADER_SIZE);
+  uint64_t missing = load_dada_header(buffer, DADA_DEFAULT_HEADER_SIZE, header);
 
-  free(dada_header_buffer);
+  free(buffer);
+
+  return missing ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+static const char *dada_header_keys[DADA_HEADER_NKEY] = {
+  "TSAMP",
+  "MJD_START",
+  "BW",
+  "UTC_START",
+  "NCHAN",
+  "NPKT",
+  "PKT_NSAMP",
+  "NCHAN_FINE",
+  "NAVERAGE",
+  "PKT_TSAMP",
+  "NPOL",
+  "NANT",
+  "NBIT",
+  "TOTALSAMPLES",
+  "PERIOD",
+};
+
+static const int dada_header_key_lengths[DADA_HEADER_NKEY] = {
+  5, 9, 2, 9, 5, 4, 9, 10, 8, 9, 4, 4, 4, 12, 6,
+};
+
+#define DADA_HEADER_HASH_SEED  31u
+#define DADA_HEADER_HASH_PRIME 16777619u
+
+static const int8_t dada_header_hash_table[DADA_HEADER_HASH_SIZE] = {
+   9, -1, -1, -1, 11, -1, -1,  1, -1, -1, -1, -1, -1, -1, 12,  4,
+   2, -1, 13, -1, -1, -1,  5, -1,  7, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1,  6, -1, -1, -1, -1, -1, -1, -1, 14, -1,
+  -1, -1, -1, -1,  3, -1, -1, -1,  0, -1, 10, -1, -1, -1,  8, -1,
+};
+
+static inline int dada_header_lookup(const char *key, int length, uint32_t hash){
+
+  int k = dada_header_hash_table[hash & (DADA_HEADER_HASH_SIZE - 1)];
+  if (k < 0 || dada_header_key_lengths[k] != length || memcmp(key, dada_header_keys[k], length))
+    return -1;
+
+  return k;
+}
+
+int dada_header_key_index(const char *key){
+
+  uint32_t hash = DADA_HEADER_HASH_SEED;
+  const char *p = key;
+  while (*p) hash = (hash ^ (unsigned char)*p++) * DADA_HEADER_HASH_PRIME;
+
+  return dada_header_lookup(key, p - key, hash);
+}
+
+void index_dada_header(const char *buffer, dada_header_index_t *index){
+
+  const char *p = buffer;
+
+  index->found = 0;
+  while (*p) {
+    // Key is the first token of a line
+    while (*p == ' ' || *p == '\t') p++;
+    const char *key = p;
+    uint32_t hash = DADA_HEADER_HASH_SEED;
+    while (*p && *p != ' ' && *p != '\t' && *p != '\n')
+      hash = (hash ^ (unsigned char)*p++) * DADA_HEADER_HASH_PRIME;
+
+    // Lines of other keys and later copies of a key are skipped at memchr speed, the first one wins as in ascii_header_get
+    int k = dada_header_lookup(key, p - key, hash);
+    if (k < 0 || (index->found & DADA_HEADER_BIT(k))) {
+      p = strchrnul(p, '\n');
+      if (*p) p++;
+      continue;
+    }
+
+    // Value runs to end of line or comment
+    while (*p == ' ' || *p == '\t') p++;
+    const char *value = p;
+    while (*p && *p != '\n' && *p != '#') p++;
+    const char *end = p;
+    while (end > value && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r')) end--;
+    p = strchrnul(p, '\n');
+    if (*p) p++;
+
+    index->span[k].value  = value;
+    index->span[k].length = end - value;
+    index->found |= DADA_HEADER_BIT(k);
+  }
+}
+
+static int dada_header_span_int(const dada_header_span_t *span, int *value){
+  // Decimal digits only, strtol pays for locale and base detection
+  const char *p = span->value;
+  const char *end = span->value + span->length;
+  int negative = p < end && *p == '-';
+  if (p < end && (*p == '-' || *p == '+')) p++;
+  const char *digits = p;
+  int64_t result = 0;
+  while (p < end && *p >= '0' && *p <= '9') result = result*10 + (*p++ - '0');
+  *value = negative ? -result : result;
+  return p == digits;
+}
+
+static int dada_header_span_uint64(const dada_header_span_t *span, uint64_t *value){
+  const char *p = span->value;
+  const char *end = span->value + span->length;
+  if (p < end && *p == '+') p++;
+  const char *digits = p;
+  uint64_t result = 0;
+  while (p < end && *p >= '0' && *p <= '9') result = result*10 + (*p++ - '0');
+  *value = result;
+  return p == digits;
+}
+
+static int dada_header_span_double(const dada_header_span_t *span, double *value){
+  char *end;
+  *value = strtod(span->value, &end);
+  return end == span->value || end > span->value + span->length;
+}
+
+static int dada_header_span_string(const dada_header_span_t *span, char *value){
+  // First word only, the same as %s
+  int length = 0;
+  while (length < span->length && length < DADA_STRLEN - 1 && span->value[length] != ' ' && span->value[length] != '\t') length++;
+  memcpy(value, span->value, length);
+  value[length] = '\0';
+  return length == 0;
+}
+
+int get_dada_header_span(const dada_header_index_t *index, const char *key, dada_header_span_t *span){
+
+  int k = dada_header_key_index(key);
+  if (k < 0 || !(index->found & DADA_HEADER_BIT(k)))
+    return EXIT_FAILURE;
+
+  *span = index->span[k];
+  return EXIT_SUCCESS;
+}
+
+int get_dada_header_int(const dada_header_index_t *index, const char *key, int *value){
+
+  dada_header_span_t span;
+  if (get_dada_header_span(index, key, &span) ||
+      dada_header_span_int(&span, value))
+    return EXIT_FAILURE;
+
+  return EXIT_SUCCESS;
+}
+
+int get_dada_header_uint64(const dada_header_index_t *index, const char *key, uint64_t *value){
+
+  dada_header_span_t span;
+  if (get_dada_header_span(index, key, &span) ||
+      dada_header_span_uint64(&span, value))
+    return EXIT_FAILURE;
 
   return EXIT_SUCCESS;
 }
 
-int read_dada_header(const char *dada_header_buffer, dada_header_t *dada_header){
+int get_dada_header_double(const dada_header_index_t *index, const char *key, double *value){
+
+  dada_header_span_t span;
+  if (get_dada_header_span(index, key, &span) ||
+      dada_header_span_double(&span, value))
+    return EXIT_FAILURE;
 
-  if (ascii_header_get(dada_header_buffer, "TSAMP", "%lf", &dada_header->tsamp) < 0)  {
-    fprintf(stderr, "WRITE_DADA_HEADER_ERROR: Error getting TSAMP, "
+  return EXIT_SUCCESS;
+}
+
+int get_dada_header_string(const dada_header_index_t *index, const char *key, char *value){
+
+  dada_header_span_t span;
+  if (get_dada_header_span(index, key, &span) ||
+      dada_header_span_string(&span, value))
+    return EXIT_FAILURE;
+
+  return EXIT_SUCCESS;
+}
+
+uint64_t parse_dada_header(const char *buffer, dada_header_t *header){
+
+  dada_header_index_t index;
+  index_dada_header(buffer, &index);
+
+  if ((index.found & DADA_HEADER_BIT(DADA_HEADER_TSAMP)) &&
+      dada_header_span_double(&index.span[DADA_HEADER_TSAMP], &header->tsamp))
+    index.found &= ~DADA_HEADER_BIT(DADA_HEADER_TSAMP);
+  if ((index.found & DADA_HEADER_BIT(DADA_HEADER_MJD_START)) &&
+      dada_header_span_double(&index.span[DADA_HEADER_MJD_START], &header->mjd_start))
+    index.found &= ~DADA_HEADER_BIT(DADA_HEADER_MJD_START);
+  if ((index.found & DADA_HEADER_BIT(DADA_HEADER_BW)) &&
+      dada_header_span_double(&index.span[DADA_HEADER_BW], &header->bw))
+    index.found &= ~DADA_HEADER_BIT(DADA_HEADER_BW);
+  if ((index.found & DADA_HEADER_BIT(DADA_HEADER_UTC_START)) &&
+      dada_header_span_string(&index.span[DADA_HEADER_UTC_START], header->utc_start))
+    index.found &= ~DADA_HEADER_BIT(DADA_HEADER_UTC_START);
+  if ((index.found & DADA_HEADER_BIT(DADA_HEADER_NCHAN)) &&
+      dada_header_span_int(&index.span[DADA_HEADER_NCHAN], &header->nchan))
+    index.found &= ~DADA_HEADER_BIT(DADA_HEADER_NCHAN);
+  if ((index.found & DADA_HEADER_BIT(DADA_HEADER_NPKT)) &&
+      dada_header_span_int(&index.span[DADA_HEADER_NPKT], &header->npkt))
+    index.found &= ~DADA_HEADER_BIT(DADA_HEADER_NPKT);
+  if ((index.found & DADA_HEADER_BIT(DADA_HEADER_PKT_NSAMP)) &&
+      dada_header_span_int(&index.span[DADA_HEADER_PKT_NSAMP], &header->pkt_nsamp))
+    index.found &= ~DADA_HEADER_BIT(DADA_HEADER_PKT_NSAMP);
+  if ((index.found & DADA_HEADER_BIT(DADA_HEADER_NCHAN_FINE)) &&
+      dada_header_span_int(&index.span[DADA_HEADER_NCHAN_FINE], &header->nchan_fine))
+    index.found &= ~DADA_HEADER_BIT(DADA_HEADER_NCHAN_FINE);
+  if ((index.found & DADA_HEADER_BIT(DADA_HEADER_NAVERAGE)) &&
+      dada_header_span_int(&index.span[DADA_HEADER_NAVERAGE], &header->naverage))
+    index.found &= ~DADA_HEADER_BIT(DADA_HEADER_NAVERAGE);
+  if ((index.found & DADA_HEADER_BIT(DADA_HEADER_PKT_TSAMP)) &&
+      dada_header_span_double(&index.span[DADA_HEADER_PKT_TSAMP], &header->pkt_tsamp))
+    index.found &= ~DADA_HEADER_BIT(DADA_HEADER_PKT_TSAMP);
+  if ((index.found & DADA_HEADER_BIT(DADA_HEADER_NPOL)) &&
+      dada_header_span_int(&index.span[DADA_HEADER_NPOL], &header->npol))
+    index.found &= ~DADA_HEADER_BIT(DADA_HEADER_NPOL);
+  if ((index.found & DADA_HEADER_BIT(DADA_HEADER_NANT)) &&
+      dada_header_span_int(&index.span[DADA_HEADER_NANT], &header->nant))
+    index.found &= ~DADA_HEADER_BIT(DADA_HEADER_NANT);
+  if ((index.found & DADA_HEADER_BIT(DADA_HEADER_NBIT)) &&
+      dada_header_span_int(&index.span[DADA_HEADER_NBIT], &header->nbit))
+    index.found &= ~DADA_HEADER_BIT(DADA_HEADER_NBIT);
+  if ((index.found & DADA_HEADER_BIT(DADA_HEADER_TOTALSAMPLES)) &&
+      dada_header_span_uint64(&index.span[DADA_HEADER_TOTALSAMPLES], &header->totalsamples))
+    index.found &= ~DADA_HEADER_BIT(DADA_HEADER_TOTALSAMPLES);
+  if ((index.found & DADA_HEADER_BIT(DADA_HEADER_PERIOD)) &&
+      dada_header_span_double(&index.span[DADA_HEADER_PERIOD], &header->period))
+    index.found &= ~DADA_HEADER_BIT(DADA_HEADER_PERIOD);
+
+  return ~index.found & DADA_HEADER_ALL;
+}
+
+int read_dada_header(const char *buffer, dada_header_t *header){
+
+  uint64_t missing = parse_dada_header(buffer, header);
+
+  for (int k = 0; k < DADA_HEADER_NKEY; k++) {
+    if (missing & DADA_HEADER_BIT(k)) {
+      fprintf(stderr, "READ_DADA_HEADER_ERROR: Error getting %s, "
+              "which happens at %s, line [%d].\n",
+              dada_header_keys[k], __FILE__, __LINE__);
+    }
+  }
+
+  return missing ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+int read_dada_header_ascii(const char *buffer, dada_header_t *header){
+
+  if (ascii_header_get(buffer, "TSAMP", "%lf", &header->tsamp) < 0)  {
+    fprintf(stderr, "READ_DADA_HEADER_ERROR: Error getting TSAMP, "
             "which happens at %s, line [%d].\n",
             __FILE__, __LINE__);
     exit(EXIT_FAILURE);
   }
 
-  if (ascii_header_get(dada_header_buffer, "MJD_START", "%lf", &dada_header->mjd_start) < 0)  {
-    fprintf(stderr, "WRITE_DADA_HEADER_ERROR: Error getting MJD_START, "
+  if (ascii_header_get(buffer, "MJD_START", "%lf", &header->mjd_start) < 0)  {
+    fprintf(stderr, "READ_DADA_HEADER_ERROR: Error getting MJD_START, "
             "which happens at %s, line [%d].\n",
             __FILE__, __LINE__);
     exit(EXIT_FAILURE);
   }
 
-  if (ascii_header_get(dada_header_buffer, "BW", "%lf", &dada_header->bw) < 0)  {
-    fprintf(stderr, "WRITE_DADA_HEADER_ERROR: Error getting BW, "
+  if (ascii_header_get(buffer, "BW", "%lf", &header->bw) < 0)  {
+    fprintf(stderr, "READ_DADA_HEADER_ERROR: Error getting BW, "
             "which happens at %s, line [%d].\n",
             __FILE__, __LINE__);
     exit(EXIT_FAILURE);
   }
 
-  if (ascii_header_get(dada_header_buffer, "UTC_START", "%s", &dada_header->utc_start) < 0)  {
-    fprintf(stderr, "WRITE_DADA_HEADER_ERROR: Error getting UTC_START, "
+  if (ascii_header_get(buffer, "UTC_START", "%s", &header->utc_start) < 0)  {
+    fprintf(stderr, "READ_DADA_HEADER_ERROR: Error getting UTC_START, "
             "which happens at %s, line [%d].\n",
             __FILE__, __LINE__);
     exit(EXIT_FAILURE);
   }
 
-  if (ascii_header_get(dada_header_buffer, "NCHAN", "%d", &dada_header->nchan) < 0)  {
-    fprintf(stderr, "WRITE_DADA_HEADER_ERROR: Error getting NCHAN, "
+  if (ascii_header_get(buffer, "NCHAN", "%d", &header->nchan) < 0)  {
+    fprintf(stderr, "READ_DADA_HEADER_ERROR: Error getting NCHAN, "
             "which happens at %s, line [%d].\n",
             __FILE__, __LINE__);
     exit(EXIT_FAILURE);
   }
 
-  if (ascii_header_get(dada_header_buffer, "NPKT", "%d", &dada_header->npkt) < 0)  {
-    fprintf(stderr, "WRITE_DADA_HEADER_ERROR: Error getting NPKT, "
+  if (ascii_header_get(buffer, "NPKT", "%d", &header->npkt) < 0)  {
+    fprintf(stderr, "READ_DADA_HEADER_ERROR: Error getting NPKT, "
             "which happens at %s, line [%d].\n",
             __FILE__, __LINE__);
     exit(EXIT_FAILURE);
   }
 
-  if (ascii_header_get(dada_header_buffer, "PKT_NSAMP", "%d", &dada_header->pkt_nsamp) < 0)  {
-    fprintf(stderr, "WRITE_DADA_HEADER_ERROR: Error getting PKT_NSAMP, "
+  if (ascii_header_get(buffer, "PKT_NSAMP", "%d", &header->pkt_nsamp) < 0)  {
+    fprintf(stderr, "READ_DADA_HEADER_ERROR: Error getting PKT_NSAMP, "
             "which happens at %s, line [%d].\n",
             __FILE__, __LINE__);
     exit(EXIT_FAILURE);
   }
 
-  if (ascii_header_get(dada_header_buffer, "NCHAN_FINE", "%d", &dada_header->nchan_fine) < 0)  {
-    fprintf(stderr, "WRITE_DADA_HEADER_ERROR: Error getting NCHAN_FINE, "
+  if (ascii_header_get(buffer, "NCHAN_FINE", "%d", &header->nchan_fine) < 0)  {
+    fprintf(stderr, "READ_DADA_HEADER_ERROR: Error getting NCHAN_FINE, "
             "which happens at %s, line [%d].\n",
             __FILE__, __LINE__);
     exit(EXIT_FAILURE);
   }
 
-  if (ascii_header_get(dada_header_buffer, "NAVERAGE", "%d", &dada_header->naverage) < 0)  {
-    fprintf(stderr, "WRITE_DADA_HEADER_ERROR: Error getting NAVERAGE, "
+  if (ascii_header_get(buffer, "NAVERAGE", "%d", &header->naverage) < 0)  {
+    fprintf(stderr, "READ_DADA_HEADER_ERROR: Error getting NAVERAGE, "
             "which happens at %s, line [%d].\n",
             __FILE__, __LINE__);
     exit(EXIT_FAILURE);
   }
 
-  if (ascii_header_get(dada_header_buffer, "PKT_TSAMP", "%lf", &dada_header->pkt_tsamp) < 0)  {
-    fprintf(stderr, "WRITE_DADA_HEADER_ERROR: Error getting PKT_TSAMP, "
+  if (ascii_header_get(buffer, "PKT_TSAMP", "%lf", &header->pkt_tsamp) < 0)  {
+    fprintf(stderr, "READ_DADA_HEADER_ERROR: Error getting PKT_TSAMP, "
             "which happens at %s, line [%d].\n",
             __FILE__, __LINE__);
     exit(EXIT_FAILURE);
   }
 
-  if (ascii_header_get(dada_header_buffer, "NPOL", "%d", &dada_header->npol) < 0)  {
-    fprintf(stderr, "WRITE_DADA_HEADER_ERROR: Error getting NPOL, "
+  if (ascii_header_get(buffer, "NPOL", "%d", &header->npol) < 0)  {
+    fprintf(stderr, "READ_DADA_HEADER_ERROR: Error getting NPOL, "
             "which happens at %s, line [%d].\n",
             __FILE__, __LINE__);
     exit(EXIT_FAILURE);
   }
 
-  if (ascii_header_get(dada_header_buffer, "NANT", "%d", &dada_header->nant) < 0)  {
-    fprintf(stderr, "WRITE_DADA_HEADER_ERROR: Error getting NANT, "
+  if (ascii_header_get(buffer, "NANT", "%d", &header->nant) < 0)  {
+    fprintf(stderr, "READ_DADA_HEADER_ERROR: Error getting NANT, "
             "which happens at %s, line [%d].\n",
             __FILE__, __LINE__);
     exit(EXIT_FAILURE);
   }
 
-  if (ascii_header_get(dada_header_buffer, "NBIT", "%d", &dada_header->nbit) < 0)  {
-    fprintf(stderr, "WRITE_DADA_HEADER_ERROR: Error getting NBIT, "
+  if (ascii_header_get(buffer, "NBIT", "%d", &header->nbit) < 0)  {
+    fprintf(stderr, "READ_DADA_HEADER_ERROR: Error getting NBIT, "
             "which happens at %s, line [%d].\n",
             __FILE__, __LINE__);
     exit(EXIT_FAILURE);
   }
 
-  if (ascii_header_get(dada_header_buffer, "TOTALSAMPLES", "%" PRIu64 "", &dada_header->totalsamples) < 0)  {
-    fprintf(stderr, "WRITE_DADA_HEADER_ERROR: Error getting TOTALSAMPLES, "
+  if (ascii_header_get(buffer, "TOTALSAMPLES", "%" PRIu64 "", &header->totalsamples) < 0)  {
+    fprintf(stderr, "READ_DADA_HEADER_ERROR: Error getting TOTALSAMPLES, "
             "which happens at %s, line [%d].\n",
             __FILE__, __LINE__);
     exit(EXIT_FAILURE);
   }
 
-  if (ascii_header_get(dada_header_buffer, "PERIOD", "%lf", &dada_header->period) < 0)  {
-    fprintf(stderr, "WRITE_DADA_HEADER_ERROR: Error getting PERIOD, "
+  if (ascii_header_get(buffer, "PERIOD", "%lf", &header->period) < 0)  {
+    fprintf(stderr, "READ_DADA_HEADER_ERROR: Error getting PERIOD, "
             "which happens at %s, line [%d].\n",
             __FILE__, __LINE__);
     exit(EXIT_FAILURE);
@@ -136,124 +382,560 @@ int read_dada_header(const char *dada_header_buffer, dada_header_t *dada_header)
   return EXIT_SUCCESS;
 }
 
-int write_dada_header_to_file(const dada_header_t dada_header, const char *dada_header_file_name){
+static int dada_header_format_uint64(char *value, uint64_t number){
+  char digits[20];
+  int length = 0;
+  do {
+    digits[length++] = '0' + number%10;
+    number /= 10;
+  } while (number);
+
+  for (int i = 0; i < length; i++) value[i] = digits[length - 1 - i];
+  value[length] = '\0';
+  return length;
+}
+
+static int dada_header_format_int64(char *value, int64_t number){
+  if (number < 0) {
+    value[0] = '-';
+    return 1 + dada_header_format_uint64(value + 1, -(uint64_t)number);
+  }
+  return dada_header_format_uint64(value, number);
+}
+
+static const double dada_header_pow10[] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16,
+};
+
+// Shortest decimal which reads back to the same double
+int format_dada_header_double(char *value, double number){
+
+  // Fast path, the first k with number == m/10^k, m = llround(number*10^k) below 2^53,
+  // m and 10^k are exact and the division rounds like strtod, the product itself may round
+  for (int k = 0; k <= 16; k++) {
+    double scaled = number*dada_header_pow10[k];
+    if (!(scaled > -9007199254740992.0 && scaled < 9007199254740992.0)) break;
+    int64_t mantissa = llround(scaled);
+    if ((double)mantissa/dada_header_pow10[k] != number) continue;
+    if (mantissa == 0) break;
+
+    char digits[24];
+    int negative = mantissa < 0;
+    int length = dada_header_format_uint64(digits, negative ? -(uint64_t)mantissa : (uint64_t)mantissa);
+    char *p = value;
+    if (negative) *p++ = '-';
+    if (length <= k) {
+      *p++ = '0';
+      *p++ = '.';
+      for (int i = length; i < k; i++) *p++ = '0';
+      memcpy(p, digits, length);
+      p += length;
+    }
+    else {
+      memcpy(p, digits, length - k);
+      p += length - k;
+      if (k) {
+        *p++ = '.';
+        memcpy(p, digits + length - k, k);
+        p += k;
+      }
+    }
+    *p = '\0';
+    return p - value;
+  }
+
+  // Zero, very large, very small or long numbers, the first precision which reads back wins
+  int length = 0;
+  for (int precision = 15; precision <= 17; precision++) {
+    length = snprintf(value, DADA_HEADER_DOUBLE_WIDTH + 1, "%.*g", precision, number);
+    if (strtod(value, NULL) == number) break;
+  }
+  return length;
+}
+
+int serialize_dada_header(const dada_header_t *header, char *buffer, int size, dada_header_offsets_t *offsets){
+
+  char value[DADA_STRLEN];
+  char *p = buffer;
+  char *end = buffer + size;
+  int length, width;
+
+  // TSAMP
+  length = format_dada_header_double(value, header->tsamp);
+  width  = DADA_HEADER_DOUBLE_WIDTH;
+  if (end - p < DADA_HEADER_KEY_WIDTH + width + 2) return -1;
+  memcpy(p, "TSAMP               ", DADA_HEADER_KEY_WIDTH);
+  p += 20;
+  memset(p, ' ', width - length);
+  memcpy(p + width - length, value, length);
+  if (offsets) {
+    offsets->offset[DADA_HEADER_TSAMP] = p - buffer;
+    offsets->width[DADA_HEADER_TSAMP]  = width;
+  }
+  p += width;
+  *p++ = '\n';
+
+  // MJD_START
+  length = format_dada_header_double(value, header->mjd_start);
+  width  = DADA_HEADER_DOUBLE_WIDTH;
+  if (end - p < DADA_HEADER_KEY_WIDTH + width + 2) return -1;
+  memcpy(p, "MJD_START           ", DADA_HEADER_KEY_WIDTH);
+  p += 20;
+  memset(p, ' ', width - length);
+  memcpy(p + width - length, value, length);
+  if (offsets) {
+    offsets->offset[DADA_HEADER_MJD_START] = p - buffer;
+    offsets->width[DADA_HEADER_MJD_START]  = width;
+  }
+  p += width;
+  *p++ = '\n';
+
+  // BW
+  length = format_dada_header_double(value, header->bw);
+  width  = DADA_HEADER_DOUBLE_WIDTH;
+  if (end - p < DADA_HEADER_KEY_WIDTH + width + 2) return -1;
+  memcpy(p, "BW                  ", DADA_HEADER_KEY_WIDTH);
+  p += 20;
+  memset(p, ' ', width - length);
+  memcpy(p + width - length, value, length);
+  if (offsets) {
+    offsets->offset[DADA_HEADER_BW] = p - buffer;
+    offsets->width[DADA_HEADER_BW]  = width;
+  }
+  p += width;
+  *p++ = '\n';
+
+  // UTC_START
+  length = strnlen(header->utc_start, DADA_STRLEN - 1);
+  width  = length;
+  if (end - p < DADA_HEADER_KEY_WIDTH + width + 2) return -1;
+  memcpy(p, "UTC_START           ", DADA_HEADER_KEY_WIDTH);
+  p += 20;
+  memcpy(p, header->utc_start, length);
+  if (offsets) {
+    offsets->offset[DADA_HEADER_UTC_START] = p - buffer;
+    offsets->width[DADA_HEADER_UTC_START]  = width;
+  }
+  p += width;
+  *p++ = '\n';
+
+  // NCHAN
+  length = dada_header_format_int64(value, header->nchan);
+  width  = DADA_HEADER_INT_WIDTH;
+  if (end - p < DADA_HEADER_KEY_WIDTH + width + 2) return -1;
+  memcpy(p, "NCHAN               ", DADA_HEADER_KEY_WIDTH);
+  p += 20;
+  memset(p, ' ', width - length);
+  memcpy(p + width - length, value, length);
+  if (offsets) {
+    offsets->offset[DADA_HEADER_NCHAN] = p - buffer;
+    offsets->width[DADA_HEADER_NCHAN]  = width;
+  }
+  p += width;
+  *p++ = '\n';
+
+  // NPKT
+  length = dada_header_format_int64(value, header->npkt);
+  width  = DADA_HEADER_INT_WIDTH;
+  if (end - p < DADA_HEADER_KEY_WIDTH + width + 2) return -1;
+  memcpy(p, "NPKT                ", DADA_HEADER_KEY_WIDTH);
+  p += 20;
+  memset(p, ' ', width - length);
+  memcpy(p + width - length, value, length);
+  if (offsets) {
+    offsets->offset[DADA_HEADER_NPKT] = p - buffer;
+    offsets->width[DADA_HEADER_NPKT]  = width;
+  }
+  p += width;
+  *p++ = '\n';
+
+  // PKT_NSAMP
+  length = dada_header_format_int64(value, header->pkt_nsamp);
+  width  = DADA_HEADER_INT_WIDTH;
+  if (end - p < DADA_HEADER_KEY_WIDTH + width + 2) return -1;
+  memcpy(p, "PKT_NSAMP           ", DADA_HEADER_KEY_WIDTH);
+  p += 20;
+  memset(p, ' ', width - length);
+  memcpy(p + width - length, value, length);
+  if (offsets) {
+    offsets->offset[DADA_HEADER_PKT_NSAMP] = p - buffer;
+    offsets->width[DADA_HEADER_PKT_NSAMP]  = width;
+  }
+  p += width;
+  *p++ = '\n';
+
+  // NCHAN_FINE
+  length = dada_header_format_int64(value, header->nchan_fine);
+  width  = DADA_HEADER_INT_WIDTH;
+  if (end - p < DADA_HEADER_KEY_WIDTH + width + 2) return -1;
+  memcpy(p, "NCHAN_FINE          ", DADA_HEADER_KEY_WIDTH);
+  p += 20;
+  memset(p, ' ', width - length);
+  memcpy(p + width - length, value, length);
+  if (offsets) {
+    offsets->offset[DADA_HEADER_NCHAN_FINE] = p - buffer;
+    offsets->width[DADA_HEADER_NCHAN_FINE]  = width;
+  }
+  p += width;
+  *p++ = '\n';
+
+  // NAVERAGE
+  length = dada_header_format_int64(value, header->naverage);
+  width  = DADA_HEADER_INT_WIDTH;
+  if (end - p < DADA_HEADER_KEY_WIDTH + width + 2) return -1;
+  memcpy(p, "NAVERAGE            ", DADA_HEADER_KEY_WIDTH);
+  p += 20;
+  memset(p, ' ', width - length);
+  memcpy(p + width - length, value, length);
+  if (offsets) {
+    offsets->offset[DADA_HEADER_NAVERAGE] = p - buffer;
+    offsets->width[DADA_HEADER_NAVERAGE]  = width;
+  }
+  p += width;
+  *p++ = '\n';
+
+  // PKT_TSAMP
+  length = format_dada_header_double(value, header->pkt_tsamp);
+  width  = DADA_HEADER_DOUBLE_WIDTH;
+  if (end - p < DADA_HEADER_KEY_WIDTH + width + 2) return -1;
+  memcpy(p, "PKT_TSAMP           ", DADA_HEADER_KEY_WIDTH);
+  p += 20;
+  memset(p, ' ', width - length);
+  memcpy(p + width - length, value, length);
+  if (offsets) {
+    offsets->offset[DADA_HEADER_PKT_TSAMP] = p - buffer;
+    offsets->width[DADA_HEADER_PKT_TSAMP]  = width;
+  }
+  p += width;
+  *p++ = '\n';
+
+  // NPOL
+  length = dada_header_format_int64(value, header->npol);
+  width  = DADA_HEADER_INT_WIDTH;
+  if (end - p < DADA_HEADER_KEY_WIDTH + width + 2) return -1;
+  memcpy(p, "NPOL                ", DADA_HEADER_KEY_WIDTH);
+  p += 20;
+  memset(p, ' ', width - length);
+  memcpy(p + width - length, value, length);
+  if (offsets) {
+    offsets->offset[DADA_HEADER_NPOL] = p - buffer;
+    offsets->width[DADA_HEADER_NPOL]  = width;
+  }
+  p += width;
+  *p++ = '\n';
+
+  // NANT
+  length = dada_header_format_int64(value, header->nant);
+  width  = DADA_HEADER_INT_WIDTH;
+  if (end - p < DADA_HEADER_KEY_WIDTH + width + 2) return -1;
+  memcpy(p, "NANT                ", DADA_HEADER_KEY_WIDTH);
+  p += 20;
+  memset(p, ' ', width - length);
+  memcpy(p + width - length, value, length);
+  if (offsets) {
+    offsets->offset[DADA_HEADER_NANT] = p - buffer;
+    offsets->width[DADA_HEADER_NANT]  = width;
+  }
+  p += width;
+  *p++ = '\n';
+
+  // NBIT
+  length = dada_header_format_int64(value, header->nbit);
+  width  = DADA_HEADER_INT_WIDTH;
+  if (end - p < DADA_HEADER_KEY_WIDTH + width + 2) return -1;
+  memcpy(p, "NBIT                ", DADA_HEADER_KEY_WIDTH);
+  p += 20;
+  memset(p, ' ', width - length);
+  memcpy(p + width - length, value, length);
+  if (offsets) {
+    offsets->offset[DADA_HEADER_NBIT] = p - buffer;
+    offsets->width[DADA_HEADER_NBIT]  = width;
+  }
+  p += width;
+  *p++ = '\n';
+
+  // TOTALSAMPLES
+  length = dada_header_format_uint64(value, header->totalsamples);
+  width  = DADA_HEADER_UINT64_WIDTH;
+  if (end - p < DADA_HEADER_KEY_WIDTH + width + 2) return -1;
+  memcpy(p, "TOTALSAMPLES        ", DADA_HEADER_KEY_WIDTH);
+  p += 20;
+  memset(p, ' ', width - length);
+  memcpy(p + width - length, value, length);
+  if (offsets) {
+    offsets->offset[DADA_HEADER_TOTALSAMPLES] = p - buffer;
+    offsets->width[DADA_HEADER_TOTALSAMPLES]  = width;
+  }
+  p += width;
+  *p++ = '\n';
+
+  // PERIOD
+  length = format_dada_header_double(value, header->period);
+  width  = DADA_HEADER_DOUBLE_WIDTH;
+  if (end - p < DADA_HEADER_KEY_WIDTH + width + 2) return -1;
+  memcpy(p, "PERIOD              ", DADA_HEADER_KEY_WIDTH);
+  p += 20;
+  memset(p, ' ', width - length);
+  memcpy(p + width - length, value, length);
+  if (offsets) {
+    offsets->offset[DADA_HEADER_PERIOD] = p - buffer;
+    offsets->width[DADA_HEADER_PERIOD]  = width;
+  }
+  p += width;
+  *p++ = '\n';
+
+  *p = '\0';
+  return p - buffer;
+}
+
+int update_dada_header_int(char *buffer, const dada_header_offsets_t *offsets, int key, int value){
+
+  char digits[DADA_HEADER_INT_WIDTH + 1];
+  int length = dada_header_format_int64(digits, value);
+  if (key < 0 || key >= DADA_HEADER_NKEY || length > offsets->width[key])
+    return EXIT_FAILURE;
+
+  char *p = buffer + offsets->offset[key];
+  memset(p, ' ', offsets->width[key] - length);
+  memcpy(p + offsets->width[key] - length, digits, length);
+
+  return EXIT_SUCCESS;
+}
+
+int update_dada_header_uint64(char *buffer, const dada_header_offsets_t *offsets, int key, uint64_t value){
+
+  char digits[DADA_HEADER_UINT64_WIDTH + 1];
+  int length = dada_header_format_uint64(digits, value);
+  if (key < 0 || key >= DADA_HEADER_NKEY || length > offsets->width[key])
+    return EXIT_FAILURE;
+
+  char *p = buffer + offsets->offset[key];
+  memset(p, ' ', offsets->width[key] - length);
+  memcpy(p + offsets->width[key] - length, digits, length);
+
+  return EXIT_SUCCESS;
+}
+
+int update_dada_header_double(char *buffer, const dada_header_offsets_t *offsets, int key, double value){
+
+  char digits[DADA_HEADER_DOUBLE_WIDTH + 1];
+  int length = format_dada_header_double(digits, value);
+  if (key < 0 || key >= DADA_HEADER_NKEY || length > offsets->width[key])
+    return EXIT_FAILURE;
+
+  char *p = buffer + offsets->offset[key];
+  memset(p, ' ', offsets->width[key] - length);
+  memcpy(p + offsets->width[key] - length, digits, length);
+
+  return EXIT_SUCCESS;
+}
+
+int update_dada_header_string(char *buffer, const dada_header_offsets_t *offsets, int key, const char *value){
 
-  FILE *fp = fopen(dada_header_file_name, "w");
-  char *dada_header_buffer = (char *)malloc(DADA_DEFAULT_HEADER_SIZE);
-  memset(dada_header_buffer, 0, DADA_DEFAULT_HEADER_SIZE);
+  int length = strlen(value);
+  if (key < 0 || key >= DADA_HEADER_NKEY || length == 0 || length > offsets->width[key])
+    return EXIT_FAILURE;
 
-  sprintf(dada_header_buffer, "HDR_VERSION  1.0\nHDR_SIZE     4096\n");
-  write_dada_header(dada_header, dada_header_buffer);
-  fprintf(fp, "%s\n", dada_header_buffer);
+  // Shorter strings are padded with trailing spaces, readers take the first word
+  char *p = buffer + offsets->offset[key];
+  memcpy(p, value, length);
+  memset(p + length, ' ', offsets->width[key] - length);
 
-  free(dada_header_buffer);
+  return EXIT_SUCCESS;
+}
+
+static uint64_t dada_header_text_hash(const char *text, uint64_t length){
+
+  // Eight bytes per step, it has to be much cheaper than parsing the text
+  uint64_t hash = UINT64_C(0xcbf29ce484222325) ^ length;
+  uint64_t i = 0;
+  for (; i + 8 <= length; i += 8) {
+    uint64_t word;
+    memcpy(&word, text + i, 8);
+    hash = (hash ^ word)*UINT64_C(0x100000001b3);
+    hash ^= hash >> 29;
+  }
+  for (; i < length; i++) hash = (hash ^ (unsigned char)text[i])*UINT64_C(0x100000001b3);
+
+  return hash;
+}
+
+static int dada_header_binary_offset(int size){
+  return (size - (int)sizeof(dada_header_binary_t)) & ~7;
+}
+
+int write_dada_header_binary(const dada_header_t *header, char *buffer, int size){
+
+  int offset = dada_header_binary_offset(size);
+  if (offset < 0) return EXIT_FAILURE;
+
+  uint64_t length = strnlen(buffer, size);
+  if ((int)length >= offset) return EXIT_FAILURE;
+
+  dada_header_binary_t *binary = (dada_header_binary_t *)(buffer + offset);
+  binary->magic       = DADA_HEADER_BINARY_MAGIC;
+  binary->version     = DADA_HEADER_BINARY_VERSION;
+  binary->schema_hash = DADA_HEADER_SCHEMA_HASH;
+  binary->size        = sizeof(dada_header_t);
+  binary->text_length = length;
+  binary->text_hash   = dada_header_text_hash(buffer, length);
+  memcpy(&binary->header, header, sizeof(dada_header_t));
+
+  return EXIT_SUCCESS;
+}
+
+const dada_header_binary_t *find_dada_header_binary(const char *buffer, int size){
+
+  int offset = dada_header_binary_offset(size);
+  if (offset < 0) return NULL;
+
+  const dada_header_binary_t *binary = (const dada_header_binary_t *)(buffer + offset);
+  if (binary->magic != DADA_HEADER_BINARY_MAGIC || binary->version != DADA_HEADER_BINARY_VERSION ||
+      binary->schema_hash != DADA_HEADER_SCHEMA_HASH || binary->size != sizeof(dada_header_t) ||
+      binary->text_length >= (uint64_t)offset || buffer[binary->text_length] != '\0' ||
+      binary->text_hash != dada_header_text_hash(buffer, binary->text_length))
+    return NULL;
+
+  return binary;
+}
+
+uint64_t load_dada_header(const char *buffer, int size, dada_header_t *header){
+
+  const dada_header_binary_t *binary = find_dada_header_binary(buffer, size);
+  if (binary) {
+    memcpy(header, &binary->header, sizeof(dada_header_t));
+    return 0;
+  }
+
+  return parse_dada_header(buffer, header);
+}
+
+int write_dada_header_to_file(const dada_header_t header, const char *fname){
+
+  FILE *fp = fopen(fname, "w");
+  char *buffer = (char *)malloc(DADA_DEFAULT_HEADER_SIZE);
+  memset(buffer, 0, DADA_DEFAULT_HEADER_SIZE);
+
+  int length = sprintf(buffer, "HDR_VERSION  1.0\nHDR_SIZE     4096\n");
+  serialize_dada_header(&header, buffer + length, DADA_DEFAULT_HEADER_SIZE - length, NULL);
+  write_dada_header_binary(&header, buffer, DADA_DEFAULT_HEADER_SIZE);
+  fwrite(buffer, 1, DADA_DEFAULT_HEADER_SIZE, fp);
+
+  free(buffer);
   fclose(fp);
 
   return EXIT_SUCCESS;
 }
 
-int write_dada_header(const dada_header_t dada_header, char *dada_header_buffer){
+int write_dada_header(const dada_header_t header, char *buffer){
+
+  char value[DADA_HEADER_DOUBLE_WIDTH + 1];
 
-  if (ascii_header_set(dada_header_buffer, "TSAMP", "%f", dada_header.tsamp) < 0)  {
-    fprintf(stderr, "READ_DADA_HEADER_ERROR: Error setting TSAMP, "
+  format_dada_header_double(value, header.tsamp);
+  if (ascii_header_set(buffer, "TSAMP", "%s", value) < 0)  {
+    fprintf(stderr, "WRITE_DADA_HEADER_ERROR: Error setting TSAMP, "
             "which happens at %s, line [%d].\n",
             __FILE__, __LINE__);
     exit(EXIT_FAILURE);
   }
 
-  if (ascii_header_set(dada_header_buffer, "MJD_START", "%f", dada_header.mjd_start) < 0)  {
-    fprintf(stderr, "READ_DADA_HEADER_ERROR: Error setting MJD_START, "
+  format_dada_header_double(value, header.mjd_start);
+  if (ascii_header_set(buffer, "MJD_START", "%s", value) < 0)  {
+    fprintf(stderr, "WRITE_DADA_HEADER_ERROR: Error setting MJD_START, "
             "which happens at %s, line [%d].\n",
             __FILE__, __LINE__);
     exit(EXIT_FAILURE);
   }
 
-  if (ascii_header_set(dada_header_buffer, "BW", "%f", dada_header.bw) < 0)  {
-    fprintf(stderr, "READ_DADA_HEADER_ERROR: Error setting BW, "
+  format_dada_header_double(value, header.bw);
+  if (ascii_header_set(buffer, "BW", "%s", value) < 0)  {
+    fprintf(stderr, "WRITE_DADA_HEADER_ERROR: Error setting BW, "
             "which happens at %s, line [%d].\n",
             __FILE__, __LINE__);
     exit(EXIT_FAILURE);
   }
 
-  if (ascii_header_set(dada_header_buffer, "UTC_START", "%s", dada_header.utc_start) < 0)  {
-    fprintf(stderr, "READ_DADA_HEADER_ERROR: Error setting UTC_START, "
+  if (ascii_header_set(buffer, "UTC_START", "%s", header.utc_start) < 0)  {
+    fprintf(stderr, "WRITE_DADA_HEADER_ERROR: Error setting UTC_START, "
             "which happens at %s, line [%d].\n",
             __FILE__, __LINE__);
     exit(EXIT_FAILURE);
   }
 
-  if (ascii_header_set(dada_header_buffer, "NCHAN", "%d", dada_header.nchan) < 0)  {
-    fprintf(stderr, "READ_DADA_HEADER_ERROR: Error setting NCHAN, "
+  if (ascii_header_set(buffer, "NCHAN", "%d", header.nchan) < 0)  {
+    fprintf(stderr, "WRITE_DADA_HEADER_ERROR: Error setting NCHAN, "
             "which happens at %s, line [%d].\n",
             __FILE__, __LINE__);
     exit(EXIT_FAILURE);
   }
 
-  if (ascii_header_set(dada_header_buffer, "NPKT", "%d", dada_header.npkt) < 0)  {
-    fprintf(stderr, "READ_DADA_HEADER_ERROR: Error setting NPKT, "
+  if (ascii_header_set(buffer, "NPKT", "%d", header.npkt) < 0)  {
+    fprintf(stderr, "WRITE_DADA_HEADER_ERROR: Error setting NPKT, "
             "which happens at %s, line [%d].\n",
             __FILE__, __LINE__);
     exit(EXIT_FAILURE);
   }
 
-  if (ascii_header_set(dada_header_buffer, "PKT_NSAMP", "%d", dada_header.pkt_nsamp) < 0)  {
-    fprintf(stderr, "READ_DADA_HEADER_ERROR: Error setting PKT_NSAMP, "
+  if (ascii_header_set(buffer, "PKT_NSAMP", "%d", header.pkt_nsamp) < 0)  {
+    fprintf(stderr, "WRITE_DADA_HEADER_ERROR: Error setting PKT_NSAMP, "
             "which happens at %s, line [%d].\n",
             __FILE__, __LINE__);
     exit(EXIT_FAILURE);
   }
 
-  if (ascii_header_set(dada_header_buffer, "NCHAN_FINE", "%d", dada_header.nchan_fine) < 0)  {
-    fprintf(stderr, "READ_DADA_HEADER_ERROR: Error setting NCHAN_FINE, "
+  if (ascii_header_set(buffer, "NCHAN_FINE", "%d", header.nchan_fine) < 0)  {
+    fprintf(stderr, "WRITE_DADA_HEADER_ERROR: Error setting NCHAN_FINE, "
             "which happens at %s, line [%d].\n",
             __FILE__, __LINE__);
     exit(EXIT_FAILURE);
   }
 
-  if (ascii_header_set(dada_header_buffer, "NAVERAGE", "%d", dada_header.naverage) < 0)  {
-    fprintf(stderr, "READ_DADA_HEADER_ERROR: Error setting NAVERAGE, "
+  if (ascii_header_set(buffer, "NAVERAGE", "%d", header.naverage) < 0)  {
+    fprintf(stderr, "WRITE_DADA_HEADER_ERROR: Error setting NAVERAGE, "
             "which happens at %s, line [%d].\n",
             __FILE__, __LINE__);
     exit(EXIT_FAILURE);
   }
 
-  if (ascii_header_set(dada_header_buffer, "PKT_TSAMP", "%f", dada_header.pkt_tsamp) < 0)  {
-    fprintf(stderr, "READ_DADA_HEADER_ERROR: Error setting PKT_TSAMP, "
+  format_dada_header_double(value, header.pkt_tsamp);
+  if (ascii_header_set(buffer, "PKT_TSAMP", "%s", value) < 0)  {
+    fprintf(stderr, "WRITE_DADA_HEADER_ERROR: Error setting PKT_TSAMP, "
             "which happens at %s, line [%d].\n",
             __FILE__, __LINE__);
     exit(EXIT_FAILURE);
   }
 
-  if (ascii_header_set(dada_header_buffer, "NPOL", "%d", dada_header.npol) < 0)  {
-    fprintf(stderr, "READ_DADA_HEADER_ERROR: Error setting NPOL, "
+  if (ascii_header_set(buffer, "NPOL", "%d", header.npol) < 0)  {
+    fprintf(stderr, "WRITE_DADA_HEADER_ERROR: Error setting NPOL, "
             "which happens at %s, line [%d].\n",
             __FILE__, __LINE__);
     exit(EXIT_FAILURE);
   }
 
-  if (ascii_header_set(dada_header_buffer, "NANT", "%d", dada_header.nant) < 0)  {
-    fprintf(stderr, "READ_DADA_HEADER_ERROR: Error setting NANT, "
+  if (ascii_header_set(buffer, "NANT", "%d", header.nant) < 0)  {
+    fprintf(stderr, "WRITE_DADA_HEADER_ERROR: Error setting NANT, "
             "which happens at %s, line [%d].\n",
             __FILE__, __LINE__);
     exit(EXIT_FAILURE);
   }
 
-  if (ascii_header_set(dada_header_buffer, "NBIT", "%d", dada_header.nbit) < 0)  {
-    fprintf(stderr, "READ_DADA_HEADER_ERROR: Error setting NBIT, "
+  if (ascii_header_set(buffer, "NBIT", "%d", header.nbit) < 0)  {
+    fprintf(stderr, "WRITE_DADA_HEADER_ERROR: Error setting NBIT, "
             "which happens at %s, line [%d].\n",
             __FILE__, __LINE__);
     exit(EXIT_FAILURE);
   }
 
-  if (ascii_header_set(dada_header_buffer, "TOTALSAMPLES", "%" PRIu64 "", dada_header.totalsamples) < 0)  {
-    fprintf(stderr, "READ_DADA_HEADER_ERROR: Error setting TOTALSAMPLES, "
+  if (ascii_header_set(buffer, "TOTALSAMPLES", "%" PRIu64 "", header.totalsamples) < 0)  {
+    fprintf(stderr, "WRITE_DADA_HEADER_ERROR: Error setting TOTALSAMPLES, "
             "which happens at %s, line [%d].\n",
             __FILE__, __LINE__);
     exit(EXIT_FAILURE);
   }
 
-  if (ascii_header_set(dada_header_buffer, "PERIOD", "%f", dada_header.period) < 0)  {
-    fprintf(stderr, "READ_DADA_HEADER_ERROR: Error setting PERIOD, "
+  format_dada_header_double(value, header.period);
+  if (ascii_header_set(buffer, "PERIOD", "%s", value) < 0)  {
+    fprintf(stderr, "WRITE_DADA_HEADER_ERROR: Error setting PERIOD, "
             "which happens at %s, line [%d].\n",
             __FILE__, __LINE__);
     exit(EXIT_FAILURE);
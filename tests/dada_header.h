@@ -27,13 +27,109 @@ extern "C" {
     double period;
   }dada_header_t;
 
-  int read_dada_header(const char *dada_header_buffer, dada_header_t *dada_header);
+#define DADA_HEADER_NKEY 15
+#define DADA_HEADER_BIT(key) ((uint64_t)1 << (key))
+#define DADA_HEADER_ALL  UINT64_C(0x7fff)
 
-  int write_dada_header(const dada_header_t dada_header, char *dada_header_buffer);
+  enum dada_header_key{
+    DADA_HEADER_TSAMP = 0,
+    DADA_HEADER_MJD_START = 1,
+    DADA_HEADER_BW = 2,
+    DADA_HEADER_UTC_START = 3,
+    DADA_HEADER_NCHAN = 4,
+    DADA_HEADER_NPKT = 5,
+    DADA_HEADER_PKT_NSAMP = 6,
+    DADA_HEADER_NCHAN_FINE = 7,
+    DADA_HEADER_NAVERAGE = 8,
+    DADA_HEADER_PKT_TSAMP = 9,
+    DADA_HEADER_NPOL = 10,
+    DADA_HEADER_NANT = 11,
+    DADA_HEADER_NBIT = 12,
+    DADA_HEADER_TOTALSAMPLES = 13,
+    DADA_HEADER_PERIOD = 14,
+  };
 
-  int read_dada_header_from_file(const char *dada_header_file_name, dada_header_t *dada_header);
+  typedef struct dada_header_span_t{
+    const char *value; // value in the buffer, not NUL terminated
+    int length;        // without trailing spaces and comment
+  }dada_header_span_t;
 
-  int write_dada_header_to_file(const dada_header_t dada_header,const char *dada_header_file_name);
+  typedef struct dada_header_index_t{
+    dada_header_span_t span[DADA_HEADER_NKEY];
+    uint64_t found; // DADA_HEADER_BIT of keys in the buffer
+  }dada_header_index_t;
+
+#define DADA_HEADER_HASH_SIZE 64
+
+  int dada_header_key_index(const char *key);
+
+  void index_dada_header(const char *buffer, dada_header_index_t *index);
+
+  int get_dada_header_span(const dada_header_index_t *index, const char *key, dada_header_span_t *span);
+
+  int get_dada_header_int(const dada_header_index_t *index, const char *key, int *value);
+
+  int get_dada_header_uint64(const dada_header_index_t *index, const char *key, uint64_t *value);
+
+  int get_dada_header_double(const dada_header_index_t *index, const char *key, double *value);
+
+  int get_dada_header_string(const dada_header_index_t *index, const char *key, char *value);
+
+  uint64_t parse_dada_header(const char *buffer, dada_header_t *header);
+
+  int read_dada_header(const char *buffer, dada_header_t *header);
+
+  int read_dada_header_ascii(const char *buffer, dada_header_t *header);
+
+  int write_dada_header(const dada_header_t header, char *buffer);
+
+#define DADA_HEADER_KEY_WIDTH    20
+#define DADA_HEADER_INT_WIDTH    11
+#define DADA_HEADER_UINT64_WIDTH 20
+#define DADA_HEADER_DOUBLE_WIDTH 24
+#define DADA_HEADER_FLOAT_WIDTH  16
+
+  typedef struct dada_header_offsets_t{
+    int offset[DADA_HEADER_NKEY]; // value offset from the start of the buffer
+    int width[DADA_HEADER_NKEY];  // value field width
+  }dada_header_offsets_t;
+
+  int format_dada_header_double(char *value, double number);
+
+  int serialize_dada_header(const dada_header_t *header, char *buffer, int size, dada_header_offsets_t *offsets);
+
+  int update_dada_header_int(char *buffer, const dada_header_offsets_t *offsets, int key, int value);
+
+  int update_dada_header_uint64(char *buffer, const dada_header_offsets_t *offsets, int key, uint64_t value);
+
+  int update_dada_header_double(char *buffer, const dada_header_offsets_t *offsets, int key, double value);
+
+  int update_dada_header_string(char *buffer, const dada_header_offsets_t *offsets, int key, const char *value);
+
+#define DADA_HEADER_BINARY_MAGIC   0x48424444 // DDBH
+#define DADA_HEADER_BINARY_VERSION 1
+#define DADA_HEADER_SCHEMA_HASH    UINT64_C(0x28488c584fa0d338)
+
+  // Binary copy of dada_header_t at the end of the header block, after the NUL of the ASCII header
+  typedef struct dada_header_binary_t{
+    uint32_t magic;       // DADA_HEADER_BINARY_MAGIC
+    uint32_t version;     // DADA_HEADER_BINARY_VERSION
+    uint64_t schema_hash; // DADA_HEADER_SCHEMA_HASH of the writer
+    uint64_t size;        // sizeof(dada_header_t) of the writer
+    uint64_t text_length; // strlen of the ASCII header it was written with
+    uint64_t text_hash;   // hash of the ASCII header, an edit of the text invalidates the copy
+    dada_header_t header;
+  }dada_header_binary_t;
+
+  int write_dada_header_binary(const dada_header_t *header, char *buffer, int size);
+
+  const dada_header_binary_t *find_dada_header_binary(const char *buffer, int size);
+
+  uint64_t load_dada_header(const char *buffer, int size, dada_header_t *header);
+
+  int read_dada_header_from_file(const char *fname, dada_header_t *header);
+
+  int write_dada_header_to_file(const dada_header_t header,const char *fname);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,121 @@
+#ifndef __DADA_HEADER_HPP
+#define __DADA_HEADER_HPP
+
+// Requires C++17, it uses inline constexpr, if constexpr, fold expressions and std::apply
+#if __cplusplus < 201703L
+#error "The DADA header reflection requires C++17"
+#endif
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+
+#include "dada_header.h"
+
+namespace dada_header {
+
+  enum class field_type {INT, UINT64, DOUBLE, FLOAT, STRING};
+
+  template <typename T> struct field_type_of;
+  template <> struct field_type_of<int>      {static constexpr field_type value = field_type::INT;};
+  template <> struct field_type_of<uint64_t> {static constexpr field_type value = field_type::UINT64;};
+  template <> struct field_type_of<double>   {static constexpr field_type value = field_type::DOUBLE;};
+  template <> struct field_type_of<float>    {static constexpr field_type value = field_type::FLOAT;};
+  template <> struct field_type_of<char[DADA_STRLEN]> {static constexpr field_type value = field_type::STRING;};
+
+  /// One member of dada_header_t, T is char[DADA_STRLEN] for strings
+  template <typename T>
+  struct field{
+    using type = T;
+    static constexpr field_type kind = field_type_of<T>::value;
+
+    const char *name;              ///< Key in the ASCII header
+    T dada_header_t::*member;      ///< Member pointer
+    std::size_t offset;            ///< Offset in dada_header_t
+    enum dada_header_key key;      ///< Bit in the missing key mask
+  };
+
+  /// Fields in declaration order, index is enum dada_header_key
+  inline constexpr auto fields = std::make_tuple(
+    field<double>{"TSAMP", &dada_header_t::tsamp, offsetof(dada_header_t, tsamp), DADA_HEADER_TSAMP},
+    field<double>{"MJD_START", &dada_header_t::mjd_start, offsetof(dada_header_t, mjd_start), DADA_HEADER_MJD_START},
+    field<double>{"BW", &dada_header_t::bw, offsetof(dada_header_t, bw), DADA_HEADER_BW},
+    field<char[DADA_STRLEN]>{"UTC_START", &dada_header_t::utc_start, offsetof(dada_header_t, utc_start), DADA_HEADER_UTC_START},
+    field<int>{"NCHAN", &dada_header_t::nchan, offsetof(dada_header_t, nchan), DADA_HEADER_NCHAN},
+    field<int>{"NPKT", &dada_header_t::npkt, offsetof(dada_header_t, npkt), DADA_HEADER_NPKT},
+    field<int>{"PKT_NSAMP", &dada_header_t::pkt_nsamp, offsetof(dada_header_t, pkt_nsamp), DADA_HEADER_PKT_NSAMP},
+    field<int>{"NCHAN_FINE", &dada_header_t::nchan_fine, offsetof(dada_header_t, nchan_fine), DADA_HEADER_NCHAN_FINE},
+    field<int>{"NAVERAGE", &dada_header_t::naverage, offsetof(dada_header_t, naverage), DADA_HEADER_NAVERAGE},
+    field<double>{"PKT_TSAMP", &dada_header_t::pkt_tsamp, offsetof(dada_header_t, pkt_tsamp), DADA_HEADER_PKT_TSAMP},
+    field<int>{"NPOL", &dada_header_t::npol, offsetof(dada_header_t, npol), DADA_HEADER_NPOL},
+    field<int>{"NANT", &dada_header_t::nant, offsetof(dada_header_t, nant), DADA_HEADER_NANT},
+    field<int>{"NBIT", &dada_header_t::nbit, offsetof(dada_header_t, nbit), DADA_HEADER_NBIT},
+    field<uint64_t>{"TOTALSAMPLES", &dada_header_t::totalsamples, offsetof(dada_header_t, totalsamples), DADA_HEADER_TOTALSAMPLES},
+    field<double>{"PERIOD", &dada_header_t::period, offsetof(dada_header_t, period), DADA_HEADER_PERIOD}
+  );
+
+  inline constexpr std::size_t nfield = std::tuple_size_v<std::decay_t<decltype(fields)>>;
+  static_assert(nfield == DADA_HEADER_NKEY, "field table and key enum disagree");
+
+  /// Key of a name, -1 if the name is not in the spec, usable in constant expressions
+  constexpr int key_of(std::string_view name){
+    int key = -1;
+    int index = 0;
+    std::apply([&](const auto &...f){((name == f.name ? key = index : 0, index++), ...);}, fields);
+    return key;
+  }
+
+  /// Type of field Key
+  template <int Key>
+  using field_t = typename std::tuple_element_t<Key, std::decay_t<decltype(fields)>>::type;
+
+  /// Member of field Key, for example get<DADA_HEADER_NCHAN>(header) or get<key_of("NCHAN")>(header)
+  template <int Key>
+  constexpr auto &get(dada_header_t &header){
+    return header.*(std::get<Key>(fields).member);
+  }
+
+  template <int Key>
+  constexpr const auto &get(const dada_header_t &header){
+    return header.*(std::get<Key>(fields).member);
+  }
+
+  /// Call visitor(field, member) for every field, the loop unrolls at compile time
+  template <typename Header, typename Visitor>
+  constexpr void for_each_field(Header &header, Visitor &&visitor){
+    static_assert(std::is_same_v<std::remove_const_t<Header>, dada_header_t>, "for_each_field takes dada_header_t");
+    std::apply([&](const auto &...f){(visitor(f, header.*(f.member)), ...);}, fields);
+  }
+
+  /// Call visitor(field) for every field, without a header
+  template <typename Visitor>
+  constexpr void for_each_field(Visitor &&visitor){
+    std::apply([&](const auto &...f){(visitor(f), ...);}, fields);
+  }
+
+  /// Bytes of all members back to back, strings take DADA_STRLEN bytes
+  inline constexpr std::size_t packed_size = std::apply([](const auto &...f){
+      return (sizeof(typename std::decay_t<decltype(f)>::type) + ... + 0);
+    }, fields);
+
+  /// Copy all members back to back into buffer, buffer needs packed_size bytes
+  inline void pack(const dada_header_t &header, char *buffer){
+    for_each_field(header, [&](const auto &, const auto &member){
+	std::memcpy(buffer, &member, sizeof(member));
+	buffer += sizeof(member);
+      });
+  }
+
+  /// Inverse of pack
+  inline void unpack(const char *buffer, dada_header_t &header){
+    for_each_field(header, [&](const auto &, auto &member){
+	std::memcpy(&member, buffer, sizeof(member));
+	buffer += sizeof(member);
+      });
+  }
+}
+
+#endif
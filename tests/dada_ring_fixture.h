@@ -0,0 +1,41 @@
+#ifndef _DADA_RING_FIXTURE_H
+#define _DADA_RING_FIXTURE_H
+
+/*
+  Rings for the tests which need psrdada, created with ipcbuf_create the same way as dada_db,
+  so no dada_db has to run before the tests, include it after doctest
+*/
+
+#include "utils/dada_utils.h"
+
+#include <stdint.h>
+
+#include "doctest/doctest.h"
+
+#define NBUFS   4
+#define BUFSZ   65536
+#define HDRSZ   4096
+#define NBLOCK  10
+#define LASTSZ  1000   // Bytes of the last block, which ends data
+
+/// Header and data rings of one key, the header ring takes key + 1, destroyed with the object
+class Ring{
+public:
+  ipcbuf_t data   = IPCBUF_INIT;
+  ipcbuf_t header = IPCBUF_INIT;
+
+  Ring(key_t key){
+    REQUIRE(ipcbuf_create(&data, key, NBUFS, BUFSZ, 1) == 0);
+    REQUIRE(ipcbuf_create(&header, key + 1, NBUFS, HDRSZ, 1) == 0);
+  }
+
+  ~Ring(){
+    ipcbuf_destroy(&data);
+    ipcbuf_destroy(&header);
+  }
+
+  Ring(const Ring&) = delete;
+  Ring& operator=(const Ring&) = delete;
+};
+
+#endif
@@ -0,0 +1,138 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "utils/dada_filestreamer.h"
+
+#include <stdint.h>
+#include <signal.h>
+#include <sys/socket.h>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest/doctest.h"
+
+using namespace std;
+
+#define HDR_SIZE 8192
+#define NDATA    (8 << 20)
+
+// A DADA file with a HDR_SIZE bytes header and NDATA bytes data
+static vector<char> write_file(const char *fname){
+  vector<char> content(HDR_SIZE + NDATA, 0);
+  snprintf(content.data(), HDR_SIZE, "HDR_VERSION 1.0\nHDR_SIZE %d\nNBIT 8\n", HDR_SIZE);
+  for(int i = 0; i < NDATA; i++){
+    content[HDR_SIZE + i] = (char)(i*13);
+  }
+
+  FILE *fp = fopen(fname, "wb");
+  REQUIRE(fp != NULL);
+  REQUIRE(fwrite(content.data(), 1, content.size(), fp) == content.size());
+  fclose(fp);
+  return content;
+}
+
+// Read from a socket until peer closes or nmax bytes
+static void read_all(int sock, vector<char> &received, size_t nmax){
+  char buf[65536];
+  while(received.size() < nmax){
+    size_t want = nmax - received.size() < sizeof(buf) ? nmax - received.size() : sizeof(buf);
+    ssize_t n = recv(sock, buf, want, 0);
+    if(n <= 0){
+      break;
+    }
+    received.insert(received.end(), buf, buf + n);
+  }
+}
+
+// Temporary DADA file removed at the end of a test
+struct dada_file{
+  char fname[64] = "/tmp/test_dada_filestreamer_XXXXXX";
+  vector<char> content;
+
+  dada_file(){
+    close(mkstemp(fname));
+    content = write_file(fname);
+  }
+  ~dada_file(){
+    unlink(fname);
+  }
+};
+
+TEST_CASE("DadaFileStreamer sends header and data") {
+  dada_file file;
+  vector<char> &content = file.content;
+  DadaFileStreamer streamer(file.fname);
+  CHECK(streamer.hdr_size == HDR_SIZE);
+  CHECK(streamer.file_size == content.size());
+
+  int fds[2];
+  REQUIRE(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+  vector<char> received;
+  thread reader(read_all, fds[1], ref(received), content.size());
+  CHECK(streamer.stream(fds[0]) == EXIT_SUCCESS);
+  reader.join();
+  close(fds[0]);
+  close(fds[1]);
+
+  CHECK(streamer.offset == content.size());
+  CHECK(received == content);
+}
+
+TEST_CASE("DadaFileStreamer sends data only at a rate") {
+  dada_file file;
+  vector<char> &content = file.content;
+  DadaFileStreamer streamer(file.fname);
+
+  int fds[2];
+  REQUIRE(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+  vector<char> received;
+  thread reader(read_all, fds[1], ref(received), (size_t)NDATA);
+
+  // 8 MiB at 0.5 Gbps takes about 134 ms
+  auto start = chrono::steady_clock::now();
+  CHECK(streamer.stream(fds[0], 0.5, streamer.hdr_size) == EXIT_SUCCESS);
+  double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  reader.join();
+  close(fds[0]);
+  close(fds[1]);
+
+  CHECK(elapsed > 0.12);
+  CHECK(elapsed < 0.5);
+  CHECK(received == vector<char>(content.begin() + HDR_SIZE, content.end()));
+}
+
+TEST_CASE("DadaFileStreamer resumes on a new connection") {
+  dada_file file;
+  vector<char> &content = file.content;
+  DadaFileStreamer streamer(file.fname);
+  signal(SIGPIPE, SIG_IGN);
+
+  // The first peer goes away after 1 MiB
+  int fds[2];
+  REQUIRE(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+  vector<char> received;
+  thread reader([&](){
+    read_all(fds[1], received, 1 << 20);
+    close(fds[1]);
+  });
+  CHECK(streamer.stream(fds[0]) == EXIT_FAILURE);
+  reader.join();
+  close(fds[0]);
+
+  // Peer tells where it is, we continue from there
+  uint64_t resume = received.size();
+  CHECK(streamer.offset >= resume);
+
+  REQUIRE(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+  thread reader2(read_all, fds[1], ref(received), content.size());
+  CHECK(streamer.stream(fds[0], 0, resume) == EXIT_SUCCESS);
+  reader2.join();
+  close(fds[0]);
+  close(fds[1]);
+
+  CHECK(received == content);
+}
@@ -0,0 +1,188 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+/*
+  Test of DadaHdu and DadaBlock views, every case gets a fresh ring of dada_ring_fixture.h
+  and reads or writes it through the views only
+*/
+
+#include "utils/dada_hduview.h"
+
+#include <thread>
+#include <utility>
+#include <vector>
+
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest/doctest.h"
+#include "dada_ring_fixture.h"
+
+using namespace std;
+
+#define KEY 0xdae0
+
+static uint64_t stamp(const DadaBlock &block){
+  uint64_t value;
+  memcpy(&value, block.data(), sizeof(value));
+  return value;
+}
+
+// nblock blocks stamped with their sequence, the last one is lastsz bytes and ends data
+static void write_blocks(DadaHdu &hdu, uint64_t nblock, uint64_t lastsz){
+  for(uint64_t i = 0; i < nblock; i++){
+    DadaBlock block = hdu.write();
+    REQUIRE(block);
+    memcpy(block.data(), &i, sizeof(i));
+    if(i == nblock - 1){
+      REQUIRE(block.resize(lastsz) == EXIT_SUCCESS);
+      block.set_eod();
+    }
+  }
+}
+
+TEST_CASE("A peeked block released before the current one is cleared after it") {
+  Ring ring(KEY);
+  DadaHdu writer(KEY, 0);
+  DadaHdu reader(KEY, 1);
+  REQUIRE(writer);
+  REQUIRE(reader);
+  write_blocks(writer, NBUFS, BUFSZ);
+
+  ipcbuf_t *block = dada_get_data_block(reader.get());
+  DadaBlock current = reader.read();
+  DadaBlock next    = reader.peek();
+  REQUIRE(current);
+  REQUIRE(next);
+  CHECK(current.sequence() == 0);
+  CHECK(next.sequence() == 1);
+  CHECK(stamp(current) == 0);
+  CHECK(stamp(next) == 1);
+  CHECK(next.size() == BUFSZ);
+
+  // Only one block can be ahead of the open one
+  CHECK(!reader.peek());
+
+  // The next block waits for the current one
+  CHECK(next.release() == EXIT_SUCCESS);
+  CHECK(ipcbuf_get_read_count(block) == 0);
+  CHECK(current.release() == EXIT_SUCCESS);
+  CHECK(ipcbuf_get_read_count(block) == 2);
+
+  // Reading goes on after both
+  for(uint64_t i = 2; i < NBUFS; i++){
+    DadaBlock b = reader.read();
+    REQUIRE(b);
+    CHECK(b.sequence() == i);
+    CHECK(stamp(b) == i);
+  }
+  CHECK(!reader.read());
+  CHECK(reader.eod());
+}
+
+TEST_CASE("blocks() of a reader goes through every block up to end of data") {
+  Ring ring(KEY);
+
+  thread writer([&]{
+    DadaHdu hdu(KEY, 0);
+    REQUIRE(hdu);
+    write_blocks(hdu, NBLOCK, LASTSZ);
+  });
+
+  DadaHdu reader(KEY, 1);
+  REQUIRE(reader);
+  vector<uint64_t> sequences, stamps, sizes;
+  for(DadaBlock &block : reader.blocks()){
+    sequences.push_back(block.sequence());
+    stamps.push_back(stamp(block));
+    sizes.push_back(block.size());
+  }
+  writer.join();
+
+  REQUIRE(sequences.size() == NBLOCK);
+  for(uint64_t i = 0; i < NBLOCK; i++){
+    CHECK(sequences[i] == i);
+    CHECK(stamps[i] == i);
+    CHECK(sizes[i] == (i == NBLOCK - 1 ? LASTSZ : BUFSZ));
+  }
+  CHECK(reader.eod());
+  CHECK(ipcbuf_get_read_count(dada_get_data_block(reader.get())) == NBLOCK);
+}
+
+TEST_CASE("A writer which breaks out of blocks() fills the block it breaks on and no more") {
+  Ring ring(KEY);
+  const uint64_t nblock = NBUFS - 1; // Leaves room for the end of data block
+
+  DadaHdu writer(KEY, 0);
+  REQUIRE(writer);
+  for(DadaBlock &block : writer.blocks()){
+    uint64_t i = block.sequence();
+    memcpy(block.data(), &i, sizeof(i));
+    if(i == nblock - 1){
+      break;
+    }
+  }
+  CHECK(ipcbuf_get_write_count(dada_get_data_block(writer.get())) == nblock);
+
+  // The ring is free for the next block
+  CHECK(writer.end_of_data() == EXIT_SUCCESS);
+  CHECK(ipcbuf_get_write_count(dada_get_data_block(writer.get())) == nblock + 1);
+
+  DadaHdu reader(KEY, 1);
+  REQUIRE(reader);
+  uint64_t n = 0;
+  for(DadaBlock &block : reader.blocks()){
+    CHECK(stamp(block) == n);
+    CHECK(block.size() == BUFSZ);
+    n++;
+  }
+  CHECK(n == nblock);
+  CHECK(reader.eod());
+}
+
+TEST_CASE("Views stay valid when their HDU moves") {
+  Ring ring(KEY);
+  DadaHdu writer(KEY, 0);
+  REQUIRE(writer);
+  write_blocks(writer, NBUFS, BUFSZ);
+
+  DadaHdu reader(KEY, 1);
+  REQUIRE(reader);
+  ipcbuf_t *block = dada_get_data_block(reader.get());
+  DadaBlock current = reader.read();
+  DadaBlock next    = reader.peek();
+  REQUIRE(current);
+  REQUIRE(next);
+
+  // Move construct with both views out
+  DadaHdu moved(std::move(reader));
+  CHECK(!reader);
+  CHECK(moved);
+  CHECK(!reader.read());
+
+  CHECK(current.release() == EXIT_SUCCESS);
+  CHECK(ipcbuf_get_read_count(block) == 1);
+
+  // Move assign with the peeked view out, it is the open block now
+  DadaHdu assigned(KEY + 16, 1);
+  CHECK(!assigned);
+  assigned = std::move(moved);
+  CHECK(!moved);
+  CHECK(assigned);
+
+  CHECK(next.release() == EXIT_SUCCESS);
+  CHECK(ipcbuf_get_read_count(block) == 2);
+
+  // The new owner reads the next block
+  DadaBlock third = assigned.read();
+  REQUIRE(third);
+  CHECK(third.sequence() == 2);
+  CHECK(stamp(third) == 2);
+  third.release();
+
+  DadaBlock last = assigned.read();
+  REQUIRE(last);
+  CHECK(stamp(last) == NBUFS - 1);
+  last.release();
+  CHECK(!assigned.read());
+  CHECK(assigned.eod());
+}
@@ -0,0 +1,119 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+/*
+  Test of the binary header sidecar, it checks that readers take the binary copy only when it matches the ASCII header
+  and times loading from the copy against parsing the ASCII header
+*/
+
+#include "dada_header.h"
+#include "dada_def.h"
+#include "futils.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define NLOOP 100000
+
+static double elapsed_ns(struct timespec start, struct timespec stop){
+  return (stop.tv_sec - start.tv_sec)*1E9 + (stop.tv_nsec - start.tv_nsec);
+}
+
+static void check(int condition, const char *what, int line){
+  if(!condition){
+    fprintf(stderr, "TEST_DADA_HEADER_BINARY_ERROR:\t%s, "
+	    "which happens at \"%s\", line [%d], has to abort.\n",
+	    what, __FILE__, line);
+    exit(EXIT_FAILURE);
+  }
+}
+
+int main(int argc, char *argv[]) {
+
+  dada_header_t header = {0};
+  header.tsamp        = 0.0009765625;
+  header.mjd_start    = 60000.123456789012;
+  header.bw           = 512;
+  strcpy(header.utc_start, "2020-01-21-01:01:01");
+  header.nchan        = 4096;
+  header.npkt         = 65536;
+  header.pkt_nsamp    = 8192;
+  header.nchan_fine   = 4097;
+  header.naverage     = 2;
+  header.pkt_tsamp    = 8;
+  header.npol         = 2;
+  header.nant         = 1;
+  header.nbit         = 8;
+  header.totalsamples = 409600000;
+  header.period       = 27;
+
+  // Header block as a writer leaves it, ASCII first and binary copy at the end
+  static char buffer[DADA_DEFAULT_HEADER_SIZE] __attribute__((aligned(8)));
+  dada_header_offsets_t offsets;
+  int length = sprintf(buffer, "HDR_VERSION  1.0\nHDR_SIZE     4096\n");
+  serialize_dada_header(&header, buffer + length, DADA_DEFAULT_HEADER_SIZE - length, &offsets);
+  check(write_dada_header_binary(&header, buffer, DADA_DEFAULT_HEADER_SIZE) == EXIT_SUCCESS, "Could not write binary copy", __LINE__);
+
+  dada_header_t loaded = {0};
+  check(find_dada_header_binary(buffer, DADA_DEFAULT_HEADER_SIZE) != NULL, "Binary copy is not found", __LINE__);
+  check(load_dada_header(buffer, DADA_DEFAULT_HEADER_SIZE, &loaded) == 0, "Load reports missing keys", __LINE__);
+  check(memcmp(&header, &loaded, sizeof(dada_header_t)) == 0, "Binary copy differs from header", __LINE__);
+
+  // An edit of the text, even with the same length, sends readers back to ASCII
+  check(update_dada_header_uint64(buffer + length, &offsets, DADA_HEADER_TOTALSAMPLES, 123) == EXIT_SUCCESS, "Could not update in place", __LINE__);
+  check(find_dada_header_binary(buffer, DADA_DEFAULT_HEADER_SIZE) == NULL, "Stale binary copy is used", __LINE__);
+  check(load_dada_header(buffer, DADA_DEFAULT_HEADER_SIZE, &loaded) == 0 && loaded.totalsamples == 123, "ASCII fallback failed", __LINE__);
+
+  header.totalsamples = 123;
+  write_dada_header_binary(&header, buffer, DADA_DEFAULT_HEADER_SIZE);
+  check(find_dada_header_binary(buffer, DADA_DEFAULT_HEADER_SIZE) != NULL, "Rewritten binary copy is not found", __LINE__);
+
+  // Another schema or version is not trusted
+  dada_header_binary_t *binary = (dada_header_binary_t *)find_dada_header_binary(buffer, DADA_DEFAULT_HEADER_SIZE);
+  binary->schema_hash ^= 1;
+  check(find_dada_header_binary(buffer, DADA_DEFAULT_HEADER_SIZE) == NULL, "Binary copy of another schema is used", __LINE__);
+  binary->schema_hash ^= 1;
+  binary->version++;
+  check(find_dada_header_binary(buffer, DADA_DEFAULT_HEADER_SIZE) == NULL, "Binary copy of another version is used", __LINE__);
+  binary->version--;
+
+  // No room behind a long ASCII header
+  static char full[DADA_DEFAULT_HEADER_SIZE];
+  memset(full, 'A', DADA_DEFAULT_HEADER_SIZE - 1);
+  check(write_dada_header_binary(&header, full, DADA_DEFAULT_HEADER_SIZE) == EXIT_FAILURE, "Binary copy overwrites ASCII header", __LINE__);
+  check(find_dada_header_binary(full, DADA_DEFAULT_HEADER_SIZE) == NULL, "Binary copy is found in ASCII text", __LINE__);
+
+  // Files carry the copy too
+  write_dada_header_to_file(header, "write_header_binary.txt");
+  memset(&loaded, 0, sizeof(dada_header_t));
+  check(read_dada_header_from_file("write_header_binary.txt", &loaded) == EXIT_SUCCESS &&
+	memcmp(&header, &loaded, sizeof(dada_header_t)) == 0, "File round trip failed", __LINE__);
+
+  struct timespec start, stop;
+  uint64_t missing = 0;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for(int i = 0; i < NLOOP; i++){
+    missing |= parse_dada_header(buffer, &loaded);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &stop);
+  double parse_ns = elapsed_ns(start, stop)/NLOOP;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for(int i = 0; i < NLOOP; i++){
+    missing |= load_dada_header(buffer, DADA_DEFAULT_HEADER_SIZE, &loaded);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &stop);
+  double load_ns = elapsed_ns(start, stop)/NLOOP;
+  check(missing == 0, "Load reports missing keys", __LINE__);
+
+  fprintf(stdout, "%zu bytes binary copy, %zu bytes ASCII header\n", sizeof(dada_header_binary_t), strlen(buffer));
+  fprintf(stdout, "parse ASCII header:       %10.1f ns\n", parse_ns);
+  fprintf(stdout, "load binary copy:         %10.1f ns\n", load_ns);
+  fprintf(stdout, "speedup:                  %10.1f\n", parse_ns/load_ns);
+
+  return EXIT_SUCCESS;
+}
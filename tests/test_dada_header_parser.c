@@ -0,0 +1,141 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+/*
+  Micro benchmark of the single pass DADA header parser against one ascii_header_get per key,
+  it also checks both give the same values, that missing keys come back in the mask
+  and that the perfect hash resolves every key of the spec and nothing else
+*/
+
+#include "dada_header.h"
+#include "dada_def.h"
+#include "futils.h"
+#include "ascii_header.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define NLOOP 100000
+
+static double elapsed_ns(struct timespec start, struct timespec stop){
+  return (stop.tv_sec - start.tv_sec)*1E9 + (stop.tv_nsec - start.tv_nsec);
+}
+
+int main(int argc, char *argv[]) {
+
+  char dada_header_buffer[DADA_DEFAULT_HEADER_SIZE] = {0};
+  char dada_header_filename[DADA_STRLEN] = {"0"};
+
+  strcpy(dada_header_filename, "../../tests/dada.header");
+  if(argc > 1){
+    strcpy(dada_header_filename, argv[1]);
+  }
+
+  if(fileread(dada_header_filename, dada_header_buffer, DADA_DEFAULT_HEADER_SIZE) < 0){
+    fprintf(stderr, "TEST_DADA_HEADER_PARSER_ERROR:\tError reading DADA header file, "
+	    "which happens at \"%s\", line [%d], has to abort.\n",
+	    __FILE__, __LINE__);
+    exit(EXIT_FAILURE);
+  }
+  dada_header_buffer[DADA_DEFAULT_HEADER_SIZE - 1] = '\0';
+
+  // Both paths give the same header
+  dada_header_t ascii = {0};
+  dada_header_t parsed = {0};
+  read_dada_header_ascii(dada_header_buffer, &ascii);
+  uint64_t missing = parse_dada_header(dada_header_buffer, &parsed);
+  if(missing || memcmp(&ascii, &parsed, sizeof(dada_header_t))){
+    fprintf(stderr, "TEST_DADA_HEADER_PARSER_ERROR:\tParsed header differs from ascii_header_get, missing mask %#" PRIx64 ", "
+	    "which happens at \"%s\", line [%d], has to abort.\n",
+	    missing, __FILE__, __LINE__);
+    exit(EXIT_FAILURE);
+  }
+
+  // A missing key is reported in the mask, not with exit
+  char broken[DADA_DEFAULT_HEADER_SIZE];
+  memcpy(broken, dada_header_buffer, DADA_DEFAULT_HEADER_SIZE);
+  char *line = strstr(broken, "\nNBIT");
+  line[1] = 'X';
+  missing = parse_dada_header(broken, &parsed);
+  if(missing != DADA_HEADER_BIT(DADA_HEADER_NBIT)){
+    fprintf(stderr, "TEST_DADA_HEADER_PARSER_ERROR:\tMissing mask is %#" PRIx64 ", but it should be %#" PRIx64 ", "
+	    "which happens at \"%s\", line [%d], has to abort.\n",
+	    missing, DADA_HEADER_BIT(DADA_HEADER_NBIT), __FILE__, __LINE__);
+    exit(EXIT_FAILURE);
+  }
+
+  // Every key resolves to itself, others resolve to nothing
+  const char *keys[] = {"TSAMP", "MJD_START", "BW", "UTC_START", "NCHAN", "NPKT", "PKT_NSAMP", "NCHAN_FINE",
+			"NAVERAGE", "PKT_TSAMP", "NPOL", "NANT", "NBIT", "TOTALSAMPLES", "PERIOD"};
+  for(int k = 0; k < DADA_HEADER_NKEY; k++){
+    if(dada_header_key_index(keys[k]) != k){
+      fprintf(stderr, "TEST_DADA_HEADER_PARSER_ERROR:\tKey %s resolves to %d, but it should be %d, "
+	      "which happens at \"%s\", line [%d], has to abort.\n",
+	      keys[k], dada_header_key_index(keys[k]), k, __FILE__, __LINE__);
+      exit(EXIT_FAILURE);
+    }
+  }
+  const char *others[] = {"PKT_SIZE", "NCHA", "NCHANX", "TSAMP ", "", "HDR_SIZE"};
+  for(int i = 0; i < (int)(sizeof(others)/sizeof(others[0])); i++){
+    if(dada_header_key_index(others[i]) != -1){
+      fprintf(stderr, "TEST_DADA_HEADER_PARSER_ERROR:\tUnknown key \"%s\" resolves to %d, "
+	      "which happens at \"%s\", line [%d], has to abort.\n",
+	      others[i], dada_header_key_index(others[i]), __FILE__, __LINE__);
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  // One key from the index
+  dada_header_index_t index;
+  index_dada_header(dada_header_buffer, &index);
+  int nbit = 0;
+  if(get_dada_header_int(&index, "NBIT", &nbit) || nbit != ascii.nbit ||
+     get_dada_header_int(&index, "PKT_SIZE", &nbit) == EXIT_SUCCESS){
+    fprintf(stderr, "TEST_DADA_HEADER_PARSER_ERROR:\tSingle key lookup failed, "
+	    "which happens at \"%s\", line [%d], has to abort.\n",
+	    __FILE__, __LINE__);
+    exit(EXIT_FAILURE);
+  }
+
+  struct timespec start, stop;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for(int i = 0; i < NLOOP; i++){
+    read_dada_header_ascii(dada_header_buffer, &ascii);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &stop);
+  double ascii_ns = elapsed_ns(start, stop)/NLOOP;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for(int i = 0; i < NLOOP; i++){
+    missing |= parse_dada_header(dada_header_buffer, &parsed);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &stop);
+  double parse_ns = elapsed_ns(start, stop)/NLOOP;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for(int i = 0; i < NLOOP; i++){
+    ascii_header_get(dada_header_buffer, "NBIT", "%d", &nbit);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &stop);
+  double ascii_one_ns = elapsed_ns(start, stop)/NLOOP;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for(int i = 0; i < NLOOP; i++){
+    get_dada_header_int(&index, "NBIT", &nbit);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &stop);
+  double lookup_ns = elapsed_ns(start, stop)/NLOOP;
+
+  fprintf(stdout, "%d keys, %zu bytes header\n", DADA_HEADER_NKEY, strlen(dada_header_buffer));
+  fprintf(stdout, "ascii_header_get one key: %10.1f ns\n", ascii_one_ns);
+  fprintf(stdout, "one key from index:       %10.1f ns\n", lookup_ns);
+  fprintf(stdout, "ascii_header_get per key: %10.1f ns\n", ascii_ns);
+  fprintf(stdout, "single pass parse:        %10.1f ns\n", parse_ns);
+  fprintf(stdout, "speedup:                  %10.1f\n", ascii_ns/parse_ns);
+
+  return EXIT_SUCCESS;
+}
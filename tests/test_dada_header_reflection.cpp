@@ -0,0 +1,119 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "dada_header.hpp"
+#include "dada_def.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest/doctest.h"
+
+using namespace std;
+
+// The table is usable at compile time
+static_assert(dada_header::key_of("NCHAN") == DADA_HEADER_NCHAN);
+static_assert(dada_header::key_of("TOTALSAMPLES") == DADA_HEADER_TOTALSAMPLES);
+static_assert(dada_header::key_of("PKT_SIZE") == -1);
+static_assert(is_same_v<dada_header::field_t<dada_header::key_of("UTC_START")>, char[DADA_STRLEN]>);
+static_assert(is_same_v<dada_header::field_t<DADA_HEADER_TOTALSAMPLES>, uint64_t>);
+static_assert(is_same_v<dada_header::field_t<DADA_HEADER_TSAMP>, double>);
+static_assert(is_same_v<dada_header::field_t<DADA_HEADER_NBIT>, int>);
+static_assert(get<DADA_HEADER_PERIOD>(dada_header::fields).offset == offsetof(dada_header_t, period));
+
+// Distinct value of every type for field k, so a swapped field shows up
+struct fill_visitor{
+  int k = 0;
+  template <typename F, typename T>
+  void operator()(const F &, T &member){
+    k++;
+    if constexpr (F::kind == dada_header::field_type::INT)         member = -1000*k - 7;
+    else if constexpr (F::kind == dada_header::field_type::UINT64) member = UINT64_MAX - k;
+    else if constexpr (F::kind == dada_header::field_type::DOUBLE) member = 1.0/(3*k) + 58000*k;
+    else if constexpr (F::kind == dada_header::field_type::FLOAT)   member = 1.0f/(3*k);
+    else snprintf(member, DADA_STRLEN, "value-%d_%s", k, "2020-01-21-01:01:01");
+  }
+};
+
+// Names of fields which differ
+static vector<string> differ(const dada_header_t &a, const dada_header_t &b){
+  vector<string> names;
+  dada_header::for_each_field([&](const auto &f){
+      const auto &x = a.*(f.member);
+      const auto &y = b.*(f.member);
+      if(memcmp(&x, &y, sizeof(x))){
+	names.push_back(f.name);
+      }
+    });
+  return names;
+}
+
+TEST_CASE("field table matches dada_header_t") {
+  int index = 0;
+  size_t nbyte = 0;
+  dada_header::for_each_field([&](const auto &f){
+      CHECK(f.key == index);
+      CHECK(dada_header::key_of(f.name) == index);
+      nbyte += sizeof(typename std::decay_t<decltype(f)>::type);
+      index++;
+    });
+  CHECK(index == DADA_HEADER_NKEY);
+  CHECK(nbyte == dada_header::packed_size);
+}
+
+TEST_CASE("typed accessors reach the right member") {
+  dada_header_t header = {0};
+  dada_header::get<DADA_HEADER_NCHAN>(header) = 4096;
+  dada_header::get<dada_header::key_of("TOTALSAMPLES")>(header) = UINT64_MAX;
+  dada_header::get<DADA_HEADER_MJD_START>(header) = 60000.5;
+  strcpy(dada_header::get<DADA_HEADER_UTC_START>(header), "2024-12-31");
+
+  CHECK(header.nchan == 4096);
+  CHECK(header.totalsamples == UINT64_MAX);
+  CHECK(header.mjd_start == 60000.5);
+  CHECK(strcmp(header.utc_start, "2024-12-31") == 0);
+
+  const dada_header_t &view = header;
+  CHECK(dada_header::get<DADA_HEADER_NCHAN>(view) == 4096);
+}
+
+TEST_CASE("binary round trip through pack and unpack") {
+  dada_header_t header = {0};
+  dada_header::for_each_field(header, fill_visitor());
+
+  vector<char> buffer(dada_header::packed_size);
+  dada_header::pack(header, buffer.data());
+
+  dada_header_t copy = {0};
+  dada_header::unpack(buffer.data(), copy);
+  CHECK(differ(header, copy).empty());
+}
+
+TEST_CASE("ASCII round trip through serialize_dada_header and parse_dada_header") {
+  dada_header_t header = {0};
+  dada_header::for_each_field(header, fill_visitor());
+
+  char buffer[DADA_DEFAULT_HEADER_SIZE];
+  REQUIRE(serialize_dada_header(&header, buffer, DADA_DEFAULT_HEADER_SIZE, NULL) > 0);
+
+  dada_header_t copy = {0};
+  CHECK(parse_dada_header(buffer, &copy) == 0);
+  CHECK(differ(header, copy).empty());
+}
+
+TEST_CASE("ASCII round trip through write_dada_header and read_dada_header") {
+  dada_header_t header = {0};
+  dada_header::for_each_field(header, fill_visitor());
+
+  char buffer[DADA_DEFAULT_HEADER_SIZE] = "HDR_VERSION  1.0\nHDR_SIZE     4096\n";
+  REQUIRE(write_dada_header(header, buffer) == EXIT_SUCCESS);
+
+  dada_header_t copy = {0};
+  CHECK(read_dada_header(buffer, &copy) == EXIT_SUCCESS);
+  CHECK(differ(header, copy).empty());
+}
@@ -0,0 +1,197 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+/*
+  Micro benchmark of the single pass DADA header serializer against one ascii_header_set per key,
+  it also checks round trip doubles are written with the fewest digits, the serialize and parse round trip and in place updates
+*/
+
+#include "dada_header.h"
+#include "dada_def.h"
+#include "futils.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define NLOOP 100000
+
+static double elapsed_ns(struct timespec start, struct timespec stop){
+  return (stop.tv_sec - start.tv_sec)*1E9 + (stop.tv_nsec - start.tv_nsec);
+}
+
+static void check(int condition, const char *what, int line){
+  if(!condition){
+    fprintf(stderr, "TEST_DADA_HEADER_WRITER_ERROR:\t%s, "
+	    "which happens at \"%s\", line [%d], has to abort.\n",
+	    what, __FILE__, line);
+    exit(EXIT_FAILURE);
+  }
+}
+
+// Significant digits of a decimal text, trailing zeros of an integer do not count
+static int significant_digits(const char *text){
+  int ndigit = 0, nzero = 0, leading = 1, fraction = 0;
+  for(const char *p = text; *p && *p != 'e'; p++){
+    if(*p == '.'){
+      fraction = 1;
+      continue;
+    }
+    if(*p < '0' || *p > '9' || (leading && *p == '0')){
+      continue;
+    }
+    leading = 0;
+    ndigit++;
+    nzero = *p == '0' ? nzero + 1 : 0;
+  }
+  return fraction ? ndigit : ndigit - nzero;
+}
+
+// Fewest significant digits which read back to the same double
+static int shortest_digits(double number){
+  char text[32];
+  for(int precision = 1; precision < 17; precision++){
+    snprintf(text, sizeof(text), "%.*g", precision, number);
+    if(strtod(text, NULL) == number){
+      return significant_digits(text);
+    }
+  }
+  return 17;
+}
+
+int main(int argc, char *argv[]) {
+
+  // Shortest text which reads back to the same double
+  struct {double number; const char *text;} doubles[] = {
+    {0.1, "0.1"}, {0.0009765625, "0.0009765625"}, {58400, "58400"}, {-512.5, "-512.5"},
+    {60000.123456789012, "60000.12345678901"}, {1E-300, "1e-300"}, {0, "0"}, {1.0/3, "0.3333333333333333"},
+  };
+  char value[DADA_HEADER_DOUBLE_WIDTH + 1];
+  for(int i = 0; i < (int)(sizeof(doubles)/sizeof(doubles[0])); i++){
+    int length = format_dada_header_double(value, doubles[i].number);
+    if(strcmp(value, doubles[i].text) || length != (int)strlen(value) || strtod(value, NULL) != doubles[i].number){
+      fprintf(stderr, "TEST_DADA_HEADER_WRITER_ERROR:\t%.17g is written as %s, but it should be %s, "
+	      "which happens at \"%s\", line [%d], has to abort.\n",
+	      doubles[i].number, value, doubles[i].text, __FILE__, __LINE__);
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  // Values where number*10^k rounds, they used to get a longer text
+  struct {double number; const char *text;} rounded[] = {
+    {67835.789156566, "67835.789156566"}, {69903.55341041, "69903.55341041"}, {-66575.3148, "-66575.3148"},
+  };
+  for(int i = 0; i < (int)(sizeof(rounded)/sizeof(rounded[0])); i++){
+    format_dada_header_double(value, rounded[i].number);
+    check(strcmp(value, rounded[i].text) == 0, "Double is not written in shortest text", __LINE__);
+  }
+
+  // Random doubles all read back with the fewest digits
+  srand(1);
+  for(int i = 0; i < 100000; i++){
+    double number = (rand() - RAND_MAX/2)/(double)rand()*(i%7 ? 1 : 1E-9);
+    format_dada_header_double(value, number);
+    check(strtod(value, NULL) == number, "Double does not read back", __LINE__);
+    check(significant_digits(value) == shortest_digits(number), "Double is not written in shortest text", __LINE__);
+  }
+
+  // MJD like values with 1 to 10 decimals
+  for(int i = 0; i < 20000; i++){
+    char text[32];
+    int ndecimal = 1 + i%10;
+    long long scale = 1;
+    for(int k = 0; k < ndecimal; k++){
+      scale *= 10;
+    }
+    snprintf(text, sizeof(text), "%d.%0*lld", 50000 + rand()%20000, ndecimal, ((long long)rand()*RAND_MAX + rand())%scale);
+    double number = strtod(text, NULL);
+    format_dada_header_double(value, number);
+    check(strtod(value, NULL) == number, "Double does not read back", __LINE__);
+    check(significant_digits(value) == shortest_digits(number), "Double is not written in shortest text", __LINE__);
+  }
+
+  dada_header_t header = {0};
+  header.tsamp        = 0.0009765625;
+  header.mjd_start    = 60000.123456789012;
+  header.bw           = -512.5;
+  strcpy(header.utc_start, "2020-01-21-01:01:01");
+  header.nchan        = 4096;
+  header.npkt         = 65536;
+  header.pkt_nsamp    = 8192;
+  header.nchan_fine   = -1;
+  header.naverage     = 2;
+  header.pkt_tsamp    = 8E-9;
+  header.npol         = 2;
+  header.nant         = 1;
+  header.nbit         = 8;
+  header.totalsamples = 18446744073709551615ULL;
+  header.period       = 1.0/3;
+
+  // Serialize and parse give back the same header
+  char buffer[DADA_DEFAULT_HEADER_SIZE];
+  dada_header_offsets_t offsets;
+  dada_header_t parsed = {0};
+  int nbyte = serialize_dada_header(&header, buffer, DADA_DEFAULT_HEADER_SIZE, &offsets);
+  check(nbyte > 0 && nbyte == (int)strlen(buffer), "Serialize failed", __LINE__);
+  check(parse_dada_header(buffer, &parsed) == 0, "Serialized header misses keys", __LINE__);
+  check(memcmp(&header, &parsed, sizeof(dada_header_t)) == 0, "Serialized header does not read back", __LINE__);
+  check(serialize_dada_header(&header, buffer, 100, NULL) == -1, "Serialize into a short buffer should fail", __LINE__);
+
+  // ascii_header_set path also keeps every digit now
+  char ascii[DADA_DEFAULT_HEADER_SIZE] = "HDR_VERSION  1.0\nHDR_SIZE     4096\n";
+  memset(&parsed, 0, sizeof(dada_header_t));
+  write_dada_header(header, ascii);
+  check(parse_dada_header(ascii, &parsed) == 0 && memcmp(&header, &parsed, sizeof(dada_header_t)) == 0,
+	"write_dada_header does not read back", __LINE__);
+
+  // In place updates keep the rest of the buffer
+  nbyte = serialize_dada_header(&header, buffer, DADA_DEFAULT_HEADER_SIZE, &offsets);
+  header.totalsamples = 12345;
+  header.nchan        = -2147483647 - 1;
+  header.mjd_start    = 1.0/7;
+  strcpy(header.utc_start, "2024-12-31");
+  check(update_dada_header_uint64(buffer, &offsets, DADA_HEADER_TOTALSAMPLES, header.totalsamples) == EXIT_SUCCESS &&
+	update_dada_header_int(buffer, &offsets, DADA_HEADER_NCHAN, header.nchan) == EXIT_SUCCESS &&
+	update_dada_header_double(buffer, &offsets, DADA_HEADER_MJD_START, header.mjd_start) == EXIT_SUCCESS &&
+	update_dada_header_string(buffer, &offsets, DADA_HEADER_UTC_START, header.utc_start) == EXIT_SUCCESS,
+	"In place update failed", __LINE__);
+  check(nbyte == (int)strlen(buffer), "In place update changed header size", __LINE__);
+  check(parse_dada_header(buffer, &parsed) == 0 && memcmp(&header, &parsed, sizeof(dada_header_t)) == 0,
+	"Updated header does not read back", __LINE__);
+  check(update_dada_header_string(buffer, &offsets, DADA_HEADER_UTC_START, "2024-12-31-23:59:59.999") == EXIT_FAILURE,
+	"Longer string should not fit in place", __LINE__);
+
+  struct timespec start, stop;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for(int i = 0; i < NLOOP; i++){
+    strcpy(ascii, "HDR_VERSION  1.0\nHDR_SIZE     4096\n");
+    write_dada_header(header, ascii);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &stop);
+  double ascii_ns = elapsed_ns(start, stop)/NLOOP;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for(int i = 0; i < NLOOP; i++){
+    serialize_dada_header(&header, buffer, DADA_DEFAULT_HEADER_SIZE, &offsets);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &stop);
+  double serialize_ns = elapsed_ns(start, stop)/NLOOP;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for(uint64_t i = 0; i < NLOOP; i++){
+    update_dada_header_uint64(buffer, &offsets, DADA_HEADER_TOTALSAMPLES, i);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &stop);
+  double update_ns = elapsed_ns(start, stop)/NLOOP;
+
+  fprintf(stdout, "%d keys, %d bytes header\n", DADA_HEADER_NKEY, nbyte);
+  fprintf(stdout, "ascii_header_set per key: %10.1f ns\n", ascii_ns);
+  fprintf(stdout, "single pass serialize:    %10.1f ns\n", serialize_ns);
+  fprintf(stdout, "in place update:          %10.1f ns\n", update_ns);
+  fprintf(stdout, "speedup:                  %10.1f\n", ascii_ns/serialize_ns);
+
+  return EXIT_SUCCESS;
+}
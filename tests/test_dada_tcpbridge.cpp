@@ -0,0 +1,216 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+/*
+  Test of DadaTcpSender and DadaTcpReceiver, bridges run over socket pairs
+  between rings of dada_ring_fixture.h
+*/
+
+#include "utils/dada_tcpbridge.h"
+
+#include <sys/socket.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest/doctest.h"
+#include "dada_ring_fixture.h"
+
+using namespace std;
+
+#define KEY_A   0xdad0 // header rings take key + 1
+#define KEY_B   0xdad2
+#define KEY_C   0xdad4
+
+static const char *HEADER = "HDR_VERSION 1.0\nHDR_SIZE 4096\nNBIT 8\n";
+
+static char pattern(uint64_t iblock, uint64_t i){
+  return (char)(iblock*31 + i*7);
+}
+
+// Header and NBLOCK blocks, the last one is short and ends data
+static void write_ring(key_t key, multilog_t *log){
+  dada_hdu_t *hdu = dada_setup_hdu(key, 0, log);
+  ipcbuf_t *header_block = dada_get_header_block(hdu);
+  ipcbuf_t *data_block   = dada_get_data_block(hdu);
+
+  char *header = ipcbuf_get_next_write(header_block);
+  strcpy(header, HEADER);
+  ipcbuf_mark_filled(header_block, strlen(HEADER));
+
+  for(uint64_t b = 0; b < NBLOCK; b++){
+    uint64_t nbytes = b == NBLOCK - 1 ? LASTSZ : BUFSZ;
+    char *block = ipcbuf_get_next_write(data_block);
+    for(uint64_t i = 0; i < nbytes; i++){
+      block[i] = pattern(b, i);
+    }
+    if(b == NBLOCK - 1){
+      ipcbuf_enable_eod(data_block);
+    }
+    ipcbuf_mark_filled(data_block, nbytes);
+  }
+
+  dada_remove_hdu(hdu, 0);
+}
+
+struct bridge_result{
+  int send_status = EXIT_FAILURE;
+  int recv_status = EXIT_FAILURE;
+  uint64_t nblock_sent = 0, nbyte_sent = 0;
+  uint64_t nblock_received = 0, nbyte_received = 0;
+};
+
+// One hop from the ring of key_in to the ring of key_out
+static void bridge(key_t key_in, key_t key_out, multilog_t *log, bridge_result &result){
+  int socks[2];
+  REQUIRE(socketpair(AF_UNIX, SOCK_STREAM, 0, socks) == 0);
+
+  thread receiver([&]{
+    dada_hdu_t *hdu = dada_setup_hdu(key_out, 0, log);
+    DadaTcpReceiver r(hdu, socks[1]);
+    result.recv_status     = r.run();
+    result.nblock_received = r.nblock_total;
+    result.nbyte_received  = r.nbyte_total;
+    dada_remove_hdu(hdu, 0);
+  });
+
+  dada_hdu_t *hdu = dada_setup_hdu(key_in, 1, log);
+  DadaTcpSender s(hdu, socks[0]);
+  result.send_status = s.run();
+  result.nblock_sent = s.nblock_total;
+  result.nbyte_sent  = s.nbyte_total;
+  dada_remove_hdu(hdu, 1);
+
+  receiver.join();
+  close(socks[0]);
+  close(socks[1]);
+}
+
+TEST_CASE("DadaTcpSender and DadaTcpReceiver carry a ring through a chain of two bridges") {
+  multilog_t *log = multilog_open("test_dada_tcpbridge", 0);
+  multilog_add(log, stderr);
+
+  Ring a(KEY_A), b(KEY_B), c(KEY_C);
+  bridge_result hop1, hop2;
+
+  thread writer(write_ring, KEY_A, log);
+  thread bridge1(bridge, KEY_A, KEY_B, log, ref(hop1));
+  thread bridge2(bridge, KEY_B, KEY_C, log, ref(hop2));
+
+  // Read the end of the chain
+  dada_hdu_t *hdu = dada_setup_hdu(KEY_C, 1, log);
+  ipcbuf_t *header_block = dada_get_header_block(hdu);
+  ipcbuf_t *data_block   = dada_get_data_block(hdu);
+
+  uint64_t nbytes;
+  char *header = ipcbuf_get_next_read(header_block, &nbytes);
+  REQUIRE(header != NULL);
+  CHECK(string(header, nbytes) == HEADER);
+  ipcbuf_mark_cleared(header_block);
+
+  // Every block in order with its bytes, and no extra empty block from the hops
+  vector<uint64_t> sizes;
+  int nbad = 0;
+  while(!ipcbuf_eod(data_block)){
+    char *block = ipcbuf_get_next_read(data_block, &nbytes);
+    REQUIRE(block != NULL);
+    uint64_t iblock = sizes.size();
+    for(uint64_t i = 0; i < nbytes; i++){
+      nbad += block[i] != pattern(iblock, i);
+    }
+    sizes.push_back(nbytes);
+    ipcbuf_mark_cleared(data_block);
+  }
+  dada_remove_hdu(hdu, 1);
+
+  writer.join();
+  bridge1.join();
+  bridge2.join();
+
+  // The chain ends with the empty end of data block of the last receiver
+  REQUIRE(sizes.size() == NBLOCK + 1);
+  for(uint64_t i = 0; i < NBLOCK - 1; i++){
+    CHECK(sizes[i] == BUFSZ);
+  }
+  CHECK(sizes[NBLOCK - 1] == LASTSZ);
+  CHECK(sizes[NBLOCK] == 0);
+  CHECK(nbad == 0);
+
+  // Sequence numbers and totals match at both ends of each hop, the ACK tells the sender
+  uint64_t nbyte_total = (NBLOCK - 1)*(uint64_t)BUFSZ + LASTSZ;
+  for(bridge_result *hop : {&hop1, &hop2}){
+    CHECK(hop->send_status == EXIT_SUCCESS);
+    CHECK(hop->recv_status == EXIT_SUCCESS);
+    CHECK(hop->nblock_sent == NBLOCK);
+    CHECK(hop->nblock_received == NBLOCK);
+    CHECK(hop->nbyte_sent == nbyte_total);
+    CHECK(hop->nbyte_received == nbyte_total);
+  }
+
+  multilog_close(log);
+}
+
+TEST_CASE("DadaTcpSender frames are little endian on the wire and an empty end of data block is not sent") {
+  multilog_t *log = multilog_open("test_dada_tcpbridge", 0);
+  multilog_add(log, stderr);
+  Ring a(KEY_A);
+
+  // Only a header and an empty end of data block
+  thread writer([&]{
+    dada_hdu_t *hdu = dada_setup_hdu(KEY_A, 0, log);
+    ipcbuf_t *header_block = dada_get_header_block(hdu);
+    ipcbuf_t *data_block   = dada_get_data_block(hdu);
+    strcpy(ipcbuf_get_next_write(header_block), HEADER);
+    ipcbuf_mark_filled(header_block, strlen(HEADER));
+    ipcbuf_get_next_write(data_block);
+    ipcbuf_enable_eod(data_block);
+    ipcbuf_mark_filled(data_block, 0);
+    dada_remove_hdu(hdu, 0);
+  });
+
+  int socks[2];
+  REQUIRE(socketpair(AF_UNIX, SOCK_STREAM, 0, socks) == 0);
+  int status = EXIT_FAILURE;
+  thread sender([&]{
+    dada_hdu_t *hdu = dada_setup_hdu(KEY_A, 1, log);
+    DadaTcpSender s(hdu, socks[0]);
+    status = s.run();
+    dada_remove_hdu(hdu, 1);
+  });
+
+  // Header frame, byte by byte
+  unsigned char frame[sizeof(dada_frame_t)];
+  REQUIRE(recvbuf_tcp(socks[1], (char *)frame, sizeof(frame)) == EXIT_SUCCESS);
+  CHECK(memcmp(frame, "DADA", 4) == 0);
+  CHECK(frame[4] == DADA_FRAME_HEADER);
+  CHECK(frame[16] == strlen(HEADER));
+  for(int i = 17; i < 24; i++){
+    CHECK(frame[i] == 0);
+  }
+  vector<char> header(strlen(HEADER));
+  REQUIRE(recvbuf_tcp(socks[1], header.data(), header.size()) == EXIT_SUCCESS);
+  CHECK(string(header.begin(), header.end()) == HEADER);
+
+  // No block frame, END with zero blocks and zero bytes
+  REQUIRE(recvbuf_tcp(socks[1], (char *)frame, sizeof(frame)) == EXIT_SUCCESS);
+  CHECK(memcmp(frame, "DADA", 4) == 0);
+  CHECK(frame[4] == DADA_FRAME_END);
+  for(int i = 8; i < 24; i++){
+    CHECK(frame[i] == 0);
+  }
+
+  // Little endian ACK
+  unsigned char ack[sizeof(dada_frame_t)] = {'D', 'A', 'D', 'A', DADA_FRAME_ACK};
+  REQUIRE(sendbuf_tcp(socks[1], (char *)ack, sizeof(ack)) == EXIT_SUCCESS);
+
+  sender.join();
+  writer.join();
+  CHECK(status == EXIT_SUCCESS);
+
+  close(socks[0]);
+  close(socks[1]);
+  multilog_close(log);
+}
@@ -0,0 +1,154 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "utils/udp_utils.h"
+#include "utils/epoll_engine.h"
+
+#include <stdint.h>
+
+#include <chrono>
+#include <thread>
+
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest/doctest.h"
+
+using namespace std;
+
+#define PKT_SIZE 8200
+#define PORT     12351
+
+static double seconds_since(chrono::steady_clock::time_point start){
+  return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+TEST_CASE("EpollEngine::run_once timeout uses timerfd") {
+  EpollEngine engine(50);
+
+  auto start = chrono::steady_clock::now();
+  CHECK(engine.run_once(0.005) == 0);
+  double elapsed = seconds_since(start);
+
+  CHECK(elapsed >= 0.005);
+  CHECK(elapsed < 0.05);
+
+  // Spin for the window, then sleep once until the timeout
+  CHECK(engine.nsleep_total == 1);
+  CHECK(engine.nevent_total == 0);
+}
+
+TEST_CASE("EpollEngine periodic and one shot timers") {
+  EpollEngine engine(0);
+
+  uint64_t nperiodic = 0;
+  int noneshot = 0;
+  int periodic = engine.add_timer(0.001, 0.001, [&](int, uint64_t nexpire){nperiodic += nexpire;});
+  int oneshot  = engine.add_timer(0.010, 0, [&](int fd, uint64_t){
+    noneshot++;
+    engine.remove(fd);
+  });
+  REQUIRE(periodic >= 0);
+  REQUIRE(oneshot >= 0);
+
+  auto start = chrono::steady_clock::now();
+  while(noneshot == 0){
+    REQUIRE(engine.run_once(1.0) > 0);
+  }
+  double elapsed = seconds_since(start);
+
+  CHECK(noneshot == 1);
+  CHECK(elapsed >= 0.010);
+  CHECK(nperiodic >= 9);
+  CHECK(engine.remove(periodic) == EXIT_SUCCESS);
+  CHECK(engine.remove(oneshot) == EXIT_FAILURE); // already removed by its handler
+}
+
+TEST_CASE("EpollEngine receives from nonblocking UDP socket") {
+  const int npacket = 1000;
+
+  int rsock;
+  REQUIRE(create_udp_socket(NULL, NULL, PORT, rsock, 1, 64, 0, UDP_UNICAST, UDP_RECV) == EXIT_SUCCESS);
+
+  EpollEngine engine(50);
+  int nreceived = 0;
+  uint64_t neagain = 0;
+  char pkt[PKT_SIZE];
+  REQUIRE(engine.add(rsock, [&](int fd, uint32_t){
+    // Drain the socket, level trigger calls us again if we stop early
+    while(true){
+      ssize_t n = recv(fd, pkt, PKT_SIZE, 0);
+      if(n < 0){
+	neagain += (errno == EAGAIN);
+	break;
+      }
+      nreceived++;
+    }
+  }) == EXIT_SUCCESS);
+  CHECK(engine.add(rsock, [](int, uint32_t){}) == EXIT_FAILURE); // watched already
+
+  thread sender([](){
+    int ssock;
+    REQUIRE(create_udp_socket((char *)"127.0.0.1", NULL, PORT, ssock, 0, 0, -1, UDP_UNICAST, UDP_SEND) == EXIT_SUCCESS);
+    char buf[PKT_SIZE] = {0};
+    for(int i = 0; i < npacket; i++){
+      send(ssock, buf, PKT_SIZE, 0);
+      if(i%100 == 0){
+	this_thread::sleep_for(chrono::milliseconds(1));
+      }
+    }
+    close(ssock);
+  });
+
+  // Returns after 100 ms without packets
+  CHECK(engine.run(0.1) == EXIT_SUCCESS);
+  sender.join();
+
+  CHECK(nreceived == npacket);
+  CHECK(engine.nevent_total == neagain);
+  CHECK(engine.nwake_spin + engine.nwake_sleep >= engine.nevent_total);
+  CHECK(engine.remove(rsock) == EXIT_SUCCESS);
+  close(rsock);
+}
+
+TEST_CASE("EpollEngine::stop wakes up a sleeping engine") {
+  EpollEngine engine(10);
+
+  thread stopper([&](){
+    this_thread::sleep_for(chrono::milliseconds(20));
+    engine.stop();
+  });
+
+  auto start = chrono::steady_clock::now();
+  CHECK(engine.run() == EXIT_SUCCESS);
+  double elapsed = seconds_since(start);
+  stopper.join();
+
+  CHECK(elapsed >= 0.02);
+  CHECK(elapsed < 1.0);
+  CHECK(engine.nevent_total == 0);
+}
+
+TEST_CASE("EpollEngine::stop from a handler does not end the next run early") {
+  EpollEngine engine(0);
+
+  // The handler stops the engine while it is awake, the wake event is left behind
+  int ntimer = 0;
+  int timer = engine.add_timer(0.001, 0, [&](int, uint64_t){
+    ntimer++;
+    engine.stop();
+  });
+  REQUIRE(timer >= 0);
+  CHECK(engine.run() == EXIT_SUCCESS);
+  CHECK(ntimer == 1);
+  CHECK(engine.nwake_sleep == 1);
+  CHECK(engine.remove(timer) == EXIT_SUCCESS);
+
+  // The next run sleeps for its idle time, the timeout is not a handler event
+  auto start = chrono::steady_clock::now();
+  CHECK(engine.run(0.02) == EXIT_SUCCESS);
+  double elapsed = seconds_since(start);
+
+  CHECK(elapsed >= 0.02);
+  CHECK(elapsed < 1.0);
+  CHECK(engine.nwake_sleep == 1);
+}
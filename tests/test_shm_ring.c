@@ -0,0 +1,207 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+/*
+  Cross-process benchmark of block hand-off on the memfd ring, and on a psrdada ring when its key is given,
+  a forked writer fills blocks and the reader checks their sequence and measures
+
+  - latency, the writer stamps a block and pauses, so the reader is asleep and each hand-off includes the wakeup
+  - throughput, the writer fills blocks back to back, only the first bytes are touched, so it is the cost of hand-off
+
+  Usage: test_shm_ring [psrdada key in hex, a ring created with dada_db]
+*/
+
+#include "utils/shm_ring.h"
+#include "utils/dada_utils.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <sys/wait.h>
+
+#define NBUFS   8
+#define BUFSZ   (1 << 20)
+#define NLAT    2000      // Number of blocks for latency
+#define PAUSE   50000     // Pause in nanoseconds after each latency block
+#define NRATE   200000    // Number of blocks for throughput
+
+/// What the writer puts at the start of every block
+typedef struct stamp_t{
+  uint64_t sequence;
+  int64_t ns;
+}stamp_t;
+
+/// Block operations of one ring, so the same writer and reader run on both rings
+typedef struct ring_ops_t{
+  void *ring;
+  char *(*get_next_read)(void *ring, uint64_t *nbytes);
+  int (*mark_cleared)(void *ring);
+  char *(*get_next_write)(void *ring);
+  int (*mark_filled)(void *ring, uint64_t nbytes);
+  int (*enable_eod)(void *ring);
+  uint64_t bufsz;
+}ring_ops_t;
+
+static int64_t now_ns(void){
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec*(int64_t)1000000000 + ts.tv_nsec;
+}
+
+static void check(int condition, const char *what, int line){
+  if(!condition){
+    fprintf(stderr, "TEST_SHM_RING_ERROR:\t%s, "
+	    "which happens at \"%s\", line [%d], has to abort.\n",
+	    what, __FILE__, line);
+    exit(EXIT_FAILURE);
+  }
+}
+
+static int compare(const void *a, const void *b){
+  int64_t x = *(const int64_t *)a, y = *(const int64_t *)b;
+  return (x > y) - (x < y);
+}
+
+static char *shm_read(void *ring, uint64_t *nbytes) {return shm_ring_get_next_read((shm_ring_t *)ring, nbytes);}
+static int shm_cleared(void *ring)                  {return shm_ring_mark_cleared((shm_ring_t *)ring);}
+static char *shm_write(void *ring)                  {return shm_ring_get_next_write((shm_ring_t *)ring);}
+static int shm_filled(void *ring, uint64_t nbytes)  {return shm_ring_mark_filled((shm_ring_t *)ring, nbytes);}
+static int shm_eod(void *ring)                      {return shm_ring_enable_eod((shm_ring_t *)ring);}
+
+static char *dada_read(void *ring, uint64_t *nbytes) {return ipcbuf_get_next_read((ipcbuf_t *)ring, nbytes);}
+static int dada_cleared(void *ring)                  {return ipcbuf_mark_cleared((ipcbuf_t *)ring) < 0;}
+static char *dada_write(void *ring)                  {return ipcbuf_get_next_write((ipcbuf_t *)ring);}
+static int dada_filled(void *ring, uint64_t nbytes)  {return ipcbuf_mark_filled((ipcbuf_t *)ring, nbytes) < 0;}
+static int dada_eod(void *ring)                      {return ipcbuf_enable_eod((ipcbuf_t *)ring) < 0;}
+
+// Latency blocks with a pause after each, then throughput blocks, the last one ends data
+static void writer(ring_ops_t *ops){
+  struct timespec pause = {0, PAUSE};
+
+  for(uint64_t i = 0; i < NLAT + NRATE; i++){
+    stamp_t *stamp = (stamp_t *)ops->get_next_write(ops->ring);
+    check(stamp != NULL, "could not get block for write", __LINE__);
+    stamp->sequence = i;
+    stamp->ns       = now_ns();
+    if(i == NLAT + NRATE - 1){
+      ops->enable_eod(ops->ring);
+    }
+    check(ops->mark_filled(ops->ring, ops->bufsz) == EXIT_SUCCESS, "could not mark block filled", __LINE__);
+    if(i < NLAT){
+      nanosleep(&pause, NULL);
+    }
+  }
+}
+
+static void reader(const char *name, ring_ops_t *ops){
+  int64_t *latency = (int64_t *)malloc(NLAT*sizeof(int64_t));
+  int64_t start = 0;
+  uint64_t nblock = 0;
+  uint64_t nbytes;
+  stamp_t *stamp;
+
+  while((stamp = (stamp_t *)ops->get_next_read(ops->ring, &nbytes)) != NULL && nbytes){
+    int64_t ns = now_ns();
+    check(stamp->sequence == nblock, "block out of order", __LINE__);
+    if(nblock < NLAT){
+      latency[nblock] = ns - stamp->ns;
+    }
+    if(nblock == NLAT){
+      start = ns;
+    }
+    check(ops->mark_cleared(ops->ring) == EXIT_SUCCESS, "could not mark block cleared", __LINE__);
+    if(++nblock == NLAT + NRATE){
+      break;
+    }
+  }
+  double elapsed = (now_ns() - start)/1E9;
+  check(nblock == NLAT + NRATE, "missing blocks", __LINE__);
+
+  qsort(latency, NLAT, sizeof(int64_t), compare);
+  fprintf(stdout, "%-8s latency median %.2f us, 99%% %.2f us, max %.2f us\n",
+	  name, latency[NLAT/2]/1E3, latency[NLAT*99/100]/1E3, latency[NLAT - 1]/1E3);
+  fprintf(stdout, "%-8s throughput %.0f blocks/s, %.2f GB/s of %" PRIu64 " bytes blocks with only the stamp written\n",
+	  name, (NRATE - 1)/elapsed, (NRATE - 1)*(double)ops->bufsz/elapsed/1E9, ops->bufsz);
+  free(latency);
+}
+
+static void run_shm(void){
+  int hugepage = 1;
+  shm_hdu_t *hdu = shm_create_hdu(1, 4096, NBUFS, BUFSZ, hugepage);
+  if(hdu == NULL){
+    fprintf(stdout, "No huge pages, use normal pages\n");
+    hugepage = 0;
+    hdu = shm_create_hdu(1, 4096, NBUFS, BUFSZ, hugepage);
+  }
+  check(hdu != NULL, "could not create ring", __LINE__);
+  check(shm_verify_block_size(BUFSZ, shm_get_data_block(hdu)) == EXIT_SUCCESS, "wrong block size", __LINE__);
+
+  pid_t pid = fork();
+  check(pid >= 0, "fork failed", __LINE__);
+  if(pid == 0){
+    // The child attaches through the inherited memfd as an unrelated process would through /proc
+    shm_hdu_t *child = shm_attach_hdu(dup(hdu->fd));
+    check(child != NULL, "could not attach ring", __LINE__);
+    ring_ops_t ops = {shm_get_data_block(child), shm_read, shm_cleared, shm_write, shm_filled, shm_eod, BUFSZ};
+    writer(&ops);
+    shm_remove_hdu(child);
+    _exit(EXIT_SUCCESS);
+  }
+
+  ring_ops_t ops = {shm_get_data_block(hdu), shm_read, shm_cleared, shm_write, shm_filled, shm_eod, BUFSZ};
+  reader(hugepage ? "memfd-hp" : "memfd", &ops);
+
+  uint64_t nbytes;
+  check(shm_ring_get_next_read(shm_get_data_block(hdu), &nbytes) == NULL && nbytes == 0, "no end of data", __LINE__);
+  check(shm_ring_eod(shm_get_data_block(hdu)), "no end of data", __LINE__);
+
+  int status;
+  waitpid(pid, &status, 0);
+  check(WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS, "writer failed", __LINE__);
+  shm_remove_hdu(hdu);
+}
+
+static void run_dada(key_t key){
+  multilog_t *log = multilog_open("test_shm_ring", 0);
+  multilog_add(log, stderr);
+
+  pid_t pid = fork();
+  check(pid >= 0, "fork failed", __LINE__);
+  if(pid == 0){
+    dada_hdu_t *hdu = dada_setup_hdu(key, 0, log);
+    ipcbuf_t *block = dada_get_data_block(hdu);
+    ring_ops_t ops = {block, dada_read, dada_cleared, dada_write, dada_filled, dada_eod, ipcbuf_get_bufsz(block)};
+    writer(&ops);
+    dada_remove_hdu(hdu, 0);
+    _exit(EXIT_SUCCESS);
+  }
+
+  dada_hdu_t *hdu = dada_setup_hdu(key, 1, log);
+  ipcbuf_t *block = dada_get_data_block(hdu);
+  ring_ops_t ops = {block, dada_read, dada_cleared, dada_write, dada_filled, dada_eod, ipcbuf_get_bufsz(block)};
+  reader("psrdada", &ops);
+
+  int status;
+  waitpid(pid, &status, 0);
+  check(WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS, "writer failed", __LINE__);
+  dada_remove_hdu(hdu, 1);
+  multilog_close(log);
+}
+
+int main(int argc, char *argv[]){
+
+  run_shm();
+
+  if(argc > 1){
+    key_t key;
+    check(sscanf(argv[1], "%x", &key) == 1, "could not parse psrdada key", __LINE__);
+    run_dada(key);
+  }
+  else{
+    fprintf(stdout, "No psrdada key given, create a ring with dada_db and give its key to compare\n");
+  }
+
+  return EXIT_SUCCESS;
+}
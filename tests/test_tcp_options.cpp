@@ -0,0 +1,164 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+/*
+  Loopback sweep of tcp socket options,
+  for each option set and block size it reports streaming throughput and round trip latency percentiles,
+  the round trip is one block to the receiver and one byte back
+*/
+
+#include "utils/tcp_utils.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#define PORT     12420 // one port per option set, listen socket of create_tcp_socket stays open
+#define NSTREAM  (64UL*1024*1024)  // bytes per throughput run
+#define NPING    1000              // round trips per latency run
+
+struct option_set{
+  const char *name;
+  tcp_options_t options;
+};
+
+static size_t blocksizes[] = {4096, 65536, 1UL << 20};
+
+// Send one block, a corked socket is uncorked after the block so that its tail goes out
+static void send_block(int sock, char *buf, size_t blocksize, int cork){
+  sendbuf_tcp(sock, buf, blocksize);
+  if(cork == 1){
+    int flag = 0;
+    setsockopt(sock, IPPROTO_TCP, TCP_CORK, &flag, sizeof(flag));
+    flag = 1;
+    setsockopt(sock, IPPROTO_TCP, TCP_CORK, &flag, sizeof(flag));
+  }
+}
+
+// Per block size: stream NSTREAM bytes, then NPING blocks each answered with one byte
+static void receive(int port, tcp_options_t options){
+  int sock;
+  if(create_tcp_socket((char *)"127.0.0.1", port, sock, 1, 0, -1, 0, TCP_RECV)){
+    exit(EXIT_FAILURE);
+  }
+  // Acks go out right away, cork is for the sender only
+  options.cork = TCP_OPTION_DEFAULT;
+  apply_tcp_options(sock, &options);
+
+  std::vector<char> buf(1UL << 20);
+  char ack = 1;
+  for(size_t blocksize : blocksizes){
+    for(uint64_t i = 0; i < NSTREAM; i += blocksize){
+      if(recvbuf_tcp(sock, buf.data(), blocksize)){
+	exit(EXIT_FAILURE);
+      }
+    }
+    for(int i = 0; i < NPING; i++){
+      if(recvbuf_tcp(sock, buf.data(), blocksize) || sendbuf_tcp(sock, &ack, 1)){
+	exit(EXIT_FAILURE);
+      }
+    }
+  }
+  close(sock);
+}
+
+int main(int argc, char *argv[]) {
+
+  std::vector<option_set> sets;
+  option_set set;
+
+  set.name = "default";
+  tcp_default_options(&set.options);
+  sets.push_back(set);
+
+  set.name = "nodelay";
+  tcp_default_options(&set.options);
+  set.options.nodelay = 1;
+  sets.push_back(set);
+
+  set.name = "cork_per_block";
+  tcp_default_options(&set.options);
+  set.options.cork = 1;
+  sets.push_back(set);
+
+  set.name = "nodelay+quickack";
+  tcp_default_options(&set.options);
+  set.options.nodelay  = 1;
+  set.options.quickack = 1;
+  sets.push_back(set);
+
+  set.name = "notsent_lowat";
+  tcp_default_options(&set.options);
+  set.options.notsent_lowat = 131072;
+  sets.push_back(set);
+
+  set.name = "buf4M_force";
+  tcp_default_options(&set.options);
+  set.options.sndbuf = set.options.rcvbuf = 4 << 20;
+  set.options.force  = 1;
+  sets.push_back(set);
+
+  set.name = "reno";
+  tcp_default_options(&set.options);
+  strcpy(set.options.congestion, "reno");
+  sets.push_back(set);
+
+  set.name = "bbr";
+  tcp_default_options(&set.options);
+  strcpy(set.options.congestion, "bbr");
+  sets.push_back(set);
+
+  fprintf(stdout, "%18s %10s %10s %10s %10s %10s %10s %10s\n",
+	  "OPTIONS", "BLOCK", "SNDBUF", "RCVBUF", "Gbps", "P50_us", "P99_us", "P999_us");
+
+  int port = PORT;
+  std::vector<char> buf(1UL << 20);
+  std::vector<double> rtts(NPING);
+  for(option_set &s : sets){
+    std::thread receiver(receive, port, s.options);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    int sock;
+    if(create_tcp_socket((char *)"127.0.0.1", port, sock, 0, 0, -1, 0, TCP_SEND)){
+      exit(EXIT_FAILURE);
+    }
+    port++;
+    if(apply_tcp_options(sock, &s.options)){
+      // For example bbr is not allowed or we do not have CAP_NET_ADMIN, run with what we got
+      fprintf(stdout, "%18s could not be applied fully\n", s.name);
+    }
+
+    for(size_t blocksize : blocksizes){
+      auto start = std::chrono::steady_clock::now();
+      for(uint64_t i = 0; i < NSTREAM; i += blocksize){
+	send_block(sock, buf.data(), blocksize, s.options.cork);
+      }
+      double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+      char ack;
+      for(int i = 0; i < NPING; i++){
+	auto t0 = std::chrono::steady_clock::now();
+	send_block(sock, buf.data(), blocksize, s.options.cork);
+	recvbuf_tcp(sock, &ack, 1);
+	rtts[i] = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+      }
+      std::sort(rtts.begin(), rtts.end());
+
+      fprintf(stdout, "%18s %10zu %10d %10d %10.3f %10.1f %10.1f %10.1f\n",
+	      s.name, blocksize, s.options.sndbuf_granted, s.options.rcvbuf_granted,
+	      NSTREAM*8/elapsed/1E9, rtts[NPING/2], rtts[NPING*99/100], rtts[NPING*999/1000]);
+    }
+
+    close(sock);
+    receiver.join();
+  }
+
+  return EXIT_SUCCESS;
+}
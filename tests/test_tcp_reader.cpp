@@ -0,0 +1,87 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+/*
+  Loopback benchmark of TcpReader,
+  it sweeps read sizes, receive socket buffer sizes and SO_RCVLOWAT and reports Gbps and syscalls/MB
+*/
+
+#include "utils/tcp_utils.h"
+#include "utils/tcp_reader.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include <chrono>
+#include <thread>
+
+#define NBYTE     (256UL*1024*1024)
+#define CHUNK     (1UL*1024*1024)
+#define PORT      12360 // one port per run up to PORT+31, listen socket of create_tcp_socket stays open
+
+static void send_stream(int port){
+  // Let receiver listen
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+  int sock;
+  if(create_tcp_socket((char *)"127.0.0.1", port, sock, 0, 0, -1, 0, TCP_SEND)){
+    exit(EXIT_FAILURE);
+  }
+
+  char *buf = (char *)calloc(CHUNK, 1);
+  for(uint64_t i = 0; i < NBYTE; i += CHUNK){
+    sendbuf_tcp(sock, buf, CHUNK);
+  }
+  free(buf);
+  close(sock);
+}
+
+int main(int argc, char *argv[]) {
+
+  size_t readsizes[] = {4096, 65536, 1UL << 20, 8UL << 20};
+  int bufszs[]  = {0, 1, 4, 16}; // MBytes, 0 is kernel default
+  int lowats[]  = {0, 65536};
+
+  fprintf(stdout, "%10s %8s %8s %10s %14s %10s\n",
+	  "READSIZE", "RCVBUF", "LOWAT", "Gbps", "SYSCALLS/MB", "DIRECT");
+
+  int port = PORT;
+  char *dst = (char *)malloc(8UL << 20);
+  for(int bufsz : bufszs){
+    for(int lowat : lowats){
+      for(size_t readsize : readsizes){
+	std::thread sender(send_stream, port);
+
+	int sock;
+	if(create_tcp_socket((char *)"127.0.0.1", port, sock, 1, bufsz, -1, 0, TCP_RECV)){
+	  fprintf(stderr, "TEST_TCP_READER_ERROR: Could not accept on port %d, "
+		  "which happens at \"%s\", line [%d], has to abort.\n",
+		  port, __FILE__, __LINE__);
+	  exit(EXIT_FAILURE);
+	}
+	port++;
+
+	TcpReader reader(sock, 1 << 20, lowat);
+	auto start = std::chrono::steady_clock::now();
+	for(uint64_t i = 0; i < NBYTE; i += readsize){
+	  if(reader.read(dst, readsize)){
+	    exit(EXIT_FAILURE);
+	  }
+	}
+	double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	sender.join();
+	close(sock);
+
+	fprintf(stdout, "%10zu %8d %8d %10.3f %14.3f %10.2f\n",
+		readsize, bufsz, lowat, NBYTE*8/elapsed/1E9,
+		reader.nsyscall_total/(NBYTE/1E6), reader.ndirect_total/(double)reader.nbyte_total);
+      }
+    }
+  }
+  free(dst);
+
+  return EXIT_SUCCESS;
+}
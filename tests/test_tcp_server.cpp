@@ -0,0 +1,133 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "utils/tcp_utils.h"
+#include "utils/tcp_server.h"
+
+#include <stdint.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest/doctest.h"
+
+using namespace std;
+
+#define PORT 12400
+
+// Every client sends NBYTE bytes, byte i of client c is (c + i)%251
+#define NBYTE (1 << 20)
+
+static void client(int port, int c){
+  int sock;
+  REQUIRE(create_tcp_socket((char *)"127.0.0.1", port, sock, 0, 0, -1, 0, TCP_SEND) == EXIT_SUCCESS);
+
+  // First 4 bytes tell the server who we are
+  vector<char> buf(4 + NBYTE);
+  memcpy(buf.data(), &c, 4);
+  for(int i = 0; i < NBYTE; i++){
+    buf[4 + i] = (char)((c + i)%251);
+  }
+  REQUIRE(sendbuf_tcp(sock, buf.data(), buf.size()) == EXIT_SUCCESS);
+  close(sock);
+}
+
+struct stream_state{
+  uint64_t nbyte = 0;
+  char id[4];
+  int c = -1;
+  uint64_t nbad = 0;
+};
+
+TEST_CASE("TcpServer serves concurrent streams and reuses buffers") {
+  const int nclient = 16;
+  const int nwave   = 2;
+
+  for(int nthread = 1; nthread <= 2; nthread++){
+    const int port = PORT + nthread;
+    TcpServer server((char *)"127.0.0.1", port, nthread, 65536);
+
+    mutex lock;
+    vector<uint64_t> nbytes(nclient, 0), nbads(nclient, 0);
+
+    server.start(
+      [](struct tcp_connection &conn, const char *data, size_t nbytes){
+	stream_state *state = (stream_state *)conn.user;
+	for(size_t i = 0; i < nbytes; i++, state->nbyte++){
+	if(state->nbyte < 4){
+	  state->id[state->nbyte] = data[i];
+	  if(state->nbyte == 3){
+	    memcpy(&state->c, state->id, 4);
+	  }
+	  continue;
+	}
+	state->nbad += (data[i] != (char)((state->c + state->nbyte - 4)%251));
+	}
+	return EXIT_SUCCESS;
+      },
+      [](struct tcp_connection &conn){conn.user = new stream_state;},
+      [&](struct tcp_connection &conn){
+	stream_state *state = (stream_state *)conn.user;
+	lock.lock();
+	if(state->c >= 0 && state->c < nclient){
+	nbytes[state->c] += state->nbyte - 4;
+	nbads[state->c]  += state->nbad;
+	}
+	lock.unlock();
+	delete state;
+      });
+
+    for(int wave = 0; wave < nwave; wave++){
+      vector<thread> clients;
+      for(int c = 0; c < nclient; c++){
+	clients.emplace_back(client, port, c);
+      }
+      for(auto &t : clients){
+	t.join();
+      }
+
+      // Wait until the server sees all connections closed
+      for(int i = 0; i < 500 && server.nclose_total < (uint64_t)nclient*(wave + 1); i++){
+	this_thread::sleep_for(chrono::milliseconds(10));
+      }
+      REQUIRE(server.nclose_total == (uint64_t)nclient*(wave + 1));
+    }
+    server.stop();
+
+    CHECK(server.naccept_total == (uint64_t)nclient*nwave);
+    CHECK(server.nbyte_total == (uint64_t)nclient*nwave*(4 + NBYTE));
+    for(int c = 0; c < nclient; c++){
+      CHECK(nbytes[c] == (uint64_t)nwave*NBYTE);
+      CHECK(nbads[c] == 0);
+    }
+
+    // The second wave takes buffers of the first one, a worker only reuses its own buffers
+    CHECK(server.nbuffer_total <= (uint64_t)nclient*nthread);
+  }
+}
+
+TEST_CASE("TcpServer closes a connection when handler asks for it") {
+  TcpServer server((char *)"127.0.0.1", PORT + 3, 1, 4096);
+
+  server.start([](struct tcp_connection &, const char *, size_t){return EXIT_FAILURE;});
+
+  int sock;
+  REQUIRE(create_tcp_socket((char *)"127.0.0.1", PORT + 3, sock, 0, 0, 1.0, 0, TCP_SEND) == EXIT_SUCCESS);
+  char byte = 1;
+  REQUIRE(send(sock, &byte, 1, 0) == 1);
+
+  // Server side close shows up as end of stream
+  struct timeval tout = {1, 0};
+  setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tout, sizeof(tout));
+  CHECK(recv(sock, &byte, 1, 0) == 0);
+  close(sock);
+
+  server.stop();
+  CHECK(server.naccept_total == 1);
+  CHECK(server.nclose_total == 1);
+}
@@ -0,0 +1,88 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "utils/tcp_utils.h"
+#include "utils/tcp_splicecapture.h"
+
+#include <stdint.h>
+#include <sys/stat.h>
+
+#include <thread>
+#include <vector>
+
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest/doctest.h"
+
+using namespace std;
+
+#define NBYTE     (10 << 20)
+#define FILE_SIZE (3 << 20)
+#define TCP_PORT  12410
+
+static char pattern(uint64_t i){
+  return (char)(i*31 + (i >> 12));
+}
+
+TEST_CASE("TcpSpliceCapture writes a TCP stream into rotated files and samples it") {
+  char dir[] = "/tmp/test_tcp_splicecapture_XXXXXX";
+  REQUIRE(mkdtemp(dir) != NULL);
+  char prefix[PATH_MAX];
+  snprintf(prefix, sizeof(prefix), "%s/capture", dir);
+
+  thread sender([](){
+    this_thread::sleep_for(chrono::milliseconds(100));
+    int sock;
+    REQUIRE(create_tcp_socket((char *)"127.0.0.1", TCP_PORT, sock, 0, 0, -1, 0, TCP_SEND) == EXIT_SUCCESS);
+    vector<char> buf(NBYTE);
+    for(uint64_t i = 0; i < NBYTE; i++){
+      buf[i] = pattern(i);
+    }
+    REQUIRE(sendbuf_tcp(sock, buf.data(), NBYTE) == EXIT_SUCCESS);
+    close(sock);
+  });
+
+  int sock;
+  REQUIRE(create_tcp_socket((char *)"127.0.0.1", TCP_PORT, sock, 1, 0, -1, 0, TCP_RECV) == EXIT_SUCCESS);
+
+  uint64_t nbad_sample = 0, nsample = 0, last_offset = 0;
+  TcpSpliceCapture capture(sock, prefix, FILE_SIZE, 4096, 1 << 20,
+			   [&](uint64_t offset, const char *data, size_t nbytes){
+			     for(size_t i = 0; i < nbytes; i++){
+			       nbad_sample += (data[i] != pattern(offset + i));
+			     }
+			     CHECK((nsample == 0 || offset > last_offset));
+			     last_offset = offset;
+			     nsample++;
+			   });
+  CHECK(capture.capture() == EXIT_SUCCESS);
+  sender.join();
+  close(sock);
+
+  CHECK(capture.nbyte_total == NBYTE);
+  CHECK(capture.nfile == 4);
+  CHECK(nsample == capture.nsample_total);
+  CHECK(nsample >= 8); // about one every MiB
+  CHECK(nsample <= 10);
+  CHECK(nbad_sample == 0);
+
+  // Files end at FILE_SIZE and are named after their stream offset
+  vector<char> buf(FILE_SIZE);
+  for(uint64_t offset = 0; offset < NBYTE; offset += FILE_SIZE){
+    char fname[PATH_MAX + 32];
+    snprintf(fname, sizeof(fname), "%s_%016" PRIu64 ".raw", prefix, offset);
+    FILE *fp = fopen(fname, "rb");
+    REQUIRE(fp != NULL);
+    size_t expected = NBYTE - offset < FILE_SIZE ? NBYTE - offset : FILE_SIZE;
+    CHECK(fread(buf.data(), 1, FILE_SIZE, fp) == expected);
+    fclose(fp);
+    unlink(fname);
+
+    uint64_t nbad = 0;
+    for(size_t i = 0; i < expected; i++){
+      nbad += (buf[i] != pattern(offset + i));
+    }
+    CHECK(nbad == 0);
+  }
+  rmdir(dir);
+}
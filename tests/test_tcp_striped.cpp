@@ -0,0 +1,85 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+/*
+  Loopback benchmark of TcpStripedSender and TcpStripedReceiver,
+  it sweeps number of streams and stripe size and reports Gbps,
+  the first block of every run is checked after reassembly
+*/
+
+#include "utils/tcp_utils.h"
+#include "utils/tcp_striped.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include <chrono>
+#include <thread>
+
+#define BLOCKSZ   (64UL*1024*1024)
+#define NBLOCK    16
+#define PORT      12440 // each run takes nstream ports, listen sockets of create_tcp_socket stay open
+
+static void send_blocks(int port, int nstream, uint64_t stripe_size, const char *block){
+  // Let receiver listen
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  TcpStripedSender sender((char *)"127.0.0.1", port, nstream, stripe_size);
+  for(int i = 0; i < NBLOCK; i++){
+    if(sender.send(block, BLOCKSZ)){
+      exit(EXIT_FAILURE);
+    }
+  }
+}
+
+int main(int argc, char *argv[]) {
+
+  int nstreams[] = {1, 2, 4, 8};
+  uint64_t stripe_sizes[] = {256UL*1024, 1UL << 20, 4UL << 20};
+
+  char *src = (char *)malloc(BLOCKSZ);
+  char *dst = (char *)malloc(BLOCKSZ);
+  for(uint64_t i = 0; i < BLOCKSZ/sizeof(uint32_t); i++){
+    ((uint32_t *)src)[i] = i;
+  }
+
+  fprintf(stdout, "%8s %12s %10s\n", "NSTREAM", "STRIPE", "Gbps");
+
+  int port = PORT;
+  for(int nstream : nstreams){
+    for(uint64_t stripe_size : stripe_sizes){
+      std::thread sender(send_blocks, port, nstream, stripe_size, src);
+
+      TcpStripedReceiver receiver((char *)"127.0.0.1", port, nstream, stripe_size);
+      port += nstream;
+
+      uint64_t nbytes;
+      memset(dst, 0, BLOCKSZ);
+      auto start = std::chrono::steady_clock::now();
+      for(int i = 0; i < NBLOCK; i++){
+	if(receiver.receive(dst, BLOCKSZ, nbytes) || nbytes != BLOCKSZ){
+	  exit(EXIT_FAILURE);
+	}
+	if(i == 0 && memcmp(src, dst, BLOCKSZ)){
+	  fprintf(stderr, "TEST_TCP_STRIPED_ERROR: Block is not reassembled in order, "
+		  "which happens at \"%s\", line [%d], has to abort.\n",
+		  __FILE__, __LINE__);
+	  exit(EXIT_FAILURE);
+	}
+      }
+      double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      sender.join();
+
+      fprintf(stdout, "%8d %12" PRIu64 " %10.3f\n",
+	      nstream, stripe_size, receiver.nbyte_total*8/elapsed/1E9);
+    }
+  }
+
+  free(src);
+  free(dst);
+
+  return EXIT_SUCCESS;
+}
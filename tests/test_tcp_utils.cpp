@@ -0,0 +1,228 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "utils/tcp_utils.h"
+#include "utils/tcp_reader.h"
+
+#include <stdint.h>
+#include <signal.h>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest/doctest.h"
+
+using namespace std;
+
+#define TCP_PORT 12356
+
+// Receive everything the peer sends on a fresh connection
+static void receive_all(int port, vector<char> &received){
+  int sock;
+  REQUIRE(create_tcp_socket((char *)"127.0.0.1", port, sock, 1, 0, -1, 0, TCP_RECV) == EXIT_SUCCESS);
+
+  // Read slowly at the start, so that the sender sees a full socket
+  this_thread::sleep_for(chrono::milliseconds(50));
+  char buf[65536];
+  ssize_t n;
+  while((n = recv(sock, buf, sizeof(buf), 0)) > 0){
+    received.insert(received.end(), buf, buf + n);
+  }
+  close(sock);
+}
+
+TEST_CASE("sendbufv_tcp sends header and segments in order on a nonblocking socket") {
+  vector<char> received;
+  thread receiver(receive_all, TCP_PORT, ref(received));
+  this_thread::sleep_for(chrono::milliseconds(100));
+
+  int sock;
+  REQUIRE(create_tcp_socket((char *)"127.0.0.1", TCP_PORT, sock, 0, 0, -1, 0, TCP_SEND) == EXIT_SUCCESS);
+
+  // Small send buffer and nonblocking mode give partial writes and EAGAIN
+  int nbyte = 16384;
+  setsockopt(sock, SOL_SOCKET, SO_SNDBUF, &nbyte, sizeof(nbyte));
+  fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK);
+
+  // Header, an empty segment, a large block and many small segments, more than TCP_IOV_MAX
+  const int nsmall = 3*TCP_IOV_MAX;
+  vector<char> header(4096, 'h');
+  vector<char> block(32 << 20);
+  for(size_t i = 0; i < block.size(); i++){
+    block[i] = (char)(i*7);
+  }
+  vector<char> smalls(nsmall*3);
+  for(size_t i = 0; i < smalls.size(); i++){
+    smalls[i] = (char)(i/3);
+  }
+
+  vector<struct iovec> iov;
+  iov.push_back({header.data(), header.size()});
+  iov.push_back({block.data(), 0});
+  iov.push_back({block.data(), block.size()});
+  for(int i = 0; i < nsmall; i++){
+    iov.push_back({smalls.data() + 3*i, 3});
+  }
+
+  uint64_t nsent = 0;
+  CHECK(sendbufv_tcp(sock, iov.data(), iov.size(), &nsent) == EXIT_SUCCESS);
+  close(sock);
+  receiver.join();
+
+  vector<char> expected(header);
+  expected.insert(expected.end(), block.begin(), block.end());
+  expected.insert(expected.end(), smalls.begin(), smalls.end());
+
+  CHECK(nsent == expected.size());
+  REQUIRE(received.size() == expected.size());
+  CHECK(received == expected);
+}
+
+TEST_CASE("sendbufv_tcp reports failure on a closed connection") {
+  int fds[2];
+  REQUIRE(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+  close(fds[1]);
+
+  // Without MSG_NOSIGNAL the write raises SIGPIPE, same as sendbuf_tcp
+  signal(SIGPIPE, SIG_IGN);
+
+  char buf[16] = {0};
+  struct iovec iov = {buf, sizeof(buf)};
+  uint64_t nsent = 1;
+  CHECK(sendbufv_tcp(fds[0], &iov, 1, &nsent) == EXIT_FAILURE);
+  CHECK(nsent == 0);
+  close(fds[0]);
+}
+
+TEST_CASE("sendbufv_tcp honors socket timeout when the peer never reads") {
+  int fds[2];
+  REQUIRE(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+
+  // Blocking socket with a send timeout, the kernel tells the timeout with EAGAIN
+  struct timeval tout = {0, 100000};
+  setsockopt(fds[0], SOL_SOCKET, SO_SNDTIMEO, &tout, sizeof(tout));
+
+  vector<char> block(64 << 20);
+  struct iovec iov = {block.data(), block.size()};
+  uint64_t nsent = 0;
+  auto start = chrono::steady_clock::now();
+  CHECK(sendbufv_tcp(fds[0], &iov, 1, &nsent) == EXIT_FAILURE);
+  auto elapsed = chrono::steady_clock::now() - start;
+
+  // Part of the block fits the socket buffers, the rest times out instead of waiting forever
+  CHECK(nsent > 0);
+  CHECK(nsent < block.size());
+  CHECK(elapsed < chrono::seconds(5));
+
+  close(fds[0]);
+  close(fds[1]);
+}
+
+TEST_CASE("recvbuf_tcp fills exact count and honors socket timeout") {
+  int fds[2];
+  REQUIRE(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+
+  struct timeval tout = {0, 100000};
+  setsockopt(fds[0], SOL_SOCKET, SO_RCVTIMEO, &tout, sizeof(tout));
+
+  // Data arrives in pieces, one call still gets all of it
+  thread sender([&](){
+    char buf[1000];
+    for(int i = 0; i < 10; i++){
+      memset(buf, i, sizeof(buf));
+      REQUIRE(write(fds[1], buf, sizeof(buf)) == (ssize_t)sizeof(buf));
+      this_thread::sleep_for(chrono::milliseconds(5));
+    }
+  });
+
+  vector<char> buf(10000);
+  uint64_t nreceived = 0;
+  CHECK(recvbuf_tcp(fds[0], buf.data(), buf.size(), &nreceived) == EXIT_SUCCESS);
+  sender.join();
+  CHECK(nreceived == buf.size());
+  CHECK(buf[0] == 0);
+  CHECK(buf[9999] == 9);
+
+  // Only half of the request shows up before timeout
+  REQUIRE(write(fds[1], buf.data(), 500) == 500);
+  CHECK(recvbuf_tcp(fds[0], buf.data(), 1000, &nreceived) == EXIT_FAILURE);
+  CHECK(nreceived == 500);
+
+  close(fds[0]);
+  close(fds[1]);
+}
+
+TEST_CASE("TcpReader mixes small buffered reads and large direct reads") {
+  int fds[2];
+  REQUIRE(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+
+  // Frames of a 16 bytes header and a payload of the size in the header
+  const int nframe = 32;
+  thread sender([&](){
+    for(int i = 0; i < nframe; i++){
+      uint64_t size = (i%2) ? 3000 : 200000;
+      char header[16] = {0};
+      memcpy(header, &size, sizeof(size));
+      vector<char> payload(size, (char)i);
+      struct iovec iov[2] = {{header, sizeof(header)}, {payload.data(), payload.size()}};
+      REQUIRE(sendbufv_tcp(fds[1], iov, 2) == EXIT_SUCCESS);
+    }
+    close(fds[1]);
+  });
+
+  TcpReader reader(fds[0], 65536, 16);
+  vector<char> payload(200000);
+  uint64_t nexpected = 0;
+  for(int i = 0; i < nframe; i++){
+    const char *header = reader.next(16);
+    REQUIRE(header != NULL);
+    uint64_t size;
+    memcpy(&size, header, sizeof(size));
+    REQUIRE(size == (uint64_t)((i%2) ? 3000 : 200000));
+
+    REQUIRE(reader.read(payload.data(), size) == EXIT_SUCCESS);
+    CHECK(payload[0] == (char)i);
+    CHECK(payload[size - 1] == (char)i);
+    nexpected += 16 + size;
+  }
+  sender.join();
+
+  CHECK(reader.nbyte_total == nexpected);
+  CHECK(reader.ndirect_total > 0);
+  CHECK(reader.next(1) == NULL); // peer closed
+  close(fds[0]);
+}
+
+TEST_CASE("apply_tcp_options sets options and reads back granted buffers") {
+  int sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+  REQUIRE(sock >= 0);
+
+  tcp_options_t options;
+  tcp_default_options(&options);
+  options.nodelay = 1;
+  options.notsent_lowat = 65536;
+  options.sndbuf = 1 << 20;
+  strcpy(options.congestion, "reno");
+  REQUIRE(apply_tcp_options(sock, &options) == EXIT_SUCCESS);
+
+  int value = 0;
+  socklen_t len = sizeof(value);
+  getsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &value, &len);
+  CHECK(value == 1);
+
+  char congestion[16] = {0};
+  len = sizeof(congestion);
+  getsockopt(sock, IPPROTO_TCP, TCP_CONGESTION, congestion, &len);
+  CHECK(strcmp(congestion, "reno") == 0);
+
+  // Kernel doubles the request, unless it is capped by wmem_max
+  CHECK(options.sndbuf_granted > 0);
+  CHECK(options.rcvbuf_granted > 0);
+
+  strcpy(options.congestion, "no_such_algorithm");
+  CHECK(apply_tcp_options(sock, &options) == EXIT_FAILURE);
+  close(sock);
+}
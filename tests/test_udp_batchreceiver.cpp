@@ -0,0 +1,80 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+/*
+  Loopback benchmark of UdpBatchReceiver,
+  it reports packets/s and syscalls/packet for different batch sizes
+*/
+
+#include "utils/udp_utils.h"
+#include "utils/udp_batchreceiver.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include <chrono>
+#include <thread>
+
+#define PKT_SIZE 8200
+#define NPACKET  200000
+#define PORT     12345
+
+static void send_packets(int npacket){
+  int sock;
+  if(create_udp_socket((char *)"127.0.0.1", NULL, PORT, sock, 0, 0, -1, UDP_UNICAST, UDP_SEND)){
+    exit(EXIT_FAILURE);
+  }
+
+  char pkt[PKT_SIZE] = {0};
+  for(uint64_t i = 0; i < (uint64_t)npacket; i++){
+    memcpy(pkt, &i, sizeof(i));
+    send(sock, pkt, PKT_SIZE, 0);
+  }
+  close(sock);
+}
+
+int main(int argc, char *argv[]) {
+
+  int nbatches[] = {1, 4, 16, 64, 256};
+
+  fprintf(stdout, "%8s %12s %12s %14s %16s %10s %10s\n",
+	  "NBATCH", "NSENT", "NRECEIVED", "PACKETS/s", "SYSCALLS/PACKET", "TRUNCATED", "SHORT");
+
+  for(int nbatch : nbatches){
+    int sock;
+    if(create_udp_socket(NULL, NULL, PORT, sock, 1, 64, 0.5, UDP_UNICAST, UDP_RECV)){
+      fprintf(stderr, "TEST_UDP_BATCHRECEIVER_ERROR: Could not create receive socket, "
+	      "which happens at \"%s\", line [%d], has to abort.\n",
+	      __FILE__, __LINE__);
+      exit(EXIT_FAILURE);
+    }
+
+    UdpBatchReceiver receiver(sock, PKT_SIZE, nbatch);
+    std::thread sender(send_packets, NPACKET);
+
+    // The first packet starts the clock, socket timeout tells us the sender is done
+    std::chrono::steady_clock::time_point start, stop;
+    bool started = false;
+    while(receiver.receive() > 0){
+      if(!started){
+	start = std::chrono::steady_clock::now();
+	started = true;
+      }
+      stop = std::chrono::steady_clock::now();
+    }
+    sender.join();
+    close(sock);
+
+    double elapsed = std::chrono::duration<double>(stop - start).count();
+    fprintf(stdout, "%8d %12d %12" PRIu64 " %14.0f %16.4f %10" PRIu64 " %10" PRIu64 "\n",
+	    nbatch, NPACKET, receiver.npacket_total,
+	    elapsed > 0 ? receiver.npacket_total/elapsed : 0.0,
+	    receiver.nsyscall_total/(double)receiver.npacket_total,
+	    receiver.ntruncated_total, receiver.nshort_total);
+  }
+
+  return EXIT_SUCCESS;
+}
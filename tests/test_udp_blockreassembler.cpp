@@ -0,0 +1,179 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "utils/udp_blockreassembler.h"
+
+#include <stdint.h>
+#include <sys/socket.h>
+
+#include <algorithm>
+#include <map>
+#include <random>
+#include <vector>
+
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest/doctest.h"
+
+using namespace std;
+
+#define PKT_HDR_SIZE 8
+#define PKT_DAT_SIZE 256
+#define NPKT         32
+#define NBATCH       16
+#define NWINDOW      2
+#define FIRST        1000
+
+// Unix datagram socket pair keeps packet order, so that each test case is deterministic
+class Stream{
+public:
+  int socks[2];
+  map<uint64_t, vector<char>> blocks;
+  map<uint64_t, udp_block_stat_t> stats;
+  uint64_t nskip = 0;
+
+  Stream(){
+    REQUIRE(socketpair(AF_UNIX, SOCK_DGRAM, 0, socks) == 0);
+    int nbyte = 16*1024*1024;
+    setsockopt(socks[0], SOL_SOCKET, SO_SNDBUF, &nbyte, sizeof(nbyte));
+    setsockopt(socks[1], SOL_SOCKET, SO_RCVBUF, &nbyte, sizeof(nbyte));
+    int flags = fcntl(socks[1], F_GETFL, 0);
+    fcntl(socks[1], F_SETFL, flags | O_NONBLOCK);
+  }
+
+  ~Stream(){
+    close(socks[0]);
+    close(socks[1]);
+  }
+
+  void send(uint64_t counter){
+    char pkt[PKT_HDR_SIZE + PKT_DAT_SIZE];
+    memcpy(pkt, &counter, PKT_HDR_SIZE);
+    memset(pkt + PKT_HDR_SIZE, (int)(counter%251) + 1, PKT_DAT_SIZE);
+    REQUIRE(::send(socks[0], pkt, sizeof(pkt), 0) == (ssize_t)sizeof(pkt));
+  }
+
+  // Returns number of payload copies in user space
+  uint64_t run(){
+    UdpBlockReassembler reassembler(socks[1], PKT_HDR_SIZE, PKT_DAT_SIZE, NPKT, NBATCH, NWINDOW,
+				    [&](uint64_t iblock){
+				      blocks[iblock].assign((size_t)NPKT*PKT_DAT_SIZE, (char)0xff);
+				      return blocks[iblock].data();
+				    },
+				    [&](char *block, const udp_block_stat_t &stat){
+				      stats[stat.iblock] = stat;
+				    });
+    while(reassembler.receive(0) > 0){}
+    reassembler.flush();
+
+    nskip = reassembler.nskip_total;
+    return reassembler.ncopy_total;
+  }
+
+  // Slot content should be the counter pattern if received, zeros otherwise
+  bool slot_is(uint64_t counter, bool received){
+    uint64_t c = counter - FIRST;
+    const char *slot = blocks[c/NPKT].data() + (c%NPKT)*PKT_DAT_SIZE;
+    char expected = received ? (char)((counter%251) + 1) : 0;
+    for(int i = 0; i < PKT_DAT_SIZE; i++){
+      if(slot[i] != expected){
+	return false;
+      }
+    }
+    return true;
+  }
+};
+
+TEST_CASE("udp_counter_le") {
+  char hdr[PKT_HDR_SIZE] = {0x01, 0x02, 0x03, 0, 0, 0, 0, 0};
+  CHECK(udp_counter_le(hdr, PKT_HDR_SIZE) == 0x030201);
+  CHECK(udp_counter_le(hdr, 2) == 0x0201);
+}
+
+TEST_CASE("UdpBlockReassembler in order stream") {
+  Stream stream;
+  for(uint64_t c = FIRST; c < FIRST + 4*NPKT; c++){
+    stream.send(c);
+  }
+  // Only the first batch lands in scratch before we know the first counter
+  CHECK(stream.run() == NBATCH);
+
+  // The block after the stream end is already open for the next in order packet
+  REQUIRE(stream.stats.size() == 5);
+  CHECK(stream.stats[4].nreceived == 0);
+  for(uint64_t b = 0; b < 4; b++){
+    CHECK(stream.stats[b].nreceived == NPKT);
+    CHECK(stream.stats[b].nlost == 0);
+    CHECK(stream.stats[b].nreordered == 0);
+  }
+  for(uint64_t c = FIRST; c < FIRST + 4*NPKT; c++){
+    CHECK(stream.slot_is(c, true));
+  }
+}
+
+TEST_CASE("UdpBlockReassembler reorder, duplicate, loss and late packets") {
+  Stream stream;
+
+  // Shuffle within small groups, drop some and duplicate some
+  vector<uint64_t> counters;
+  for(uint64_t c = FIRST; c < FIRST + 6*NPKT; c++){
+    counters.push_back(c);
+  }
+  mt19937 gen(42);
+  for(size_t i = 0; i + 8 <= counters.size(); i += 8){
+    shuffle(counters.begin() + i, counters.begin() + i + 8, gen);
+  }
+  // Swap a pair inside a batch, which forms a cycle
+  swap(counters[1], counters[2]);
+
+  vector<uint64_t> lost = {FIRST + 5, FIRST + NPKT + 7, FIRST + 3*NPKT + 31};
+  for(uint64_t c : lost){
+    counters.erase(find(counters.begin(), counters.end(), c));
+  }
+  counters.insert(counters.begin() + 40, FIRST + 38); // duplicate
+  counters.push_back(FIRST + 3);                      // late, its block is closed
+
+  // The first packet sets the block boundary
+  counters.erase(find(counters.begin(), counters.end(), (uint64_t)FIRST));
+  counters.insert(counters.begin(), FIRST);
+
+  for(uint64_t c : counters){
+    stream.send(c);
+  }
+  stream.run();
+
+  int nlost = 0, nduplicate = 0, nreceived = 0;
+  for(auto &kv : stream.stats){
+    nlost      += kv.second.nlost;
+    nduplicate += kv.second.nduplicate;
+    nreceived  += kv.second.nreceived;
+  }
+  CHECK(nduplicate == 1);
+  CHECK(nreceived == 6*NPKT - (int)lost.size());
+  CHECK(nlost == (int)(stream.stats.size()*NPKT) - nreceived);
+
+  for(uint64_t c = FIRST; c < FIRST + 6*NPKT; c++){
+    bool received = find(lost.begin(), lost.end(), c) == lost.end();
+    CHECK(stream.slot_is(c, received));
+  }
+}
+
+TEST_CASE("UdpBlockReassembler far jump of the counter restarts the window") {
+  Stream stream;
+  const uint64_t jump = 1000000000ULL*NPKT;
+
+  for(uint64_t c = FIRST; c < FIRST + NPKT; c++){
+    stream.send(c);
+  }
+  for(uint64_t c = FIRST + jump; c < FIRST + jump + NPKT; c++){
+    stream.send(c);
+  }
+  stream.run();
+
+  // Only the window before the jump and the window at the jump are opened
+  CHECK(stream.stats.size() == 2*NWINDOW);
+  CHECK(stream.nskip == jump/NPKT - NWINDOW);
+  CHECK(stream.stats[0].nreceived == NPKT);
+  CHECK(stream.stats[jump/NPKT].nreceived == NPKT);
+  CHECK(stream.stats[jump/NPKT].nlost == 0);
+}
@@ -0,0 +1,117 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+/*
+  Loopback throughput comparison of per-packet, batched and GSO/GRO UDP send and receive
+*/
+
+#include "utils/udp_utils.h"
+#include "utils/udp_batchreceiver.h"
+#include "utils/udp_pacedsender.h"
+#include "utils/udp_groreceiver.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include <chrono>
+#include <thread>
+
+#define PKT_SIZE 8200
+#define NPACKET  200000
+#define NBLOCK   64      // packets per send call
+#define PORT     12350
+#define TOUT     0.5
+
+enum io_mode {IO_PACKET = 0, IO_BATCH = 1, IO_GSO_GRO = 2};
+
+static void send_packets(enum io_mode mode, uint64_t *nsyscall){
+  // Let receiver get ready
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  int sock;
+  if(create_udp_socket((char *)"127.0.0.1", NULL, PORT, sock, 0, 0, -1, UDP_UNICAST, UDP_SEND)){
+    exit(EXIT_FAILURE);
+  }
+
+  char *buf = (char *)calloc((size_t)NBLOCK*PKT_SIZE, 1);
+  if(mode == IO_PACKET){
+    for(int i = 0; i < NPACKET; i++){
+      send(sock, buf, PKT_SIZE, 0);
+    }
+    *nsyscall = NPACKET;
+  }
+  else{
+    UdpPacedSender sender(sock, PKT_SIZE, mode == IO_GSO_GRO ? NBLOCK/7 + 1 : NBLOCK, 0, UDP_RATE_PPS, mode == IO_GSO_GRO);
+    for(int i = 0; i < NPACKET; i += NBLOCK){
+      sender.send(buf, NBLOCK);
+    }
+    *nsyscall = sender.nsyscall_total;
+  }
+
+  free(buf);
+  close(sock);
+}
+
+// Receive until time out and report, receiver needs receive() and npacket_total, nsyscall_total
+template <typename T>
+static void run(const char *name, enum io_mode mode, T &receiver){
+  uint64_t nsyscall_send = 0;
+  std::thread sender(send_packets, mode, &nsyscall_send);
+
+  std::chrono::steady_clock::time_point start, stop;
+  bool started = false;
+  while(receiver.receive() > 0){
+    if(!started){
+      start = std::chrono::steady_clock::now();
+      started = true;
+    }
+    stop = std::chrono::steady_clock::now();
+  }
+  sender.join();
+
+  double elapsed = std::chrono::duration<double>(stop - start).count();
+  double pps = elapsed > 0 ? receiver.npacket_total/elapsed : 0.0;
+  fprintf(stdout, "%10s %12" PRIu64 " %14.0f %10.3f %14.4f %14.4f\n",
+	  name, receiver.npacket_total, pps, pps*PKT_SIZE*8/1E9,
+	  nsyscall_send/(double)NPACKET,
+	  receiver.nsyscall_total/(double)receiver.npacket_total);
+}
+
+int main(int argc, char *argv[]) {
+
+  fprintf(stdout, "%10s %12s %14s %10s %14s %14s\n",
+	  "MODE", "NRECEIVED", "PACKETS/s", "Gbps", "SEND_SYSCALLS", "RECV_SYSCALLS");
+
+  {
+    int sock;
+    if(create_udp_socket(NULL, NULL, PORT, sock, 1, 64, TOUT, UDP_UNICAST, UDP_RECV)){
+      exit(EXIT_FAILURE);
+    }
+    UdpBatchReceiver packet_receiver(sock, PKT_SIZE, 1);
+    run("packet", IO_PACKET, packet_receiver);
+
+    UdpBatchReceiver batch_receiver(sock, PKT_SIZE, NBLOCK);
+    run("batch", IO_BATCH, batch_receiver);
+    close(sock);
+  }
+
+  {
+    int sock;
+    if(create_udp_socket(NULL, NULL, PORT, sock, 1, 64, TOUT, UDP_UNICAST, UDP_RECV, UDP_OPTION_GRO)){
+      fprintf(stderr, "TEST_UDP_GRORECEIVER_ERROR: Could not create GRO socket, "
+	      "which happens at \"%s\", line [%d], has to abort.\n",
+	      __FILE__, __LINE__);
+      exit(EXIT_FAILURE);
+    }
+    UdpGroReceiver receiver(sock, PKT_SIZE, NBLOCK/7 + 1);
+    run("gso_gro", IO_GSO_GRO, receiver);
+    fprintf(stdout, "gso_gro %" PRIu64 " coalesced buffers, %" PRIu64 " short and %" PRIu64 " truncated packets\n",
+	    receiver.nbuffer_total, receiver.nshort_total, receiver.ntruncated_total);
+    close(sock);
+  }
+
+  return EXIT_SUCCESS;
+}
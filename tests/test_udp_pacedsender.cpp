@@ -0,0 +1,97 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+/*
+  Loopback soak test of UdpPacedSender,
+  it sends at different target rates and reports the achieved send and receive rates
+*/
+
+#include "utils/udp_utils.h"
+#include "utils/udp_batchreceiver.h"
+#include "utils/udp_pacedsender.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include <chrono>
+#include <thread>
+
+#define PKT_SIZE 8200
+#define NBATCH   16
+#define NPACKET  50000
+#define PORT     12346
+
+static void receive_packets(uint64_t *nreceived){
+  int sock;
+  if(create_udp_socket(NULL, NULL, PORT, sock, 1, 64, 0.5, UDP_UNICAST, UDP_RECV)){
+    exit(EXIT_FAILURE);
+  }
+
+  UdpBatchReceiver receiver(sock, PKT_SIZE, NBATCH);
+  while(receiver.receive() > 0){}
+
+  *nreceived = receiver.npacket_total;
+  close(sock);
+}
+
+int main(int argc, char *argv[]) {
+
+  struct {double rate; enum udp_rate_unit unit;} targets[] = {
+    {0.2,    UDP_RATE_GBPS},
+    {1.0,    UDP_RATE_GBPS},
+    {5000,   UDP_RATE_PPS},
+    {50000,  UDP_RATE_PPS},
+  };
+
+  char *buf = (char *)calloc((size_t)NBATCH*PKT_SIZE, 1);
+
+  fprintf(stdout, "%12s %6s %14s %14s %12s %12s\n",
+	  "TARGET", "UNIT", "SENT_RATE", "SENT_PPS", "NSENT", "NRECEIVED");
+
+  for(auto target : targets){
+    uint64_t nreceived = 0;
+    std::thread receiver(receive_packets, &nreceived);
+    // Give receiver a chance to bind
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    int sock;
+    if(create_udp_socket((char *)"127.0.0.1", NULL, PORT, sock, 0, 0, -1, UDP_UNICAST, UDP_SEND)){
+      fprintf(stderr, "TEST_UDP_PACEDSENDER_ERROR: Could not create send socket, "
+	      "which happens at \"%s\", line [%d], has to abort.\n",
+	      __FILE__, __LINE__);
+      exit(EXIT_FAILURE);
+    }
+
+    // Time limited so that slow rates finish quickly
+    int npacket = NPACKET;
+    if(target.unit == UDP_RATE_PPS && target.rate < npacket){
+      npacket = target.rate;
+    }
+    else if(target.unit == UDP_RATE_GBPS && target.rate*1E9/8/PKT_SIZE < npacket){
+      npacket = target.rate*1E9/8/PKT_SIZE;
+    }
+
+    UdpPacedSender sender(sock, PKT_SIZE, NBATCH, target.rate, target.unit);
+    auto start = std::chrono::steady_clock::now();
+    for(int i = 0; i < npacket; i += NBATCH){
+      sender.send(buf, npacket - i < NBATCH ? npacket - i : NBATCH);
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    receiver.join();
+    close(sock);
+
+    double pps = sender.npacket_total/elapsed;
+    fprintf(stdout, "%12.1f %6s %14.3f %14.0f %12" PRIu64 " %12" PRIu64 "\n",
+	    target.rate, target.unit == UDP_RATE_GBPS ? "Gbps" : "pps",
+	    target.unit == UDP_RATE_GBPS ? pps*PKT_SIZE*8/1E9 : pps, pps,
+	    sender.npacket_total, nreceived);
+  }
+
+  free(buf);
+
+  return EXIT_SUCCESS;
+}
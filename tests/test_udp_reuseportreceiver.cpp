@@ -0,0 +1,98 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "utils/udp_utils.h"
+#include "utils/udp_reuseportreceiver.h"
+
+#include <stdint.h>
+
+#include <chrono>
+#include <mutex>
+#include <set>
+
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest/doctest.h"
+
+using namespace std;
+
+#define PKT_HDR_SIZE 8
+#define PKT_SIZE     8200
+#define NSOCKET      4
+#define NBEAM        8
+#define NPACKET      64 // per beam
+#define PORT         12347
+
+// Packet header for this test, packet counter then beam index, both little endian
+typedef struct packet_header_t{
+  uint32_t counter;
+  uint32_t beam;
+}packet_header_t;
+
+static void send_beams(){
+  int sock;
+  REQUIRE(create_udp_socket((char *)"127.0.0.1", NULL, PORT, sock, 0, 0, -1, UDP_UNICAST, UDP_SEND) == EXIT_SUCCESS);
+
+  char pkt[PKT_SIZE] = {0};
+  for(uint32_t i = 0; i < NPACKET; i++){
+    for(uint32_t beam = 0; beam < NBEAM; beam++){
+      packet_header_t hdr = {i, beam};
+      memcpy(pkt, &hdr, PKT_HDR_SIZE);
+      send(sock, pkt, PKT_SIZE, 0);
+    }
+    // Do not overflow socket buffer
+    this_thread::sleep_for(chrono::microseconds(200));
+  }
+  close(sock);
+}
+
+TEST_CASE("udp_steer_program") {
+  vector<struct sock_filter> prog;
+
+  udp_steer_t unsupported = {4, 3, 1, 1};
+  CHECK(udp_steer_program(unsupported, NSOCKET, prog) == EXIT_FAILURE);
+
+  udp_steer_t steer_byte = {4, 1, 0, 2};
+  REQUIRE(udp_steer_program(steer_byte, NSOCKET, prog) == EXIT_SUCCESS);
+  CHECK(prog.size() == 4);
+  CHECK(prog.back().code == (BPF_RET | BPF_A));
+}
+
+TEST_CASE("UdpReusePortReceiver steers beams to fixed threads") {
+  // Two beams per thread, each thread should only see its own beams and in order
+  udp_steer_t steer = {offsetof(packet_header_t, beam), 4, 1, NBEAM/NSOCKET};
+  UdpReusePortReceiver receivers(NULL, PORT, NSOCKET, 8, 0.1, PKT_SIZE, 16, &steer);
+
+  mutex lock;
+  set<uint32_t> beams[NSOCKET];
+  int64_t last[NBEAM];
+  fill(last, last + NBEAM, -1);
+  bool ordered = true;
+
+  receivers.start([&](int ithread, UdpBatchReceiver &receiver){
+    lock_guard<mutex> guard(lock);
+    for(int i = 0; i < receiver.npacket; i++){
+      packet_header_t hdr;
+      memcpy(&hdr, receiver.packet(i), PKT_HDR_SIZE);
+      beams[ithread].insert(hdr.beam);
+      if((int64_t)hdr.counter <= last[hdr.beam]){
+	ordered = false;
+      }
+      last[hdr.beam] = hdr.counter;
+    }
+  });
+
+  send_beams();
+  this_thread::sleep_for(chrono::milliseconds(200));
+  receivers.stop();
+
+  uint64_t ntotal = 0;
+  for(int i = 0; i < NSOCKET; i++){
+    ntotal += receivers.npacket(i);
+    for(uint32_t beam : beams[i]){
+      CHECK(beam/(NBEAM/NSOCKET) == (uint32_t)i);
+    }
+  }
+  CHECK(ntotal == NBEAM*NPACKET);
+  CHECK(ordered);
+}
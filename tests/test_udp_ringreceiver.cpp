@@ -0,0 +1,106 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+/*
+  Loopback benchmark of UdpRingReceiver against recvfrom and recvmmsg (UdpBatchReceiver),
+  it needs CAP_NET_RAW for the ring receiver
+*/
+
+#include "utils/udp_utils.h"
+#include "utils/udp_batchreceiver.h"
+#include "utils/udp_ringreceiver.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include <chrono>
+#include <thread>
+
+#define PKT_SIZE 8200
+#define NPACKET  200000
+#define NBATCH   64
+#define PORT     12348
+#define TOUT     0.5
+
+static void send_packets(int npacket){
+  // Let receiver get ready
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  int sock;
+  if(create_udp_socket((char *)"127.0.0.1", NULL, PORT, sock, 0, 0, -1, UDP_UNICAST, UDP_SEND)){
+    exit(EXIT_FAILURE);
+  }
+
+  char pkt[PKT_SIZE] = {0};
+  for(uint64_t i = 0; i < (uint64_t)npacket; i++){
+    memcpy(pkt, &i, sizeof(i));
+    send(sock, pkt, PKT_SIZE, 0);
+  }
+  close(sock);
+}
+
+// Receive until time out and report, receiver needs receive() and npacket_total, nsyscall_total
+template <typename T>
+static void run(const char *name, T &receiver){
+  std::thread sender(send_packets, NPACKET);
+
+  std::chrono::steady_clock::time_point start, stop;
+  bool started = false;
+  while(receiver.receive() > 0){
+    if(!started){
+      start = std::chrono::steady_clock::now();
+      started = true;
+    }
+    stop = std::chrono::steady_clock::now();
+  }
+  sender.join();
+
+  double elapsed = std::chrono::duration<double>(stop - start).count();
+  fprintf(stdout, "%10s %12d %12" PRIu64 " %14.0f %16.4f\n",
+	  name, NPACKET, receiver.npacket_total,
+	  elapsed > 0 ? receiver.npacket_total/elapsed : 0.0,
+	  receiver.nsyscall_total/(double)receiver.npacket_total);
+}
+
+int main(int argc, char *argv[]) {
+
+  const char *ifname = argc > 1 ? argv[1] : "lo";
+
+  fprintf(stdout, "%10s %12s %12s %14s %16s\n",
+	  "BACKEND", "NSENT", "NRECEIVED", "PACKETS/s", "SYSCALLS/PACKET");
+
+  int sock;
+  if(create_udp_socket(NULL, NULL, PORT, sock, 1, 64, TOUT, UDP_UNICAST, UDP_RECV)){
+    fprintf(stderr, "TEST_UDP_RINGRECEIVER_ERROR: Could not create receive socket, "
+	    "which happens at \"%s\", line [%d], has to abort.\n",
+	    __FILE__, __LINE__);
+    exit(EXIT_FAILURE);
+  }
+
+  // recvfrom is the same as batch of one
+  {
+    UdpBatchReceiver receiver(sock, PKT_SIZE, 1);
+    run("recvfrom", receiver);
+  }
+
+  {
+    UdpBatchReceiver receiver(sock, PKT_SIZE, NBATCH);
+    run("recvmmsg", receiver);
+  }
+
+  // Keep the UDP socket open but small, so that kernel does not reply port unreachable
+  int small = 1;
+  setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &small, sizeof(small));
+  {
+    UdpRingReceiver receiver(ifname, PORT, PKT_SIZE, TOUT);
+    run("tpacket_v3", receiver);
+    fprintf(stdout, "tpacket_v3 kernel drops %" PRIu64 ", truncated %" PRIu64 ", short %" PRIu64 "\n",
+	    receiver.ndrop(), receiver.ntruncated_total, receiver.nshort_total);
+  }
+  close(sock);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,140 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "utils/udp_utils.h"
+#include "utils/udp_batchreceiver.h"
+#include "utils/udp_pacedsender.h"
+#include "utils/udp_rxmonitor.h"
+
+#include <stdint.h>
+
+#include <atomic>
+#include <thread>
+
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest/doctest.h"
+
+using namespace std;
+
+#define PKT_SIZE 8200
+#define NBATCH   16
+#define PORT     12349
+
+static int create_sender(){
+  int sock;
+  REQUIRE(create_udp_socket((char *)"127.0.0.1", NULL, PORT, sock, 0, 0, -1, UDP_UNICAST, UDP_SEND) == EXIT_SUCCESS);
+  return sock;
+}
+
+static int create_receiver(){
+  int sock;
+  REQUIRE(create_udp_socket(NULL, NULL, PORT, sock, 1, 0, 0.2, UDP_UNICAST, UDP_RECV, UDP_OPTION_TIMESTAMP) == EXIT_SUCCESS);
+  return sock;
+}
+
+static uint64_t sum(const uint64_t *hist){
+  uint64_t total = 0;
+  for(int i = 0; i < UDP_RXMONITOR_NBIN; i++){
+    total += hist[i];
+  }
+  return total;
+}
+
+TEST_CASE("UdpRxMonitor::bin_index") {
+  CHECK(UdpRxMonitor::bin_index(0) == 0);
+  CHECK(UdpRxMonitor::bin_index(1) == 1);
+  CHECK(UdpRxMonitor::bin_index(1023) == 10);
+  CHECK(UdpRxMonitor::bin_index(1024) == 11);
+  CHECK(UdpRxMonitor::bin_edge(11) == 1024);
+}
+
+TEST_CASE("UdpRxMonitor inter-arrival of a paced stream") {
+  const int npacket = 2000;
+  const double pps  = 10000; // 100 microseconds between packets
+
+  int rsock = create_receiver();
+  UdpBatchReceiver receiver(rsock, PKT_SIZE, NBATCH, 1);
+  UdpRxMonitor monitor;
+
+  atomic<bool> done{false};
+  thread receive_thread([&](){
+    while(!done || receiver.npacket_total < (uint64_t)npacket){
+      if(receiver.receive() > 0){
+	monitor.record(receiver);
+      }
+      else if(done){
+	break;
+      }
+    }
+  });
+
+  int ssock = create_sender();
+  UdpPacedSender sender(ssock, PKT_SIZE, 1, pps, UDP_RATE_PPS);
+  char pkt[PKT_SIZE] = {0};
+
+  uint64_t hist[UDP_RXMONITOR_NBIN];
+  for(int i = 0; i < npacket; i++){
+    sender.send(pkt, 1);
+
+    // Query while the receive loop runs
+    if(i%500 == 0){
+      monitor.interarrival(hist);
+      CHECK(sum(hist) <= monitor.npacket());
+    }
+  }
+  done = true;
+  receive_thread.join();
+  close(ssock);
+  close(rsock);
+
+  REQUIRE(monitor.npacket() == (uint64_t)npacket);
+
+  monitor.interarrival(hist);
+  CHECK(sum(hist) == (uint64_t)npacket - 1);
+
+  // Most packets should be in the 100 microseconds bin or its neighbours
+  int mode = 0;
+  for(int i = 0; i < UDP_RXMONITOR_NBIN; i++){
+    if(hist[i] > hist[mode]){
+      mode = i;
+    }
+  }
+  CHECK(mode >= UdpRxMonitor::bin_index(100000) - 1);
+  CHECK(mode <= UdpRxMonitor::bin_index(100000) + 1);
+
+  monitor.latency(hist);
+  CHECK(sum(hist) == (uint64_t)npacket);
+  CHECK(monitor.ndrop() == 0);
+}
+
+TEST_CASE("UdpRxMonitor kernel drops") {
+  int rsock = create_receiver();
+  int nbyte = 64*1024; // a few packets only
+  setsockopt(rsock, SOL_SOCKET, SO_RCVBUF, &nbyte, sizeof(nbyte));
+
+  // Overflow the socket buffer before we read anything
+  int ssock = create_sender();
+  char pkt[PKT_SIZE] = {0};
+  for(int i = 0; i < 256; i++){
+    send(ssock, pkt, PKT_SIZE, 0);
+  }
+
+  UdpBatchReceiver receiver(rsock, PKT_SIZE, NBATCH, 1);
+  UdpRxMonitor monitor;
+  while(receiver.receive() > 0){
+    monitor.record(receiver);
+  }
+
+  // Drop counter comes with packets queued after the drops
+  send(ssock, pkt, PKT_SIZE, 0);
+  while(receiver.receive() > 0){
+    monitor.record(receiver);
+  }
+  close(ssock);
+  close(rsock);
+
+  CHECK(monitor.npacket() > 0);
+  CHECK(monitor.ndrop() > 0);
+  CHECK(monitor.npacket() + monitor.ndrop() == 257);
+}
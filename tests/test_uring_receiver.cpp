@@ -0,0 +1,220 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+/*
+  Loopback benchmark of UringReceiver against recvmmsg for UDP and recv for TCP, TCP data carries a pattern to check its order,
+  it reports packets/s, Gbps, syscalls/packet and receive thread CPU seconds per Gbit
+*/
+
+#include "utils/udp_utils.h"
+#include "utils/tcp_utils.h"
+#include "utils/udp_batchreceiver.h"
+#include "utils/udp_pacedsender.h"
+#include "utils/uring_receiver.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include <sys/time.h>
+#include <sys/resource.h>
+
+#include <chrono>
+#include <thread>
+
+#define PKT_SIZE   8200
+#define NPACKET    200000
+#define NBATCH     64
+#define DEPTH      256
+#define UDP_PORT   12352
+#define TCP_PORT   12353 // and the next one, listen socket of create_tcp_socket stays open
+#define TCP_CHUNK  65536
+#define TCP_NBYTE  (4UL*1024*1024*1024)
+#define TCP_SHIFT  13    // Byte i of chunk k is (char)(i + TCP_SHIFT*k), so chunks out of order show up
+
+// Byte of the TCP stream at offset
+static char tcp_pattern(uint64_t offset){
+  return (char)(offset%TCP_CHUNK + TCP_SHIFT*(offset/TCP_CHUNK));
+}
+
+// First and last byte of a piece of the stream, enough to catch pieces out of order without slowing the loop
+static int tcp_check(const char *buf, uint64_t n, uint64_t offset){
+  return buf[0] == tcp_pattern(offset) && buf[n - 1] == tcp_pattern(offset + n - 1);
+}
+
+static double cpu_seconds(){
+  struct rusage usage;
+  getrusage(RUSAGE_THREAD, &usage);
+  return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec/1E6 + usage.ru_stime.tv_sec + usage.ru_stime.tv_usec/1E6;
+}
+
+static void report(const char *name, uint64_t npacket, uint64_t nbyte, uint64_t nsyscall, double elapsed, double cpu){
+  double gbit = nbyte*8/1E9;
+  fprintf(stdout, "%14s %12" PRIu64 " %14.0f %10.3f %16.4f %14.4f\n",
+	  name, npacket, elapsed > 0 ? npacket/elapsed : 0.0, elapsed > 0 ? gbit/elapsed : 0.0,
+	  npacket ? nsyscall/(double)npacket : 0.0, gbit > 0 ? cpu/gbit : 0.0);
+}
+
+static void send_udp(){
+  // Let receiver get ready
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  int sock;
+  if(create_udp_socket((char *)"127.0.0.1", NULL, UDP_PORT, sock, 0, 0, -1, UDP_UNICAST, UDP_SEND)){
+    exit(EXIT_FAILURE);
+  }
+
+  char *buf = (char *)calloc((size_t)NBATCH*PKT_SIZE, 1);
+  UdpPacedSender sender(sock, PKT_SIZE, NBATCH, 0, UDP_RATE_PPS);
+  for(int i = 0; i < NPACKET; i += NBATCH){
+    sender.send(buf, NBATCH);
+  }
+  free(buf);
+  close(sock);
+}
+
+static void send_tcp(int port){
+  // Let receiver listen
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  int sock;
+  if(create_tcp_socket((char *)"127.0.0.1", port, sock, 0, 0, -1, 0, TCP_SEND)){
+    exit(EXIT_FAILURE);
+  }
+
+  // Chunk k starts at byte TCP_SHIFT*k of a ramp, so no chunk is filled in the loop
+  char *buf = (char *)malloc(TCP_CHUNK + 256);
+  for(int i = 0; i < TCP_CHUNK + 256; i++){
+    buf[i] = (char)i;
+  }
+  for(uint64_t i = 0; i < TCP_NBYTE; i += TCP_CHUNK){
+    sendbuf_tcp(sock, buf + (TCP_SHIFT*(i/TCP_CHUNK))%256, TCP_CHUNK);
+  }
+  free(buf);
+  close(sock);
+}
+
+// Receive until time out, receiver needs packet_size, npacket_total and nsyscall_total
+template <typename T, typename F>
+static void run_udp(const char *name, T &receiver, F receive){
+  std::thread sender(send_udp);
+
+  std::chrono::steady_clock::time_point start, stop;
+  double cpu_start = 0, cpu_stop = 0;
+  bool started = false;
+  uint64_t nbyte = 0;
+  int n;
+  while((n = receive()) > 0){
+    if(!started){
+      start = std::chrono::steady_clock::now();
+      cpu_start = cpu_seconds();
+      started = true;
+    }
+    for(int i = 0; i < n; i++){
+      nbyte += receiver.packet_size(i);
+    }
+    stop = std::chrono::steady_clock::now();
+    cpu_stop = cpu_seconds();
+  }
+  sender.join();
+
+  report(name, receiver.npacket_total, nbyte, receiver.nsyscall_total,
+	 std::chrono::duration<double>(stop - start).count(), cpu_stop - cpu_start);
+}
+
+static void run_tcp(const char *name, int use_uring){
+  int port = TCP_PORT + use_uring;
+  std::thread sender(send_tcp, port);
+
+  int sock;
+  if(create_tcp_socket((char *)"127.0.0.1", port, sock, 1, 0, -1, 0, TCP_RECV)){
+    exit(EXIT_FAILURE);
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  double cpu_start = cpu_seconds();
+  uint64_t nbyte = 0, nchunk = 0, nsyscall = 0, nbad = 0;
+
+  if(use_uring){
+    UringReceiver receiver(sock, TCP_CHUNK, 16, 16);
+    int n;
+    while((n = receiver.receive()) > 0){
+      for(int i = 0; i < n; i++){
+	nbad  += !tcp_check(receiver.packet(i), receiver.packet_size(i), nbyte);
+	nbyte += receiver.packet_size(i);
+      }
+    }
+    // Nothing is in flight after end of stream, another call returns instead of blocking
+    if(!receiver.eof || receiver.receive() != -1){
+      fprintf(stderr, "TEST_URING_RECEIVER_ERROR: %s has no end of stream, "
+	      "which happens at \"%s\", line [%d], has to abort.\n",
+	      name, __FILE__, __LINE__);
+      exit(EXIT_FAILURE);
+    }
+    nchunk   = receiver.npacket_total;
+    nsyscall = receiver.nsyscall_total;
+  }
+  else{
+    char *buf = (char *)malloc(TCP_CHUNK);
+    ssize_t n;
+    while((n = recv(sock, buf, TCP_CHUNK, 0)) > 0){
+      nbad  += !tcp_check(buf, n, nbyte);
+      nbyte += n;
+      nchunk++;
+      nsyscall++;
+    }
+    free(buf);
+  }
+
+  double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  double cpu = cpu_seconds() - cpu_start;
+  sender.join();
+  close(sock);
+
+  if(nbyte != TCP_NBYTE){
+    fprintf(stderr, "TEST_URING_RECEIVER_ERROR: %s received %" PRIu64 " bytes, but %lu bytes were sent, "
+	    "which happens at \"%s\", line [%d], has to abort.\n",
+	    name, nbyte, TCP_NBYTE, __FILE__, __LINE__);
+    exit(EXIT_FAILURE);
+  }
+  if(nbad){
+    fprintf(stderr, "TEST_URING_RECEIVER_ERROR: %s received %" PRIu64 " pieces of the stream out of order, "
+	    "which happens at \"%s\", line [%d], has to abort.\n",
+	    name, nbad, __FILE__, __LINE__);
+    exit(EXIT_FAILURE);
+  }
+  report(name, nchunk, nbyte, nsyscall, elapsed, cpu);
+}
+
+int main(int argc, char *argv[]) {
+
+  fprintf(stdout, "%14s %12s %14s %10s %16s %14s\n",
+	  "MODE", "NRECEIVED", "PACKETS/s", "Gbps", "SYSCALLS/PACKET", "CPU_s/Gbit");
+
+  {
+    int sock;
+    if(create_udp_socket(NULL, NULL, UDP_PORT, sock, 1, 64, 0.5, UDP_UNICAST, UDP_RECV)){
+      exit(EXIT_FAILURE);
+    }
+    UdpBatchReceiver receiver(sock, PKT_SIZE, NBATCH);
+    run_udp("udp_recvmmsg", receiver, [&](){return receiver.receive();});
+    close(sock);
+  }
+
+  {
+    int sock;
+    if(create_udp_socket(NULL, NULL, UDP_PORT, sock, 1, 64, -1, UDP_UNICAST, UDP_RECV)){
+      exit(EXIT_FAILURE);
+    }
+    UringReceiver receiver(sock, PKT_SIZE, DEPTH, NBATCH);
+    run_udp("udp_io_uring", receiver, [&](){return receiver.receive(0.5);});
+    close(sock);
+  }
+
+  run_tcp("tcp_recv", 0);
+  run_tcp("tcp_io_uring", 1);
+
+  return EXIT_SUCCESS;
+}
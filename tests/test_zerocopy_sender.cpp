@@ -0,0 +1,152 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "utils/udp_utils.h"
+#include "utils/tcp_utils.h"
+#include "utils/zerocopy_sender.h"
+
+#include <stdint.h>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest/doctest.h"
+
+using namespace std;
+
+#define PKT_SIZE 8200
+#define UDP_PORT 12354
+#define TCP_PORT 12355
+#define TCP_EMPTY_PORT 12357 // listen socket of create_tcp_socket stays open, so a new port
+
+TEST_CASE("ZerocopySender UDP datagrams") {
+  const int npacket = 64;
+
+  int rsock, ssock;
+  REQUIRE(create_udp_socket(NULL, NULL, UDP_PORT, rsock, 1, 16, 0.5, UDP_UNICAST, UDP_RECV) == EXIT_SUCCESS);
+  REQUIRE(create_udp_socket((char *)"127.0.0.1", NULL, UDP_PORT, ssock, 0, 0, -1, UDP_UNICAST, UDP_SEND) == EXIT_SUCCESS);
+
+  vector<char> buf((size_t)npacket*PKT_SIZE);
+  for(int i = 0; i < npacket; i++){
+    memset(buf.data() + (size_t)i*PKT_SIZE, i, PKT_SIZE);
+  }
+
+  ZerocopySender sender(ssock);
+  vector<uint32_t> tickets(npacket);
+  for(int i = 0; i < npacket; i++){
+    REQUIRE(sender.send(buf.data() + (size_t)i*PKT_SIZE, PKT_SIZE, tickets[i]) == EXIT_SUCCESS);
+  }
+  CHECK(tickets[npacket - 1] - tickets[0] == (uint32_t)npacket - 1);
+
+  REQUIRE(sender.wait(tickets[npacket - 1], 1.0) == EXIT_SUCCESS);
+  for(int i = 0; i < npacket; i++){
+    CHECK(sender.done(tickets[i]));
+  }
+  CHECK(sender.ncompleted_total == (uint64_t)npacket);
+  CHECK(sender.nbyte_total == (uint64_t)npacket*PKT_SIZE);
+
+  char pkt[PKT_SIZE];
+  for(int i = 0; i < npacket; i++){
+    REQUIRE(recv(rsock, pkt, PKT_SIZE, 0) == PKT_SIZE);
+    CHECK(pkt[0] == (char)i);
+    CHECK(pkt[PKT_SIZE - 1] == (char)i);
+  }
+
+  close(ssock);
+  close(rsock);
+}
+
+TEST_CASE("ZerocopySender TCP stream reuses buffers after completion") {
+  const size_t bufsz = 1 << 20;
+  const int nbuf     = 4;
+  const int nsend    = 64;
+
+  // Receiver checks that every byte of send i is i, which fails if a buffer is reused too early
+  uint64_t nreceived = 0, nbad = 0;
+  thread receiver([&](){
+    int sock;
+    REQUIRE(create_tcp_socket((char *)"127.0.0.1", TCP_PORT, sock, 1, 0, -1, 0, TCP_RECV) == EXIT_SUCCESS);
+    vector<char> buf(bufsz);
+    ssize_t n;
+    while((n = recv(sock, buf.data(), bufsz, 0)) > 0){
+      for(ssize_t i = 0; i < n; i++){
+	nbad += (buf[i] != (char)((nreceived + i)/bufsz));
+      }
+      nreceived += n;
+    }
+    close(sock);
+  });
+  this_thread::sleep_for(chrono::milliseconds(100));
+
+  int sock;
+  REQUIRE(create_tcp_socket((char *)"127.0.0.1", TCP_PORT, sock, 0, 0, -1, 0, TCP_SEND) == EXIT_SUCCESS);
+
+  vector<vector<char>> bufs(nbuf, vector<char>(bufsz));
+  vector<uint32_t> tickets(nbuf);
+  vector<bool> busy(nbuf, false);
+
+  ZerocopySender sender(sock);
+  for(int i = 0; i < nsend; i++){
+    int ibuf = i%nbuf;
+    if(busy[ibuf]){
+      REQUIRE(sender.wait(tickets[ibuf], 5.0) == EXIT_SUCCESS);
+    }
+    memset(bufs[ibuf].data(), i, bufsz);
+    REQUIRE(sender.send(bufs[ibuf].data(), bufsz, tickets[ibuf]) == EXIT_SUCCESS);
+    busy[ibuf] = true;
+  }
+  for(int i = 0; i < nbuf; i++){
+    REQUIRE(sender.wait(tickets[i], 5.0) == EXIT_SUCCESS);
+  }
+  CHECK(sender.ncompleted_total == sender.nsyscall_total);
+  close(sock);
+  receiver.join();
+
+  CHECK(nreceived == (uint64_t)nsend*bufsz);
+  CHECK(nbad == 0);
+}
+
+TEST_CASE("ZerocopySender TCP zero length send keeps tickets in step with the kernel") {
+  const size_t bufsz = 1 << 16;
+
+  uint64_t nreceived = 0;
+  thread receiver([&](){
+    int sock;
+    REQUIRE(create_tcp_socket((char *)"127.0.0.1", TCP_EMPTY_PORT, sock, 1, 0, -1, 0, TCP_RECV) == EXIT_SUCCESS);
+    vector<char> buf(bufsz);
+    ssize_t n;
+    while((n = recv(sock, buf.data(), bufsz, 0)) > 0){
+      nreceived += n;
+    }
+    close(sock);
+  });
+  this_thread::sleep_for(chrono::milliseconds(100));
+
+  int sock;
+  REQUIRE(create_tcp_socket((char *)"127.0.0.1", TCP_EMPTY_PORT, sock, 0, 0, -1, 0, TCP_SEND) == EXIT_SUCCESS);
+
+  vector<char> buf(bufsz, 'z');
+  uint32_t first, empty, last;
+  ZerocopySender sender(sock);
+  REQUIRE(sender.send(buf.data(), bufsz, first) == EXIT_SUCCESS);
+  uint64_t nsyscall = sender.nsyscall_total;
+
+  // Nothing goes to the kernel and the ticket is done at once
+  REQUIRE(sender.send(buf.data(), 0, empty) == EXIT_SUCCESS);
+  CHECK(sender.nsyscall_total == nsyscall);
+  CHECK(sender.done(empty));
+
+  // The next ticket follows the first one, so its completion shows up
+  REQUIRE(sender.send(buf.data(), bufsz, last) == EXIT_SUCCESS);
+  CHECK(last == first + (uint32_t)(sender.nsyscall_total - nsyscall));
+  REQUIRE(sender.wait(last, 5.0) == EXIT_SUCCESS);
+  CHECK(sender.done(first));
+  CHECK(sender.ncompleted_total == sender.nsyscall_total);
+  close(sock);
+  receiver.join();
+
+  CHECK(nreceived == 2*bufsz);
+}
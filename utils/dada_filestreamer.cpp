@@ -0,0 +1,111 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "dada_filestreamer.h"
+
+DadaFileStreamer::DadaFileStreamer(const char *fname){
+
+  fd = open(fname, O_RDONLY | O_CLOEXEC);
+  struct stat st;
+  if(fd < 0 || fstat(fd, &st)){
+    fprintf(stderr, "DADA_FILESTREAMER_ERROR: Could not open %s with \"%s\", "
+	    "which happens at \"%s\", line [%d], has to abort.\n",
+	    fname, strerror(errno), __FILE__, __LINE__);
+    exit(EXIT_FAILURE);
+  }
+  file_size = st.st_size;
+
+  // Only the header text comes to user space
+  char header[DADA_FILESTREAMER_HDR_SIZE + 1] = {0};
+  ssize_t nread = pread(fd, header, DADA_FILESTREAMER_HDR_SIZE, 0);
+  if(nread <= 0){
+    fprintf(stderr, "DADA_FILESTREAMER_ERROR: Could not read header of %s, "
+	    "which happens at \"%s\", line [%d], has to abort.\n",
+	    fname, __FILE__, __LINE__);
+    exit(EXIT_FAILURE);
+  }
+
+  // Same as ascii_header_get, key at the start of a line followed by the value
+  hdr_size = DADA_FILESTREAMER_HDR_SIZE;
+  for(char *key = strstr(header, "HDR_SIZE"); key != NULL; key = strstr(key + 1, "HDR_SIZE")){
+    if(key == header || key[-1] == '\n'){
+      if(sscanf(key + strlen("HDR_SIZE"), "%" SCNu64, &hdr_size) != 1){
+	hdr_size = DADA_FILESTREAMER_HDR_SIZE;
+      }
+      break;
+    }
+  }
+
+  if(hdr_size > file_size){
+    fprintf(stderr, "DADA_FILESTREAMER_ERROR: HDR_SIZE %" PRIu64 " is larger than %s of %" PRIu64 " bytes, "
+	    "which happens at \"%s\", line [%d], has to abort.\n",
+	    hdr_size, fname, file_size, __FILE__, __LINE__);
+    exit(EXIT_FAILURE);
+  }
+}
+
+DadaFileStreamer::~DadaFileStreamer(){
+  close(fd);
+}
+
+int DadaFileStreamer::stream(int sock, double rate, uint64_t start){
+
+  if(start > file_size){
+    fprintf(stderr, "DADA_FILESTREAMER_ERROR: Offset %" PRIu64 " is beyond the end of file at %" PRIu64 ", "
+	    "which happens at \"%s\", line [%d], has to abort.\n",
+	    start, file_size, __FILE__, __LINE__);
+    return EXIT_FAILURE;
+  }
+  offset = start;
+
+  double ns_per_byte = rate > 0 ? 8.0/rate : 0;
+  struct timespec begin;
+  clock_gettime(CLOCK_MONOTONIC, &begin);
+
+  while(offset < file_size){
+    // Without rate limit we let kernel take as much as it can
+    uint64_t nleft = file_size - offset;
+    size_t count = (rate > 0 && nleft > DADA_FILESTREAMER_CHUNK) ? DADA_FILESTREAMER_CHUNK : nleft;
+
+    off_t pos = offset;
+    ssize_t nsent = sendfile(sock, fd, &pos, count);
+    nsyscall_total++;
+
+    if(nsent < 0){
+      if(errno == EINTR){
+	continue;
+      }
+      if(errno == EAGAIN || errno == EWOULDBLOCK){
+	struct pollfd pfd = {sock, POLLOUT, 0};
+	poll(&pfd, 1, -1);
+	continue;
+      }
+      fprintf(stderr, "DADA_FILESTREAMER_ERROR: sendfile failed at offset %" PRIu64 " with \"%s\", "
+	      "which happens at \"%s\", line [%d], has to abort.\n",
+	      offset, strerror(errno), __FILE__, __LINE__);
+      return EXIT_FAILURE;
+    }
+    if(nsent == 0){
+      fprintf(stderr, "DADA_FILESTREAMER_ERROR: File is shorter than expected at offset %" PRIu64 ", "
+	      "which happens at \"%s\", line [%d], has to abort.\n",
+	      offset, __FILE__, __LINE__);
+      return EXIT_FAILURE;
+    }
+    offset += nsent;
+
+    // Sleep when we are ahead of the schedule
+    if(rate > 0){
+      struct timespec now;
+      clock_gettime(CLOCK_MONOTONIC, &now);
+      double elapsed = (now.tv_sec - begin.tv_sec)*1E9 + (now.tv_nsec - begin.tv_nsec);
+      double ahead   = (offset - start)*ns_per_byte - elapsed;
+      if(ahead > 0){
+	struct timespec nap = {(time_t)(ahead/1E9), (long)((uint64_t)ahead%1000000000UL)};
+	nanosleep(&nap, NULL);
+      }
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
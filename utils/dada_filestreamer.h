@@ -0,0 +1,73 @@
+#ifndef _DADA_FILESTREAMER_H
+#define _DADA_FILESTREAMER_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+
+#include <sys/stat.h>
+#include <sys/sendfile.h>
+
+#define DADA_FILESTREAMER_HDR_SIZE 4096       ///< Header size when the header does not have HDR_SIZE
+#define DADA_FILESTREAMER_CHUNK    (1 << 20)  ///< Bytes per `sendfile` call when the stream is paced
+
+/*! \brief A class to replay a recorded DADA file over a socket with `sendfile`
+ *
+ * The file is a DADA header of HDR_SIZE bytes followed by the data region, both go out with `sendfile`,
+ * so bytes move from page cache to the socket and never pass through user space.
+ * Only the header text is read once to get HDR_SIZE.
+ *
+ * The socket can come from `create_tcp_socket` in TCP_SEND direction, blocking or nonblocking.
+ * With a rate, the stream is sent in chunks of DADA_FILESTREAMER_CHUNK bytes and sleeps
+ * when it is ahead of the schedule.
+ *
+ * offset always tells how many bytes of the file are sent, so a broken stream can be resumed
+ * on a new connection with stream(sock, rate, offset).
+ *
+ */
+class DadaFileStreamer{
+public:
+  uint64_t hdr_size;    ///< Size of the header region in bytes
+  uint64_t file_size;   ///< Size of the file in bytes
+  uint64_t offset = 0;  ///< File offset of the next byte to send
+
+  uint64_t nsyscall_total = 0; ///< Number of `sendfile` calls since the class is created
+
+  //! Constructor of DadaFileStreamer class.
+  /*!
+   *
+   * - open \p fname and get HDR_SIZE from its header, abort if the file is not a DADA file
+   *
+   * \param[in] fname Name of the DADA file
+   *
+   */
+  DadaFileStreamer(const char *fname);
+
+  //! Deconstructor of DadaFileStreamer class.
+  ~DadaFileStreamer();
+
+  /*! Send the file from \p start to the end
+   *
+   * \param[in] sock  Connected socket to send to
+   * \param[in] rate  Rate in Gbps, 0 or negative value means no rate limit
+   * \param[in] start File offset to start from, 0 sends header and data, hdr_size sends data only
+   *
+   * \returns EXIT_SUCCESS when the file is sent, EXIT_FAILURE otherwise, offset tells where it stops
+   */
+  int stream(int sock, double rate = 0, uint64_t start = 0);
+
+  DadaFileStreamer(const DadaFileStreamer&) = delete;
+  DadaFileStreamer& operator=(const DadaFileStreamer&) = delete;
+
+private:
+  int fd = -1; ///< File to send
+};
+
+#endif
@@ -0,0 +1,322 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "dada_hduview.h"
+
+#include <utility>
+
+// Give released blocks back to psrdada in ring order
+static int settle(dada_ring_state &ring){
+  uint64_t nbytes;
+
+  // Clear in ring order, a peeked block released first waits for the current one
+  while(!ring.pending.empty() && *ring.pending.begin() == ring.nreleased){
+    if(!ring.open && ipcbuf_get_next_read(ring.block, &nbytes) == NULL){
+      fprintf(stderr, "DADA_HDUVIEW_ERROR: Could not open block %" PRIu64 ", "
+	      "which happens at \"%s\", line [%d].\n",
+	      ring.nreleased, __FILE__, __LINE__);
+      return EXIT_FAILURE;
+    }
+    ring.open = 0;
+    ring.pending.erase(ring.pending.begin());
+    ring.nreleased++;
+    if(ipcbuf_mark_cleared(ring.block) < 0){
+      fprintf(stderr, "DADA_HDUVIEW_ERROR: Could not mark block %" PRIu64 " cleared, "
+	      "which happens at \"%s\", line [%d].\n",
+	      ring.nreleased - 1, __FILE__, __LINE__);
+      return EXIT_FAILURE;
+    }
+  }
+
+  // A peeked block still in use becomes the open block,
+  // the writer is past it, so psrdada returns it without waiting
+  if(!ring.open && ring.nacquired > ring.nreleased){
+    if(ipcbuf_get_next_read(ring.block, &nbytes) == NULL){
+      fprintf(stderr, "DADA_HDUVIEW_ERROR: Could not open block %" PRIu64 ", "
+	      "which happens at \"%s\", line [%d].\n",
+	      ring.nreleased, __FILE__, __LINE__);
+      return EXIT_FAILURE;
+    }
+    ring.open = 1;
+  }
+
+  return EXIT_SUCCESS;
+}
+
+DadaBlock::~DadaBlock(){
+  release();
+}
+
+DadaBlock::DadaBlock(DadaBlock &&other) noexcept
+  :ring(other.ring), ptr(other.ptr), nbytes(other.nbytes), bufsz(other.bufsz), seq(other.seq), eod(other.eod){
+  other.ring = nullptr;
+  other.ptr  = nullptr;
+}
+
+DadaBlock& DadaBlock::operator=(DadaBlock &&other) noexcept{
+  if(this != &other){
+    release();
+    ring   = other.ring;
+    ptr    = other.ptr;
+    nbytes = other.nbytes;
+    bufsz  = other.bufsz;
+    seq    = other.seq;
+    eod    = other.eod;
+    other.ring = nullptr;
+    other.ptr  = nullptr;
+  }
+  return *this;
+}
+
+int DadaBlock::resize(uint64_t n){
+  if(ring == nullptr || ring->read || n > bufsz){
+    fprintf(stderr, "DADA_HDUVIEW_ERROR: Could not resize block to %" PRIu64 " bytes, "
+	    "which happens at \"%s\", line [%d].\n",
+	    n, __FILE__, __LINE__);
+    return EXIT_FAILURE;
+  }
+  nbytes = n;
+  return EXIT_SUCCESS;
+}
+
+int DadaBlock::release(){
+  if(ring == nullptr){
+    return EXIT_SUCCESS;
+  }
+  dada_ring_state &r = *ring;
+  ring = nullptr;
+  ptr  = nullptr;
+
+  if(!r.read){
+    if(eod && ipcbuf_enable_eod(r.block) < 0){
+      fprintf(stderr, "DADA_HDUVIEW_ERROR: Could not enable end of data, "
+	      "which happens at \"%s\", line [%d].\n",
+	      __FILE__, __LINE__);
+      return EXIT_FAILURE;
+    }
+    r.open = 0;
+    r.nreleased++;
+    if(ipcbuf_mark_filled(r.block, nbytes) < 0){
+      fprintf(stderr, "DADA_HDUVIEW_ERROR: Could not mark block %" PRIu64 " filled, "
+	      "which happens at \"%s\", line [%d].\n",
+	      seq, __FILE__, __LINE__);
+      return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+  }
+
+  r.pending.insert(seq);
+  return settle(r);
+}
+
+DadaHdu::DadaHdu(key_t key, int read, multilog_t *log)
+  :key(key), reader(read), log(log),
+   header(new dada_ring_state), data(new dada_ring_state){
+
+  if(this->log == NULL){
+    this->log = multilog_open("DadaHdu", 0);
+    if(this->log == NULL){
+      fprintf(stderr, "DADA_HDUVIEW_ERROR: Could not open multilog, "
+	      "which happens at \"%s\", line [%d].\n",
+	      __FILE__, __LINE__);
+      return;
+    }
+    multilog_add(this->log, stderr);
+    own_log = 1;
+  }
+
+  dada_hdu_t *h = dada_hdu_create(this->log);
+  dada_hdu_set_key(h, key);
+  if(dada_hdu_connect(h) < 0){
+    fprintf(stderr, "DADA_HDUVIEW_ERROR: Could not connect to HDU with key %x, "
+	    "which happens at \"%s\", line [%d].\n",
+	    key, __FILE__, __LINE__);
+    dada_hdu_destroy(h);
+    return;
+  }
+
+  if((read ? dada_hdu_lock_read(h) : dada_hdu_lock_write(h)) < 0){
+    fprintf(stderr, "DADA_HDUVIEW_ERROR: Could not lock HDU with key %x for %s, "
+	    "which happens at \"%s\", line [%d].\n",
+	    key, read ? "read" : "write", __FILE__, __LINE__);
+    dada_hdu_disconnect(h);
+    dada_hdu_destroy(h);
+    return;
+  }
+
+  hdu = h;
+  header->block = (ipcbuf_t *)(hdu->header_block);
+  data->block   = (ipcbuf_t *)(hdu->data_block);
+  header->read  = read;
+  data->read    = read;
+}
+
+DadaHdu::~DadaHdu(){
+  close();
+}
+
+DadaHdu::DadaHdu(DadaHdu &&other) noexcept
+  :key(other.key), reader(other.reader), hdu(other.hdu), log(other.log), own_log(other.own_log),
+   header(std::move(other.header)), data(std::move(other.data)){
+  other.hdu     = NULL;
+  other.log     = NULL;
+  other.own_log = 0;
+}
+
+DadaHdu& DadaHdu::operator=(DadaHdu &&other) noexcept{
+  if(this != &other){
+    close();
+    key     = other.key;
+    reader  = other.reader;
+    hdu     = other.hdu;
+    log     = other.log;
+    own_log = other.own_log;
+    header  = std::move(other.header);
+    data    = std::move(other.data);
+    other.hdu     = NULL;
+    other.log     = NULL;
+    other.own_log = 0;
+  }
+  return *this;
+}
+
+void DadaHdu::close(){
+  if(hdu != NULL){
+    if((reader ? dada_hdu_unlock_read(hdu) : dada_hdu_unlock_write(hdu)) < 0){
+      fprintf(stderr, "DADA_HDUVIEW_ERROR: Could not unlock HDU with key %x, "
+	      "which happens at \"%s\", line [%d].\n",
+	      key, __FILE__, __LINE__);
+    }
+    dada_hdu_disconnect(hdu);
+    dada_hdu_destroy(hdu);
+    hdu = NULL;
+  }
+  if(own_log){
+    multilog_close(log);
+    own_log = 0;
+  }
+  log = NULL;
+}
+
+uint64_t DadaHdu::bufsz() const{
+  return hdu == NULL ? 0 : ipcbuf_get_bufsz(data->block);
+}
+
+int DadaHdu::eod() const{
+  return hdu == NULL || ipcbuf_eod(data->block);
+}
+
+DadaBlock DadaHdu::acquire(dada_ring_state &ring){
+  if(ring.nacquired != ring.nreleased){
+    fprintf(stderr, "DADA_HDUVIEW_ERROR: Block %" PRIu64 " of HDU with key %x is still in use, "
+	    "release it or take the next block with peek(), "
+	    "which happens at \"%s\", line [%d].\n",
+	    ring.nreleased, key, __FILE__, __LINE__);
+    return DadaBlock();
+  }
+
+  uint64_t bufsz = ipcbuf_get_bufsz(ring.block);
+  uint64_t nbytes = bufsz;
+  char *ptr;
+  if(ring.read){
+    if(ipcbuf_eod(ring.block)){
+      return DadaBlock();
+    }
+    ptr = ipcbuf_get_next_read(ring.block, &nbytes);
+  }
+  else{
+    ptr = ipcbuf_get_next_write(ring.block);
+  }
+  if(ptr == NULL){
+    fprintf(stderr, "DADA_HDUVIEW_ERROR: Could not get block %" PRIu64 " from HDU with key %x, "
+	    "which happens at \"%s\", line [%d].\n",
+	    ring.nacquired, key, __FILE__, __LINE__);
+    return DadaBlock();
+  }
+  ring.open = 1;
+
+  // An empty read block is the end of data
+  if(ring.read && nbytes == 0){
+    ring.open = 0;
+    ring.nreleased++;
+    ring.nacquired++;
+    ipcbuf_mark_cleared(ring.block);
+    return DadaBlock();
+  }
+
+  return DadaBlock(&ring, ptr, nbytes, bufsz, ring.nacquired++);
+}
+
+DadaBlock DadaHdu::read_header(){
+  return hdu != NULL && reader ? acquire(*header) : DadaBlock();
+}
+
+DadaBlock DadaHdu::read(){
+  return hdu != NULL && reader ? acquire(*data) : DadaBlock();
+}
+
+DadaBlock DadaHdu::write_header(){
+  return hdu == NULL || reader ? DadaBlock() : acquire(*header);
+}
+
+DadaBlock DadaHdu::write(){
+  return hdu == NULL || reader ? DadaBlock() : acquire(*data);
+}
+
+DadaBlock DadaHdu::peek(){
+  // A moved from HDU has no ring state
+  if(hdu == NULL || !reader){
+    return DadaBlock();
+  }
+  dada_ring_state &ring = *data;
+  if(!ring.open || ring.nacquired != ring.nreleased + 1){
+    return DadaBlock();
+  }
+
+  // The block after the open one is complete when the writer has filled one more after it,
+  // it can not be overwritten until the open block and itself are cleared
+  uint64_t nbufs   = ipcbuf_get_nbufs(ring.block);
+  uint64_t nread   = ipcbuf_get_read_count(ring.block);
+  uint64_t nwrite  = ipcbuf_get_write_count(ring.block);
+  if(nbufs < 3 || nwrite < nread + 3){
+    return DadaBlock();
+  }
+
+  uint64_t bufsz = ipcbuf_get_bufsz(ring.block);
+  char *ptr = ring.block->buffer[(nread + 1) % nbufs];
+  return DadaBlock(&ring, ptr, bufsz, bufsz, ring.nacquired++);
+}
+
+int DadaHdu::end_of_data(){
+  DadaBlock block = write();
+  if(!block){
+    return EXIT_FAILURE;
+  }
+  block.resize(0);
+  block.set_eod();
+  return block.release();
+}
+
+DadaHdu::iterator::iterator(DadaHdu *owner)
+  :owner(owner), done(0){
+  ++(*this);
+}
+
+DadaHdu::iterator &DadaHdu::iterator::operator++(){
+  // Take the next block while the current one is still held if the ring has it,
+  // otherwise let the current one go first, psrdada opens one block at a time
+  DadaBlock next;
+  if(owner->reader){
+    next = owner->peek();
+  }
+  if(!next){
+    block.release();
+    next = owner->reader ? owner->read() : owner->write();
+  }
+  block = std::move(next);
+  if(!block){
+    done = 1;
+  }
+  return *this;
+}
@@ -0,0 +1,238 @@
+#ifndef _DADA_HDUVIEW_H
+#define _DADA_HDUVIEW_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <iterator>
+#include <memory>
+#include <set>
+
+#include "dada_utils.h"
+
+/// Bookkeeping of one ring of an HDU, shared by the HDU and its block views
+struct dada_ring_state{
+  ipcbuf_t *block = NULL;      ///< Header or data ring of the HDU
+  int read = 1;                ///< 1 for a reader, 0 for a writer
+  int open = 0;                ///< 1 when psrdada has block nreleased open
+  uint64_t nacquired = 0;      ///< Number of blocks handed out as views
+  uint64_t nreleased = 0;      ///< Number of blocks given back to psrdada, in ring order
+  std::set<uint64_t> pending;  ///< Blocks released by their view, not yet given back
+};
+
+/*! \brief A move-only view over one block of a DADA ring, no byte is copied
+ *
+ * The view points straight into the shared memory block from `ipcbuf_get_next_read` or `ipcbuf_get_next_write`.
+ * When the view is destroyed or released, a read block is marked cleared and a write block is marked filled
+ * with size() bytes, so nobody has to pair the marks by hand.
+ *
+ * A reader can hold the next block, from DadaHdu::peek(), while the current one is still processed.
+ * psrdada clears blocks in ring order, so when the next block is released first it stays pending
+ * and is cleared right after the current one.
+ *
+ */
+class DadaBlock{
+public:
+  //! An empty view, evaluates to false
+  DadaBlock() = default;
+
+  //! Deconstructor of DadaBlock class, gives the block back to the ring
+  ~DadaBlock();
+
+  DadaBlock(DadaBlock &&other) noexcept;
+  DadaBlock& operator=(DadaBlock &&other) noexcept;
+
+  DadaBlock(const DadaBlock&) = delete;
+  DadaBlock& operator=(const DadaBlock&) = delete;
+
+  char *data() const {return ptr;}            ///< Start of the block in shared memory
+  uint64_t size() const {return nbytes;}      ///< Bytes with data, for a write block the bytes to be filled
+  uint64_t capacity() const {return bufsz;}   ///< Size of the block in bytes
+  uint64_t sequence() const {return seq;}     ///< Block number on the ring since the HDU is opened
+  char *begin() const {return ptr;}
+  char *end() const {return ptr + nbytes;}
+
+  //! True when the view holds a block
+  explicit operator bool() const {return ring != nullptr;}
+
+  /*! Set the number of bytes to mark filled for a write block, it is capacity() by default
+   *
+   * \returns EXIT_FAILURE when the view is not a write block or \p n is larger than capacity()
+   */
+  int resize(uint64_t n);
+
+  //! Mark end of data after this write block
+  void set_eod() {eod = 1;}
+
+  /*! Give the block back to the ring now instead of at destruction, the view is empty after that
+   *
+   * \returns EXIT_FAILURE when psrdada fails to mark the block
+   */
+  int release();
+
+private:
+  friend class DadaHdu;
+
+  dada_ring_state *ring = nullptr; ///< Ring the block belongs to
+  char *ptr = nullptr;
+  uint64_t nbytes = 0;
+  uint64_t bufsz = 0;
+  uint64_t seq = 0;
+  int eod = 0;
+
+  DadaBlock(dada_ring_state *ring, char *ptr, uint64_t nbytes, uint64_t bufsz, uint64_t seq)
+    :ring(ring), ptr(ptr), nbytes(nbytes), bufsz(bufsz), seq(seq) {}
+};
+
+/*! \brief A move-only owner of a DADA HDU, locked for read or for write while the object lives
+ *
+ * Unlike `dada_setup_hdu`, the constructor does not abort on a failure, it leaves an object which
+ * evaluates to false and prints the reason, so the caller decides what to do.
+ * The destructor unlocks, disconnects and destroys the HDU.
+ *
+ * Blocks come out as DadaBlock views, one by one with read() and write() or with a range:
+ *
+ *     for(DadaBlock &block : hdu.blocks()){
+ *       process(block.data(), block.size());
+ *     }
+ *
+ * psrdada opens one block at a time for a reader, it advances its read cursor only when a block is cleared.
+ * To hold the next block anyway, peek() hands out a view of the block after the current one
+ * straight from the ring once the writer has moved past it, and the class opens it in psrdada
+ * when the current block is released. The iterator uses peek() when it can,
+ * so it takes the next block before it lets the current one go.
+ *
+ * Views have to be destroyed before the HDU.
+ *
+ */
+class DadaHdu{
+public:
+  //! Constructor of DadaHdu class.
+  /*!
+   *
+   * - create HDU, connect to \p key and lock it for read or write
+   *
+   * \param[in] key  Key of the DADA ring
+   * \param[in] read 1 to lock for read, 0 to lock for write
+   * \param[in] log  multilog of psrdada messages, NULL opens one to stderr
+   *
+   */
+  DadaHdu(key_t key, int read, multilog_t *log = NULL);
+
+  //! Deconstructor of DadaHdu class.
+  /*!
+   *
+   * - unlock, disconnect and destroy HDU, close multilog if it is opened by the class
+   */
+  ~DadaHdu();
+
+  DadaHdu(DadaHdu &&other) noexcept;
+  DadaHdu& operator=(DadaHdu &&other) noexcept;
+
+  DadaHdu(const DadaHdu&) = delete;
+  DadaHdu& operator=(const DadaHdu&) = delete;
+
+  //! True when the HDU is connected and locked
+  explicit operator bool() const {return hdu != NULL;}
+
+  dada_hdu_t *get() const {return hdu;}  ///< The psrdada HDU, for code which still takes it
+  uint64_t bufsz() const;                ///< Size of a data block in bytes
+  int eod() const;                       ///< True when a reader reaches end of data
+
+  /*! Get the next header block, wait until there is one
+   *
+   * \returns a view which is empty when the HDU is not a reader or psrdada fails
+   */
+  DadaBlock read_header();
+
+  /*! Get the next data block, wait until there is one
+   *
+   * \returns a view which is empty at end of data, when the HDU is not a reader or psrdada fails
+   */
+  DadaBlock read();
+
+  /*! Get the block after the one which is open, without waiting, so a reader holds two blocks
+   *
+   * The block is handed out only when the writer has filled the block after it too,
+   * so it is complete and its size is capacity().
+   *
+   * \returns a view which is empty when there is no such block yet, there is no open block,
+   *          the next block is already handed out or the HDU is not a reader
+   */
+  DadaBlock peek();
+
+  /*! Get the next free header block for write, it is marked filled with its size() when released
+   *
+   * \returns a view which is empty when the HDU is not a writer or psrdada fails
+   */
+  DadaBlock write_header();
+
+  /*! Get the next free data block for write, it is marked filled with its size() when released
+   *
+   * \returns a view which is empty when the HDU is not a writer or psrdada fails
+   */
+  DadaBlock write();
+
+  /*! Mark end of data with an empty block, for a writer which has no last block to call set_eod() on
+   *
+   * \returns EXIT_FAILURE when psrdada fails
+   */
+  int end_of_data();
+
+  /// Input iterator over blocks, it holds the current view
+  class iterator{
+  public:
+    typedef std::input_iterator_tag iterator_category;
+    typedef DadaBlock value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef DadaBlock* pointer;
+    typedef DadaBlock& reference;
+
+    DadaBlock &operator*() {return block;}
+    DadaBlock *operator->() {return &block;}
+    iterator &operator++();
+    bool operator==(const iterator &other) const {return done == other.done;}
+    bool operator!=(const iterator &other) const {return done != other.done;}
+
+  private:
+    friend class DadaHdu;
+    DadaHdu *owner = nullptr;
+    DadaBlock block;   ///< Current view, the loop body can move it out to keep it
+    int done = 1;      ///< 1 at the end of the range
+    iterator() = default;
+    explicit iterator(DadaHdu *owner);
+  };
+
+  /// Range over data blocks, read blocks until end of data or write blocks until the loop breaks
+  class range{
+  public:
+    iterator begin() {return iterator(owner);}
+    iterator end() {return iterator();}
+  private:
+    friend class DadaHdu;
+    DadaHdu *owner;
+    explicit range(DadaHdu *owner) : owner(owner) {}
+  };
+
+  //! Range over data blocks, read() or write() depends on how the HDU is locked
+  range blocks() {return range(this);}
+
+private:
+  key_t key = 0;
+  int reader = 1;
+  dada_hdu_t *hdu = NULL;
+  multilog_t *log = NULL;
+  int own_log = 0;
+
+  // Heap allocated so views stay valid when the HDU moves
+  std::unique_ptr<dada_ring_state> header;
+  std::unique_ptr<dada_ring_state> data;
+
+  DadaBlock acquire(dada_ring_state &ring); ///< Take the next block of a ring of an open HDU
+  void close();                             ///< Unlock and free everything, the object is empty after that
+};
+
+#endif
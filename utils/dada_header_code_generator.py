@@ -5,6 +5,7 @@ import json
 from os.path import exists
 
 # python dada_header_code_generator.py -j dada_header.json -H ../include/dada_header.h -s ../src/dada_header.c
+# C++ reflection header goes next to -H with .hpp extension unless -c gives another name, it requires C++17
 
 parser = argparse.ArgumentParser(
     description="Generate C code to get/set PSRDADA ascii header."
@@ -12,17 +13,61 @@ parser = argparse.ArgumentParser(
 parser.add_argument("-j", "--json_fname")
 parser.add_argument("-H", "--header_fname")
 parser.add_argument("-s", "--source_fname")
+parser.add_argument("-c", "--cpp_header_fname")
 
 args = parser.parse_args()
 json_fname = args.json_fname
 header_fname = args.header_fname
 source_fname = args.source_fname
+cpp_header_fname = args.cpp_header_fname
+if cpp_header_fname is None:
+    cpp_header_fname = header_fname.rsplit(".", 1)[0] + ".hpp"
 
 # Create file handles for data read and write
 json_file = open(json_fname, "r")
 header = json.load(json_file)
 json_file.close()
 
+# Keys are bits of a uint64_t mask and int8_t entries of the hash table, refuse before any file is written
+if len(header) > 64:
+    raise SystemExit(f"{json_fname} has {len(header)} keys, but at most 64 fit in the uint64_t key mask")
+
+type_names = {"int": "int", "uint64_t": "uint64", "double": "double", "float": "float", "string": "string"}
+
+# Perfect hash of the key set, FNV-1a with a seed searched here so that no two keys share a slot
+FNV_PRIME = 0x01000193
+
+
+def key_hash(key, seed):
+    h = seed
+    for c in key.encode():
+        h = ((h ^ c) * FNV_PRIME) & 0xFFFFFFFF
+    return h
+
+
+hash_size = 1
+while hash_size < 2 * len(header):
+    hash_size *= 2
+hash_seed = None
+while hash_seed is None:
+    for seed in range(1, 1 << 16):
+        slots = {key_hash(key, seed) & (hash_size - 1) for key in header}
+        if len(slots) == len(header):
+            hash_seed = seed
+            break
+    else:
+        hash_size *= 2
+
+# Schema hash of the binary sidecar, it changes with any key, type, order or string size
+def fnv1a64(text):
+    h = 0xCBF29CE484222325
+    for c in text.encode():
+        h = ((h ^ c) * 0x100000001B3) & 0xFFFFFFFFFFFFFFFF
+    return h
+
+
+schema_hash = fnv1a64(";".join(f"{key}:{header[key]}" for key in header) + ";DADA_STRLEN:1024")
+
 # First we need a header file
 header_file = open(header_fname, "w")
 
@@ -47,13 +92,102 @@ for key in header:
 
 header_file.write("  }dada_header_t;\n\n")
 
+header_file.write(f"#define DADA_HEADER_NKEY {len(header)}\n")
+header_file.write("#define DADA_HEADER_BIT(key) ((uint64_t)1 << (key))\n")
+header_file.write(f"#define DADA_HEADER_ALL  UINT64_C({(1 << len(header)) - 1:#x})\n\n")
+
+header_file.write("  enum dada_header_key{\n")
+for i, key in enumerate(header):
+    header_file.write(f"    DADA_HEADER_{key} = {i},\n")
+header_file.write("  };\n\n")
+
+header_file.write("  typedef struct dada_header_span_t{\n")
+header_file.write("    const char *value; // value in the buffer, not NUL terminated\n")
+header_file.write("    int length;        // without trailing spaces and comment\n")
+header_file.write("  }dada_header_span_t;\n\n")
+
+header_file.write("  typedef struct dada_header_index_t{\n")
+header_file.write("    dada_header_span_t span[DADA_HEADER_NKEY];\n")
+header_file.write("    uint64_t found; // DADA_HEADER_BIT of keys in the buffer\n")
+header_file.write("  }dada_header_index_t;\n\n")
+
+header_file.write(f"#define DADA_HEADER_HASH_SIZE {hash_size}\n\n")
+
+header_file.write("  int dada_header_key_index(const char *key);\n\n")
+header_file.write(
+    "  void index_dada_header(const char *buffer, dada_header_index_t *index);\n\n"
+)
+header_file.write(
+    "  int get_dada_header_span(const dada_header_index_t *index, const char *key, dada_header_span_t *span);\n\n"
+)
+for data_type in sorted(set(header.values()), key=list(type_names).index):
+    c_type = "char *" if data_type == "string" else f"{data_type} *"
+    header_file.write(
+        f"  int get_dada_header_{type_names[data_type]}(const dada_header_index_t *index, const char *key, {c_type}value);\n\n"
+    )
+header_file.write(
+    "  uint64_t parse_dada_header(const char *buffer, dada_header_t *header);\n\n"
+)
 header_file.write(
     "  int read_dada_header(const char *buffer, dada_header_t *header);\n\n"
 )
+header_file.write(
+    "  int read_dada_header_ascii(const char *buffer, dada_header_t *header);\n\n"
+)
 header_file.write(
     "  int write_dada_header(const dada_header_t header, char *buffer);\n\n"
 )
 
+# Widths of value fields written by serialize_dada_header, in place updates have to fit in them
+value_widths = {"int": 11, "uint64_t": 20, "double": 24, "float": 16}
+header_file.write("#define DADA_HEADER_KEY_WIDTH    20\n")
+header_file.write(f"#define DADA_HEADER_INT_WIDTH    {value_widths['int']}\n")
+header_file.write(f"#define DADA_HEADER_UINT64_WIDTH {value_widths['uint64_t']}\n")
+header_file.write(f"#define DADA_HEADER_DOUBLE_WIDTH {value_widths['double']}\n")
+header_file.write(f"#define DADA_HEADER_FLOAT_WIDTH  {value_widths['float']}\n\n")
+
+header_file.write("  typedef struct dada_header_offsets_t{\n")
+header_file.write("    int offset[DADA_HEADER_NKEY]; // value offset from the start of the buffer\n")
+header_file.write("    int width[DADA_HEADER_NKEY];  // value field width\n")
+header_file.write("  }dada_header_offsets_t;\n\n")
+
+header_file.write("  int format_dada_header_double(char *value, double number);\n\n")
+if "float" in header.values():
+    header_file.write("  int format_dada_header_float(char *value, float number);\n\n")
+header_file.write(
+    "  int serialize_dada_header(const dada_header_t *header, char *buffer, int size, dada_header_offsets_t *offsets);\n\n"
+)
+for data_type in sorted(set(header.values()), key=list(type_names).index):
+    c_type = "const char *" if data_type == "string" else f"{data_type} "
+    header_file.write(
+        f"  int update_dada_header_{type_names[data_type]}(char *buffer, const dada_header_offsets_t *offsets, int key, {c_type}value);\n\n"
+    )
+
+header_file.write("#define DADA_HEADER_BINARY_MAGIC   0x48424444 // DDBH\n")
+header_file.write("#define DADA_HEADER_BINARY_VERSION 1\n")
+header_file.write(f"#define DADA_HEADER_SCHEMA_HASH    UINT64_C({schema_hash:#018x})\n\n")
+
+header_file.write("  // Binary copy of dada_header_t at the end of the header block, after the NUL of the ASCII header\n")
+header_file.write("  typedef struct dada_header_binary_t{\n")
+header_file.write("    uint32_t magic;       // DADA_HEADER_BINARY_MAGIC\n")
+header_file.write("    uint32_t version;     // DADA_HEADER_BINARY_VERSION\n")
+header_file.write("    uint64_t schema_hash; // DADA_HEADER_SCHEMA_HASH of the writer\n")
+header_file.write("    uint64_t size;        // sizeof(dada_header_t) of the writer\n")
+header_file.write("    uint64_t text_length; // strlen of the ASCII header it was written with\n")
+header_file.write("    uint64_t text_hash;   // hash of the ASCII header, an edit of the text invalidates the copy\n")
+header_file.write("    dada_header_t header;\n")
+header_file.write("  }dada_header_binary_t;\n\n")
+
+header_file.write(
+    "  int write_dada_header_binary(const dada_header_t *header, char *buffer, int size);\n\n"
+)
+header_file.write(
+    "  const dada_header_binary_t *find_dada_header_binary(const char *buffer, int size);\n\n"
+)
+header_file.write(
+    "  uint64_t load_dada_header(const char *buffer, int size, dada_header_t *header);\n\n"
+)
+
 header_file.write(
     "  int read_dada_header_from_file(const char *fname, dada_header_t *header);\n\n"
 )
@@ -81,8 +215,10 @@ source_file.write('#include "ascii_header.h"\n\n')
 source_file.write(f'#include "{header_fname}"\n\n')
 
 source_file.write("#include <stdlib.h>\n")
-source_file.write("#include <stdio.h>\n\n")
-source_file.write("#include <string.h>\n\n")
+source_file.write("#include <stdio.h>\n")
+source_file.write("#include <stdint.h>\n\n")
+source_file.write("#include <string.h>\n")
+source_file.write("#include <math.h>\n\n")
 
 # read from file function
 
@@ -96,14 +232,221 @@ source_file.write("  memset(buffer, 0, DADA_DEFAULT_HEADER_SIZE);\n\n")
 source_file.write(
     "  fileread(fname, buffer, DADA_DEFAULT_HEADER_SIZE);\n"
 )
-source_file.write("  read_dada_header(buffer, header);\n\n")
+source_file.write("  uint64_t missing = load_dada_header(buffer, DADA_DEFAULT_HEADER_SIZE, header);\n\n")
 source_file.write("  free(buffer);\n\n")
+source_file.write("  return missing ? EXIT_FAILURE : EXIT_SUCCESS;\n}\n\n")
+
+# Key lookup, one probe of the perfect hash table and one compare
+source_file.write(
+    "static const char *dada_header_keys[DADA_HEADER_NKEY] = {\n"
+)
+for key in header:
+    source_file.write(f'  "{key}",\n')
+source_file.write("};\n\n")
+
+source_file.write(
+    "static const int dada_header_key_lengths[DADA_HEADER_NKEY] = {\n"
+)
+source_file.write("  " + ", ".join(str(len(key)) for key in header) + ",\n")
+source_file.write("};\n\n")
+
+hash_table = [-1] * hash_size
+for i, key in enumerate(header):
+    hash_table[key_hash(key, hash_seed) & (hash_size - 1)] = i
+source_file.write(f"#define DADA_HEADER_HASH_SEED  {hash_seed}u\n")
+source_file.write(f"#define DADA_HEADER_HASH_PRIME {FNV_PRIME}u\n\n")
+source_file.write(
+    "static const int8_t dada_header_hash_table[DADA_HEADER_HASH_SIZE] = {\n"
+)
+for i in range(0, hash_size, 16):
+    source_file.write("  " + ", ".join(f"{k:2d}" for k in hash_table[i : i + 16]) + ",\n")
+source_file.write("};\n\n")
+
+source_file.write(
+    "static inline int dada_header_lookup(const char *key, int length, uint32_t hash){\n\n"
+)
+source_file.write(
+    "  int k = dada_header_hash_table[hash & (DADA_HEADER_HASH_SIZE - 1)];\n"
+)
+source_file.write(
+    "  if (k < 0 || dada_header_key_lengths[k] != length || memcmp(key, dada_header_keys[k], length))\n"
+)
+source_file.write("    return -1;\n\n")
+source_file.write("  return k;\n}\n\n")
+
+source_file.write("int dada_header_key_index(const char *key){\n\n")
+source_file.write("  uint32_t hash = DADA_HEADER_HASH_SEED;\n")
+source_file.write("  const char *p = key;\n")
+source_file.write(
+    "  while (*p) hash = (hash ^ (unsigned char)*p++) * DADA_HEADER_HASH_PRIME;\n\n"
+)
+source_file.write("  return dada_header_lookup(key, p - key, hash);\n}\n\n")
+
+# index function, one pass over the buffer
+source_file.write(
+    "void index_dada_header(const char *buffer, dada_header_index_t *index){\n\n"
+)
+source_file.write("  const char *p = buffer;\n\n")
+source_file.write("  index->found = 0;\n")
+source_file.write("  while (*p) {\n")
+source_file.write("    // Key is the first token of a line\n")
+source_file.write("    while (*p == ' ' || *p == '\\t') p++;\n")
+source_file.write("    const char *key = p;\n")
+source_file.write("    uint32_t hash = DADA_HEADER_HASH_SEED;\n")
+source_file.write("    while (*p && *p != ' ' && *p != '\\t' && *p != '\\n')\n")
+source_file.write("      hash = (hash ^ (unsigned char)*p++) * DADA_HEADER_HASH_PRIME;\n\n")
+source_file.write("    // Lines of other keys and later copies of a key are skipped at memchr speed, the first one wins as in ascii_header_get\n")
+source_file.write("    int k = dada_header_lookup(key, p - key, hash);\n")
+source_file.write("    if (k < 0 || (index->found & DADA_HEADER_BIT(k))) {\n")
+source_file.write("      p = strchrnul(p, '\\n');\n")
+source_file.write("      if (*p) p++;\n")
+source_file.write("      continue;\n")
+source_file.write("    }\n\n")
+source_file.write("    // Value runs to end of line or comment\n")
+source_file.write("    while (*p == ' ' || *p == '\\t') p++;\n")
+source_file.write("    const char *value = p;\n")
+source_file.write("    while (*p && *p != '\\n' && *p != '#') p++;\n")
+source_file.write("    const char *end = p;\n")
+source_file.write(
+    "    while (end > value && (end[-1] == ' ' || end[-1] == '\\t' || end[-1] == '\\r')) end--;\n"
+)
+source_file.write("    p = strchrnul(p, '\\n');\n")
+source_file.write("    if (*p) p++;\n\n")
+source_file.write("    index->span[k].value  = value;\n")
+source_file.write("    index->span[k].length = end - value;\n")
+source_file.write("    index->found |= DADA_HEADER_BIT(k);\n")
+source_file.write("  }\n}\n\n")
+
+# Converters from span for types in the JSON, they return 0 on success
+data_types = set(header.values())
+if "int" in data_types:
+    source_file.write(
+        "static int dada_header_span_int(const dada_header_span_t *span, int *value){\n"
+    )
+    source_file.write("  // Decimal digits only, strtol pays for locale and base detection\n")
+    source_file.write("  const char *p = span->value;\n")
+    source_file.write("  const char *end = span->value + span->length;\n")
+    source_file.write("  int negative = p < end && *p == '-';\n")
+    source_file.write("  if (p < end && (*p == '-' || *p == '+')) p++;\n")
+    source_file.write("  const char *digits = p;\n")
+    source_file.write("  int64_t result = 0;\n")
+    source_file.write("  while (p < end && *p >= '0' && *p <= '9') result = result*10 + (*p++ - '0');\n")
+    source_file.write("  *value = negative ? -result : result;\n")
+    source_file.write("  return p == digits;\n}\n\n")
+
+if "uint64_t" in data_types:
+    source_file.write(
+        "static int dada_header_span_uint64(const dada_header_span_t *span, uint64_t *value){\n"
+    )
+    source_file.write("  const char *p = span->value;\n")
+    source_file.write("  const char *end = span->value + span->length;\n")
+    source_file.write("  if (p < end && *p == '+') p++;\n")
+    source_file.write("  const char *digits = p;\n")
+    source_file.write("  uint64_t result = 0;\n")
+    source_file.write("  while (p < end && *p >= '0' && *p <= '9') result = result*10 + (*p++ - '0');\n")
+    source_file.write("  *value = result;\n")
+    source_file.write("  return p == digits;\n}\n\n")
+
+if "double" in data_types:
+    source_file.write(
+        "static int dada_header_span_double(const dada_header_span_t *span, double *value){\n"
+    )
+    source_file.write("  char *end;\n")
+    source_file.write("  *value = strtod(span->value, &end);\n")
+    source_file.write("  return end == span->value || end > span->value + span->length;\n}\n\n")
+
+if "float" in data_types:
+    source_file.write(
+        "static int dada_header_span_float(const dada_header_span_t *span, float *value){\n"
+    )
+    source_file.write("  char *end;\n")
+    source_file.write("  *value = strtof(span->value, &end);\n")
+    source_file.write("  return end == span->value || end > span->value + span->length;\n}\n\n")
+
+if "string" in data_types:
+    source_file.write(
+        "static int dada_header_span_string(const dada_header_span_t *span, char *value){\n"
+    )
+    source_file.write("  // First word only, the same as %s\n")
+    source_file.write("  int length = 0;\n")
+    source_file.write(
+        "  while (length < span->length && length < DADA_STRLEN - 1 && span->value[length] != ' ' && span->value[length] != '\\t') length++;\n"
+    )
+    source_file.write("  memcpy(value, span->value, length);\n")
+    source_file.write("  value[length] = '\\0';\n")
+    source_file.write("  return length == 0;\n}\n\n")
+
+converters = {
+    "int": "dada_header_span_int",
+    "uint64_t": "dada_header_span_uint64",
+    "double": "dada_header_span_double",
+    "float": "dada_header_span_float",
+    "string": "dada_header_span_string",
+}
+
+# Getters of one key from an index, O(1) with the hash table
+source_file.write(
+    "int get_dada_header_span(const dada_header_index_t *index, const char *key, dada_header_span_t *span){\n\n"
+)
+source_file.write("  int k = dada_header_key_index(key);\n")
+source_file.write("  if (k < 0 || !(index->found & DADA_HEADER_BIT(k)))\n")
+source_file.write("    return EXIT_FAILURE;\n\n")
+source_file.write("  *span = index->span[k];\n")
 source_file.write("  return EXIT_SUCCESS;\n}\n\n")
 
+for data_type in sorted(data_types, key=list(type_names).index):
+    c_type = "char *" if data_type == "string" else f"{data_type} *"
+    source_file.write(
+        f"int get_dada_header_{type_names[data_type]}(const dada_header_index_t *index, const char *key, {c_type}value){{\n\n"
+    )
+    source_file.write("  dada_header_span_t span;\n")
+    source_file.write("  if (get_dada_header_span(index, key, &span) ||\n")
+    source_file.write(f"      dada_header_span_{type_names[data_type]}(&span, value))\n")
+    source_file.write("    return EXIT_FAILURE;\n\n")
+    source_file.write("  return EXIT_SUCCESS;\n}\n\n")
+
+# parse function, returns mask of missing keys
+source_file.write(
+    "uint64_t parse_dada_header(const char *buffer, dada_header_t *header){\n\n"
+)
+source_file.write("  dada_header_index_t index;\n")
+source_file.write("  index_dada_header(buffer, &index);\n\n")
+
+for key in header:
+    data_type = header[key]
+
+    member = f"header->{key.lower()}" if data_type == "string" else f"&header->{key.lower()}"
+    source_file.write(
+        f"  if ((index.found & DADA_HEADER_BIT(DADA_HEADER_{key})) &&\n"
+    )
+    source_file.write(
+        f"      {converters[data_type]}(&index.span[DADA_HEADER_{key}], {member}))\n"
+    )
+    source_file.write(f"    index.found &= ~DADA_HEADER_BIT(DADA_HEADER_{key});\n")
+
+source_file.write("\n  return ~index.found & DADA_HEADER_ALL;\n}\n\n")
+
 # read function
 source_file.write(
     "int read_dada_header(const char *buffer, dada_header_t *header){\n\n"
 )
+source_file.write("  uint64_t missing = parse_dada_header(buffer, header);\n\n")
+source_file.write("  for (int k = 0; k < DADA_HEADER_NKEY; k++) {\n")
+source_file.write("    if (missing & DADA_HEADER_BIT(k)) {\n")
+source_file.write(
+    '      fprintf(stderr, "READ_DADA_HEADER_ERROR: Error getting %s, "\n'
+)
+source_file.write(
+    '              "which happens at %s, line [%d].\\n",\n',
+)
+source_file.write("              dada_header_keys[k], __FILE__, __LINE__);\n")
+source_file.write("    }\n  }\n\n")
+source_file.write("  return missing ? EXIT_FAILURE : EXIT_SUCCESS;\n}\n\n")
+
+# read function with one ascii_header_get per key
+source_file.write(
+    "int read_dada_header_ascii(const char *buffer, dada_header_t *header){\n\n"
+)
 
 for key in header:
     data_type = header[key]
@@ -137,6 +480,253 @@ for key in header:
 
 source_file.write("  return EXIT_SUCCESS;\n}\n\n")
 
+# Formatters, numbers are written right aligned in fixed width fields so that they can be updated in place
+source_file.write(
+    """static int dada_header_format_uint64(char *value, uint64_t number){
+  char digits[20];
+  int length = 0;
+  do {
+    digits[length++] = '0' + number%10;
+    number /= 10;
+  } while (number);
+
+  for (int i = 0; i < length; i++) value[i] = digits[length - 1 - i];
+  value[length] = '\\0';
+  return length;
+}
+
+static int dada_header_format_int64(char *value, int64_t number){
+  if (number < 0) {
+    value[0] = '-';
+    return 1 + dada_header_format_uint64(value + 1, -(uint64_t)number);
+  }
+  return dada_header_format_uint64(value, number);
+}
+
+static const double dada_header_pow10[] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16,
+};
+
+// Shortest decimal which reads back to the same double
+int format_dada_header_double(char *value, double number){
+
+  // Fast path, the first k with number == m/10^k, m = llround(number*10^k) below 2^53,
+  // m and 10^k are exact and the division rounds like strtod, the product itself may round
+  for (int k = 0; k <= 16; k++) {
+    double scaled = number*dada_header_pow10[k];
+    if (!(scaled > -9007199254740992.0 && scaled < 9007199254740992.0)) break;
+    int64_t mantissa = llround(scaled);
+    if ((double)mantissa/dada_header_pow10[k] != number) continue;
+    if (mantissa == 0) break;
+
+    char digits[24];
+    int negative = mantissa < 0;
+    int length = dada_header_format_uint64(digits, negative ? -(uint64_t)mantissa : (uint64_t)mantissa);
+    char *p = value;
+    if (negative) *p++ = '-';
+    if (length <= k) {
+      *p++ = '0';
+      *p++ = '.';
+      for (int i = length; i < k; i++) *p++ = '0';
+      memcpy(p, digits, length);
+      p += length;
+    }
+    else {
+      memcpy(p, digits, length - k);
+      p += length - k;
+      if (k) {
+        *p++ = '.';
+        memcpy(p, digits + length - k, k);
+        p += k;
+      }
+    }
+    *p = '\\0';
+    return p - value;
+  }
+
+  // Zero, very large, very small or long numbers, the first precision which reads back wins
+  int length = 0;
+  for (int precision = 15; precision <= 17; precision++) {
+    length = snprintf(value, DADA_HEADER_DOUBLE_WIDTH + 1, "%.*g", precision, number);
+    if (strtod(value, NULL) == number) break;
+  }
+  return length;
+}
+
+"""
+)
+if "float" in data_types:
+    source_file.write(
+        """int format_dada_header_float(char *value, float number){
+  int length = 0;
+  for (int precision = 6; precision <= 9; precision++) {
+    length = snprintf(value, DADA_HEADER_FLOAT_WIDTH + 1, "%.*g", precision, number);
+    if (strtof(value, NULL) == number) break;
+  }
+  return length;
+}
+
+"""
+    )
+
+# Format the value of one member into value, returns its length
+def format_member(data_type, member):
+    if data_type == "int":
+        return f"dada_header_format_int64(value, {member})"
+    if data_type == "uint64_t":
+        return f"dada_header_format_uint64(value, {member})"
+    if data_type == "double":
+        return f"format_dada_header_double(value, {member})"
+    if data_type == "float":
+        return f"format_dada_header_float(value, {member})"
+    return None
+
+
+# serialize function, one forward pass
+source_file.write(
+    "int serialize_dada_header(const dada_header_t *header, char *buffer, int size, dada_header_offsets_t *offsets){\n\n"
+)
+source_file.write("  char value[DADA_STRLEN];\n")
+source_file.write("  char *p = buffer;\n")
+source_file.write("  char *end = buffer + size;\n")
+source_file.write("  int length, width;\n\n")
+for key in header:
+    data_type = header[key]
+
+    member = f"header->{key.lower()}"
+    # Keys of 20 or more characters take their length and a space, check the same width we advance
+    key_width = "DADA_HEADER_KEY_WIDTH" if len(key) < 20 else len(key) + 1
+    source_file.write(f"  // {key}\n")
+    if data_type == "string":
+        source_file.write(f"  length = strnlen({member}, DADA_STRLEN - 1);\n")
+        source_file.write("  width  = length;\n")
+        source_file.write(
+            f"  if (end - p < {key_width} + width + 2) return -1;\n"
+        )
+        source_file.write(f'  memcpy(p, "{key:<19s} ", DADA_HEADER_KEY_WIDTH);\n' if len(key) < 20 else
+                          f'  memcpy(p, "{key} ", {len(key) + 1});\n')
+        source_file.write(f"  p += {max(20, len(key) + 1)};\n")
+        source_file.write(f"  memcpy(p, {member}, length);\n")
+    else:
+        source_file.write(f"  length = {format_member(data_type, member)};\n")
+        source_file.write(f"  width  = DADA_HEADER_{type_names[data_type].upper()}_WIDTH;\n")
+        source_file.write(
+            f"  if (end - p < {key_width} + width + 2) return -1;\n"
+        )
+        source_file.write(f'  memcpy(p, "{key:<19s} ", DADA_HEADER_KEY_WIDTH);\n' if len(key) < 20 else
+                          f'  memcpy(p, "{key} ", {len(key) + 1});\n')
+        source_file.write(f"  p += {max(20, len(key) + 1)};\n")
+        source_file.write("  memset(p, ' ', width - length);\n")
+        source_file.write("  memcpy(p + width - length, value, length);\n")
+    source_file.write("  if (offsets) {\n")
+    source_file.write(f"    offsets->offset[DADA_HEADER_{key}] = p - buffer;\n")
+    source_file.write(f"    offsets->width[DADA_HEADER_{key}]  = width;\n")
+    source_file.write("  }\n")
+    source_file.write("  p += width;\n")
+    source_file.write("  *p++ = '\\n';\n\n")
+source_file.write("  *p = '\\0';\n")
+source_file.write("  return p - buffer;\n}\n\n")
+
+# In place updates through offsets from serialize_dada_header
+for data_type in sorted(data_types, key=list(type_names).index):
+    c_type = "const char *" if data_type == "string" else f"{data_type} "
+    source_file.write(
+        f"int update_dada_header_{type_names[data_type]}(char *buffer, const dada_header_offsets_t *offsets, int key, {c_type}value){{\n\n"
+    )
+    if data_type == "string":
+        source_file.write("  int length = strlen(value);\n")
+        source_file.write(
+            "  if (key < 0 || key >= DADA_HEADER_NKEY || length == 0 || length > offsets->width[key])\n"
+        )
+        source_file.write("    return EXIT_FAILURE;\n\n")
+        source_file.write("  // Shorter strings are padded with trailing spaces, readers take the first word\n")
+        source_file.write("  char *p = buffer + offsets->offset[key];\n")
+        source_file.write("  memcpy(p, value, length);\n")
+        source_file.write("  memset(p + length, ' ', offsets->width[key] - length);\n\n")
+    else:
+        member_value = "value"
+        source_file.write(f"  char digits[DADA_HEADER_{type_names[data_type].upper()}_WIDTH + 1];\n")
+        source_file.write(f"  int length = {format_member(data_type, 'value').replace('(value, ', '(digits, ')};\n")
+        source_file.write(
+            "  if (key < 0 || key >= DADA_HEADER_NKEY || length > offsets->width[key])\n"
+        )
+        source_file.write("    return EXIT_FAILURE;\n\n")
+        source_file.write("  char *p = buffer + offsets->offset[key];\n")
+        source_file.write("  memset(p, ' ', offsets->width[key] - length);\n")
+        source_file.write("  memcpy(p + offsets->width[key] - length, digits, length);\n\n")
+    source_file.write("  return EXIT_SUCCESS;\n}\n\n")
+
+# Binary sidecar, it sits at the end of the header block so ASCII readers never see it
+source_file.write(
+    """static uint64_t dada_header_text_hash(const char *text, uint64_t length){
+
+  // Eight bytes per step, it has to be much cheaper than parsing the text
+  uint64_t hash = UINT64_C(0xcbf29ce484222325) ^ length;
+  uint64_t i = 0;
+  for (; i + 8 <= length; i += 8) {
+    uint64_t word;
+    memcpy(&word, text + i, 8);
+    hash = (hash ^ word)*UINT64_C(0x100000001b3);
+    hash ^= hash >> 29;
+  }
+  for (; i < length; i++) hash = (hash ^ (unsigned char)text[i])*UINT64_C(0x100000001b3);
+
+  return hash;
+}
+
+static int dada_header_binary_offset(int size){
+  return (size - (int)sizeof(dada_header_binary_t)) & ~7;
+}
+
+int write_dada_header_binary(const dada_header_t *header, char *buffer, int size){
+
+  int offset = dada_header_binary_offset(size);
+  if (offset < 0) return EXIT_FAILURE;
+
+  uint64_t length = strnlen(buffer, size);
+  if ((int)length >= offset) return EXIT_FAILURE;
+
+  dada_header_binary_t *binary = (dada_header_binary_t *)(buffer + offset);
+  binary->magic       = DADA_HEADER_BINARY_MAGIC;
+  binary->version     = DADA_HEADER_BINARY_VERSION;
+  binary->schema_hash = DADA_HEADER_SCHEMA_HASH;
+  binary->size        = sizeof(dada_header_t);
+  binary->text_length = length;
+  binary->text_hash   = dada_header_text_hash(buffer, length);
+  memcpy(&binary->header, header, sizeof(dada_header_t));
+
+  return EXIT_SUCCESS;
+}
+
+const dada_header_binary_t *find_dada_header_binary(const char *buffer, int size){
+
+  int offset = dada_header_binary_offset(size);
+  if (offset < 0) return NULL;
+
+  const dada_header_binary_t *binary = (const dada_header_binary_t *)(buffer + offset);
+  if (binary->magic != DADA_HEADER_BINARY_MAGIC || binary->version != DADA_HEADER_BINARY_VERSION ||
+      binary->schema_hash != DADA_HEADER_SCHEMA_HASH || binary->size != sizeof(dada_header_t) ||
+      binary->text_length >= (uint64_t)offset || buffer[binary->text_length] != '\\0' ||
+      binary->text_hash != dada_header_text_hash(buffer, binary->text_length))
+    return NULL;
+
+  return binary;
+}
+
+uint64_t load_dada_header(const char *buffer, int size, dada_header_t *header){
+
+  const dada_header_binary_t *binary = find_dada_header_binary(buffer, size);
+  if (binary) {
+    memcpy(header, &binary->header, sizeof(dada_header_t));
+    return 0;
+  }
+
+  return parse_dada_header(buffer, header);
+}
+
+"""
+)
+
 # write to file function
 source_file.write(
     "int write_dada_header_to_file(const dada_header_t header, const char *fname){\n\n"
@@ -147,10 +737,15 @@ source_file.write(
 )
 source_file.write("  memset(buffer, 0, DADA_DEFAULT_HEADER_SIZE);\n\n")
 source_file.write(
-    '  sprintf(buffer, "HDR_VERSION  1.0\\nHDR_SIZE     4096\\n");\n'
+    '  int length = sprintf(buffer, "HDR_VERSION  1.0\\nHDR_SIZE     4096\\n");\n'
 )
-source_file.write("  write_dada_header(header, buffer);\n")
-source_file.write('  fprintf(fp, "%s\\n", buffer);\n\n')
+source_file.write(
+    "  serialize_dada_header(&header, buffer + length, DADA_DEFAULT_HEADER_SIZE - length, NULL);\n"
+)
+source_file.write(
+    "  write_dada_header_binary(&header, buffer, DADA_DEFAULT_HEADER_SIZE);\n"
+)
+source_file.write("  fwrite(buffer, 1, DADA_DEFAULT_HEADER_SIZE, fp);\n\n")
 source_file.write("  free(buffer);\n")
 source_file.write("  fclose(fp);\n\n")
 source_file.write("  return EXIT_SUCCESS;\n}\n\n")
@@ -159,6 +754,7 @@ source_file.write("  return EXIT_SUCCESS;\n}\n\n")
 source_file.write(
     "int write_dada_header(const dada_header_t header, char *buffer){\n\n"
 )
+source_file.write("  char value[DADA_HEADER_DOUBLE_WIDTH + 1];\n\n")
 
 for key in header:
     data_type = header[key]
@@ -167,15 +763,20 @@ for key in header:
     # print(f'  if \(ascii_header_get\(buffer, "{key}", "%d", header.{key.lower\(\)}\) < 0\)  {\n')
     if data_type == "int":
         data_type_marker = '"%d"'
-    if data_type == "float" or data_type == "double":
-        data_type_marker = '"%.15f"' # to keep enough digi
     if data_type == "string":
         data_type_marker = '"%s"'
     if data_type == "uint64_t":
         data_type_marker = '"%" PRIu64 ""'
 
+    member = f"header.{key.lower()}"
+    if data_type == "float" or data_type == "double":
+        # %.15f drops digits of small values, shortest round trip text keeps them all
+        data_type_marker = '"%s"'
+        source_file.write(f"  {format_member(data_type, member)};\n")
+        member = "value"
+
     source_file.write(
-        f'  if (ascii_header_set(buffer, "{key}", {data_type_marker}, header.{key.lower()}) < 0)'
+        f'  if (ascii_header_set(buffer, "{key}", {data_type_marker}, {member}) < 0)'
     )
     source_file.write("  {\n")
     source_file.write(
@@ -191,3 +792,124 @@ for key in header:
 source_file.write("  return EXIT_SUCCESS;\n}\n")
 
 source_file.close()
+
+# C++ header with a constexpr field table, accessors and visitors resolve at compile time
+cpp_file = open(cpp_header_fname, "w")
+
+cpp_file.write("#ifndef __DADA_HEADER_HPP\n")
+cpp_file.write("#define __DADA_HEADER_HPP\n\n")
+cpp_file.write("// Requires C++17, it uses inline constexpr, if constexpr, fold expressions and std::apply\n")
+cpp_file.write("#if __cplusplus < 201703L\n")
+cpp_file.write('#error "The DADA header reflection requires C++17"\n')
+cpp_file.write("#endif\n\n")
+
+cpp_file.write("#include <cstddef>\n")
+cpp_file.write("#include <cstdint>\n")
+cpp_file.write("#include <cstring>\n")
+cpp_file.write("#include <string_view>\n")
+cpp_file.write("#include <tuple>\n")
+cpp_file.write("#include <type_traits>\n\n")
+cpp_file.write(f'#include "{header_fname}"\n\n')
+
+cpp_file.write("namespace dada_header {\n\n")
+cpp_file.write(
+    """  enum class field_type {INT, UINT64, DOUBLE, FLOAT, STRING};
+
+  template <typename T> struct field_type_of;
+  template <> struct field_type_of<int>      {static constexpr field_type value = field_type::INT;};
+  template <> struct field_type_of<uint64_t> {static constexpr field_type value = field_type::UINT64;};
+  template <> struct field_type_of<double>   {static constexpr field_type value = field_type::DOUBLE;};
+  template <> struct field_type_of<float>    {static constexpr field_type value = field_type::FLOAT;};
+  template <> struct field_type_of<char[DADA_STRLEN]> {static constexpr field_type value = field_type::STRING;};
+
+  /// One member of dada_header_t, T is char[DADA_STRLEN] for strings
+  template <typename T>
+  struct field{
+    using type = T;
+    static constexpr field_type kind = field_type_of<T>::value;
+
+    const char *name;              ///< Key in the ASCII header
+    T dada_header_t::*member;      ///< Member pointer
+    std::size_t offset;            ///< Offset in dada_header_t
+    enum dada_header_key key;      ///< Bit in the missing key mask
+  };
+
+"""
+)
+cpp_file.write("  /// Fields in declaration order, index is enum dada_header_key\n")
+cpp_file.write("  inline constexpr auto fields = std::make_tuple(\n")
+entries = []
+for key in header:
+    data_type = header[key]
+    c_type = "char[DADA_STRLEN]" if data_type == "string" else data_type
+    entries.append(
+        f'    field<{c_type}>{{"{key}", &dada_header_t::{key.lower()}, offsetof(dada_header_t, {key.lower()}), DADA_HEADER_{key}}}'
+    )
+cpp_file.write(",\n".join(entries) + "\n  );\n\n")
+
+cpp_file.write(
+    """  inline constexpr std::size_t nfield = std::tuple_size_v<std::decay_t<decltype(fields)>>;
+  static_assert(nfield == DADA_HEADER_NKEY, "field table and key enum disagree");
+
+  /// Key of a name, -1 if the name is not in the spec, usable in constant expressions
+  constexpr int key_of(std::string_view name){
+    int key = -1;
+    int index = 0;
+    std::apply([&](const auto &...f){((name == f.name ? key = index : 0, index++), ...);}, fields);
+    return key;
+  }
+
+  /// Type of field Key
+  template <int Key>
+  using field_t = typename std::tuple_element_t<Key, std::decay_t<decltype(fields)>>::type;
+
+  /// Member of field Key, for example get<DADA_HEADER_NCHAN>(header) or get<key_of("NCHAN")>(header)
+  template <int Key>
+  constexpr auto &get(dada_header_t &header){
+    return header.*(std::get<Key>(fields).member);
+  }
+
+  template <int Key>
+  constexpr const auto &get(const dada_header_t &header){
+    return header.*(std::get<Key>(fields).member);
+  }
+
+  /// Call visitor(field, member) for every field, the loop unrolls at compile time
+  template <typename Header, typename Visitor>
+  constexpr void for_each_field(Header &header, Visitor &&visitor){
+    static_assert(std::is_same_v<std::remove_const_t<Header>, dada_header_t>, "for_each_field takes dada_header_t");
+    std::apply([&](const auto &...f){(visitor(f, header.*(f.member)), ...);}, fields);
+  }
+
+  /// Call visitor(field) for every field, without a header
+  template <typename Visitor>
+  constexpr void for_each_field(Visitor &&visitor){
+    std::apply([&](const auto &...f){(visitor(f), ...);}, fields);
+  }
+
+  /// Bytes of all members back to back, strings take DADA_STRLEN bytes
+  inline constexpr std::size_t packed_size = std::apply([](const auto &...f){
+      return (sizeof(typename std::decay_t<decltype(f)>::type) + ... + 0);
+    }, fields);
+
+  /// Copy all members back to back into buffer, buffer needs packed_size bytes
+  inline void pack(const dada_header_t &header, char *buffer){
+    for_each_field(header, [&](const auto &, const auto &member){
+	std::memcpy(buffer, &member, sizeof(member));
+	buffer += sizeof(member);
+      });
+  }
+
+  /// Inverse of pack
+  inline void unpack(const char *buffer, dada_header_t &header){
+    for_each_field(header, [&](const auto &, auto &member){
+	std::memcpy(&member, buffer, sizeof(member));
+	buffer += sizeof(member);
+      });
+  }
+}
+
+#endif
+"""
+)
+cpp_file.close()
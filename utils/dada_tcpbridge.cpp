@@ -0,0 +1,235 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "dada_tcpbridge.h"
+
+// Frame fields go little endian on the wire, the same conversion works both ways
+static dada_frame_t frame_to_wire(const dada_frame_t &frame){
+  dada_frame_t wire = {htole32(frame.magic), htole32(frame.type), htole64(frame.sequence), htole64(frame.nbytes)};
+  return wire;
+}
+
+static dada_frame_t frame_from_wire(const dada_frame_t &wire){
+  dada_frame_t frame = {le32toh(wire.magic), le32toh(wire.type), le64toh(wire.sequence), le64toh(wire.nbytes)};
+  return frame;
+}
+
+// Set socket buffer to hold ninflight blocks
+static void set_inflight(int sock, int ninflight, uint64_t bufsz, int send){
+  if(ninflight <= 0){
+    return;
+  }
+
+  tcp_options_t options;
+  tcp_default_options(&options);
+  uint64_t nbyte = ninflight*bufsz;
+  int value = nbyte > INT_MAX/2 ? INT_MAX/2 : (int)nbyte;
+  if(send){
+    options.sndbuf = value;
+  }
+  else{
+    options.rcvbuf = value;
+  }
+  apply_tcp_options(sock, &options);
+}
+
+DadaTcpSender::DadaTcpSender(dada_hdu_t *hdu, int sock, int ninflight)
+  :sock(sock){
+
+  header_block = dada_get_header_block(hdu);
+  data_block   = dada_get_data_block(hdu);
+  set_inflight(sock, ninflight, ipcbuf_get_bufsz(data_block), 1);
+}
+
+int DadaTcpSender::run(){
+  dada_frame_t frame = {DADA_FRAME_MAGIC, DADA_FRAME_HEADER, 0, 0};
+
+  // Header once
+  uint64_t hdrsz = 0;
+  char *header = ipcbuf_get_next_read(header_block, &hdrsz);
+  if(header == NULL){
+    fprintf(stderr, "DADA_TCPSENDER_ERROR: Could not get header from ring, "
+	    "which happens at \"%s\", line [%d], has to abort.\n",
+	    __FILE__, __LINE__);
+    return EXIT_FAILURE;
+  }
+  frame.nbytes = hdrsz;
+  dada_frame_t wire = frame_to_wire(frame);
+  struct iovec iov[2] = {{&wire, sizeof(wire)}, {header, hdrsz}};
+  if(sendbufv_tcp(sock, iov, 2)){
+    return EXIT_FAILURE;
+  }
+  ipcbuf_mark_cleared(header_block);
+
+  // Blocks until end of data, frame and block go together without copy
+  while(!ipcbuf_eod(data_block)){
+    uint64_t nbytes = 0;
+    char *block = ipcbuf_get_next_read(data_block, &nbytes);
+    if(block == NULL){
+      fprintf(stderr, "DADA_TCPSENDER_ERROR: Could not get block %" PRIu64 " from ring, "
+	      "which happens at \"%s\", line [%d], has to abort.\n",
+	      nblock_total, __FILE__, __LINE__);
+      return EXIT_FAILURE;
+    }
+
+    // An empty block only carries end of data, the END frame does that,
+    // so a chain of bridges does not grow an empty block at every hop
+    if(nbytes == 0){
+      ipcbuf_mark_cleared(data_block);
+      continue;
+    }
+
+    frame.type     = DADA_FRAME_BLOCK;
+    frame.sequence = nblock_total;
+    frame.nbytes   = nbytes;
+    wire = frame_to_wire(frame);
+    iov[1].iov_base = block;
+    iov[1].iov_len  = nbytes;
+    if(sendbufv_tcp(sock, iov, 2)){
+      return EXIT_FAILURE;
+    }
+    ipcbuf_mark_cleared(data_block);
+
+    nblock_total++;
+    nbyte_total += nbytes;
+  }
+
+  frame.type     = DADA_FRAME_END;
+  frame.sequence = nblock_total;
+  frame.nbytes   = nbyte_total;
+  wire = frame_to_wire(frame);
+  if(sendbuf_tcp(sock, (char *)&wire, sizeof(wire))){
+    return EXIT_FAILURE;
+  }
+
+  // Receiver tells us what it got
+  if(recvbuf_tcp(sock, (char *)&wire, sizeof(wire))){
+    return EXIT_FAILURE;
+  }
+  dada_frame_t ack = frame_from_wire(wire);
+  if(ack.magic != DADA_FRAME_MAGIC || ack.type != DADA_FRAME_ACK ||
+     ack.sequence != nblock_total || ack.nbytes != nbyte_total){
+    fprintf(stderr, "DADA_TCPSENDER_ERROR: Receiver got %" PRIu64 " blocks of %" PRIu64 " bytes, "
+	    "but we sent %" PRIu64 " blocks of %" PRIu64 " bytes, "
+	    "which happens at \"%s\", line [%d], has to abort.\n",
+	    ack.sequence, ack.nbytes, nblock_total, nbyte_total, __FILE__, __LINE__);
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
+
+DadaTcpReceiver::DadaTcpReceiver(dada_hdu_t *hdu, int sock, int ninflight)
+  :sock(sock){
+
+  header_block = dada_get_header_block(hdu);
+  data_block   = dada_get_data_block(hdu);
+  set_inflight(sock, ninflight, ipcbuf_get_bufsz(data_block), 0);
+}
+
+int DadaTcpReceiver::receive_frame(dada_frame_t &frame){
+  dada_frame_t wire;
+  if(recvbuf_tcp(sock, (char *)&wire, sizeof(wire))){
+    return EXIT_FAILURE;
+  }
+  frame = frame_from_wire(wire);
+  if(frame.magic != DADA_FRAME_MAGIC){
+    fprintf(stderr, "DADA_TCPRECEIVER_ERROR: Frame magic is %x, but it should be %x, "
+	    "which happens at \"%s\", line [%d], has to abort.\n",
+	    frame.magic, DADA_FRAME_MAGIC, __FILE__, __LINE__);
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
+
+int DadaTcpReceiver::run(){
+  dada_frame_t frame;
+
+  // Header first
+  if(receive_frame(frame)){
+    return EXIT_FAILURE;
+  }
+  uint64_t hdrsz = ipcbuf_get_bufsz(header_block);
+  if(frame.type != DADA_FRAME_HEADER || frame.nbytes > hdrsz){
+    fprintf(stderr, "DADA_TCPRECEIVER_ERROR: Expect a header of at most %" PRIu64 " bytes, "
+	    "but got frame type %u of %" PRIu64 " bytes, "
+	    "which happens at \"%s\", line [%d], has to abort.\n",
+	    hdrsz, frame.type, frame.nbytes, __FILE__, __LINE__);
+    return EXIT_FAILURE;
+  }
+  char *header = ipcbuf_get_next_write(header_block);
+  if(header == NULL || recvbuf_tcp(sock, header, frame.nbytes)){
+    return EXIT_FAILURE;
+  }
+  if(ipcbuf_mark_filled(header_block, frame.nbytes) < 0){
+    fprintf(stderr, "DADA_TCPRECEIVER_ERROR: Could not mark header filled, "
+	    "which happens at \"%s\", line [%d], has to abort.\n",
+	    __FILE__, __LINE__);
+    return EXIT_FAILURE;
+  }
+
+  // Blocks go straight into the ring
+  uint64_t bufsz = ipcbuf_get_bufsz(data_block);
+  while(true){
+    if(receive_frame(frame)){
+      return EXIT_FAILURE;
+    }
+
+    if(frame.type == DADA_FRAME_END){
+      int status = EXIT_SUCCESS;
+      if(frame.sequence != nblock_total || frame.nbytes != nbyte_total){
+	fprintf(stderr, "DADA_TCPRECEIVER_ERROR: Sender sent %" PRIu64 " blocks of %" PRIu64 " bytes, "
+		"but we got %" PRIu64 " blocks of %" PRIu64 " bytes, "
+		"which happens at \"%s\", line [%d], has to abort.\n",
+		frame.sequence, frame.nbytes, nblock_total, nbyte_total, __FILE__, __LINE__);
+	status = EXIT_FAILURE;
+      }
+
+      // End of data goes with an empty block, the same as ipcio_close, readers stop even on mismatch
+      if(ipcbuf_get_next_write(data_block) == NULL ||
+	 ipcbuf_enable_eod(data_block) < 0 ||
+	 ipcbuf_mark_filled(data_block, 0) < 0){
+	fprintf(stderr, "DADA_TCPRECEIVER_ERROR: Could not mark end of data, "
+		"which happens at \"%s\", line [%d], has to abort.\n",
+		__FILE__, __LINE__);
+	return EXIT_FAILURE;
+      }
+
+      dada_frame_t ack = frame_to_wire({DADA_FRAME_MAGIC, DADA_FRAME_ACK, nblock_total, nbyte_total});
+      if(sendbuf_tcp(sock, (char *)&ack, sizeof(ack))){
+	return EXIT_FAILURE;
+      }
+      return status;
+    }
+
+    if(frame.type != DADA_FRAME_BLOCK || frame.sequence != nblock_total || frame.nbytes > bufsz){
+      fprintf(stderr, "DADA_TCPRECEIVER_ERROR: Expect block %" PRIu64 " of at most %" PRIu64 " bytes, "
+	      "but got frame type %u, sequence %" PRIu64 " of %" PRIu64 " bytes, "
+	      "which happens at \"%s\", line [%d], has to abort.\n",
+	      nblock_total, bufsz, frame.type, frame.sequence, frame.nbytes, __FILE__, __LINE__);
+      return EXIT_FAILURE;
+    }
+
+    char *block = ipcbuf_get_next_write(data_block);
+    if(block == NULL){
+      fprintf(stderr, "DADA_TCPRECEIVER_ERROR: Could not get block %" PRIu64 " from ring, "
+	      "which happens at \"%s\", line [%d], has to abort.\n",
+	      nblock_total, __FILE__, __LINE__);
+      return EXIT_FAILURE;
+    }
+    if(recvbuf_tcp(sock, block, frame.nbytes)){
+      return EXIT_FAILURE;
+    }
+    if(ipcbuf_mark_filled(data_block, frame.nbytes) < 0){
+      fprintf(stderr, "DADA_TCPRECEIVER_ERROR: Could not mark block %" PRIu64 " filled, "
+	      "which happens at \"%s\", line [%d], has to abort.\n",
+	      nblock_total, __FILE__, __LINE__);
+      return EXIT_FAILURE;
+    }
+
+    nblock_total++;
+    nbyte_total += frame.nbytes;
+  }
+}
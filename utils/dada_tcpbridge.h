@@ -0,0 +1,113 @@
+#ifndef _DADA_TCPBRIDGE_H
+#define _DADA_TCPBRIDGE_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+
+#include <endian.h>
+#include <sys/uio.h>
+
+#include "dada_utils.h"
+#include "tcp_utils.h"
+
+#define DADA_FRAME_MAGIC  0x41444144 ///< "DADA" in little endian, first field of every frame
+
+enum dada_frame_type {DADA_FRAME_HEADER = 0, DADA_FRAME_BLOCK = 1, DADA_FRAME_END = 2, DADA_FRAME_ACK = 3};
+
+/// Frame in front of every header and block on the wire, fields are little endian
+typedef struct dada_frame_t{
+  uint32_t magic;    ///< DADA_FRAME_MAGIC
+  uint32_t type;     ///< enum dada_frame_type
+  uint64_t sequence; ///< Block number, number of blocks for DADA_FRAME_END and DADA_FRAME_ACK
+  uint64_t nbytes;   ///< Bytes after the frame, total data bytes for DADA_FRAME_END and DADA_FRAME_ACK
+}dada_frame_t;
+
+/*! \brief A class to send a DADA ring to a socket, the sending half of a DADA bridge over TCP
+ *
+ * The class takes an HDU locked for read, for example from `dada_setup_hdu`, and a connected socket,
+ * for example from `create_tcp_socket` in TCP_SEND direction.
+ * It sends the ASCII header once and then every data block with a small frame of length and sequence,
+ * frame and block go out with one `sendbufv_tcp` call straight from the ring, the block is cleared after that.
+ * The sender never waits for the receiver between blocks, so several blocks are in flight,
+ * \p ninflight sizes the socket send buffer to hold that many blocks.
+ *
+ * An empty block only carries end of data, it is cleared without being sent.
+ * At end of data it sends DADA_FRAME_END and waits for DADA_FRAME_ACK, so it knows every block landed.
+ *
+ */
+class DadaTcpSender{
+public:
+  uint64_t nblock_total = 0; ///< Number of blocks sent
+  uint64_t nbyte_total  = 0; ///< Number of data bytes sent
+
+  //! Constructor of DadaTcpSender class.
+  /*!
+   *
+   * \param[in] hdu       HDU locked for read, the class does not unlock it
+   * \param[in] sock      Connected socket, the class does not close it
+   * \param[in] ninflight Number of blocks the socket send buffer should hold, 0 keeps the default
+   *
+   */
+  DadaTcpSender(dada_hdu_t *hdu, int sock, int ninflight = 0);
+
+  /*! Send header and blocks until end of data
+   *
+   * \returns EXIT_SUCCESS when the receiver acknowledged every block, EXIT_FAILURE otherwise
+   */
+  int run();
+
+  DadaTcpSender(const DadaTcpSender&) = delete;
+  DadaTcpSender& operator=(const DadaTcpSender&) = delete;
+
+private:
+  int sock;                ///< Socket to send blocks to
+  ipcbuf_t *header_block;  ///< Header ring of the HDU
+  ipcbuf_t *data_block;    ///< Data ring of the HDU
+};
+
+/*! \brief A class to receive a DADA ring from a socket, the receiving half of a DADA bridge over TCP
+ *
+ * The class takes an HDU locked for write and a connected socket, for example from `create_tcp_socket`
+ * in TCP_RECV direction. Each block is received with `recvbuf_tcp` straight into the block from
+ * `dada_get_data_block` and marked filled, there is no intermediate buffer.
+ * At DADA_FRAME_END it marks end of data on the ring and acknowledges.
+ *
+ */
+class DadaTcpReceiver{
+public:
+  uint64_t nblock_total = 0; ///< Number of blocks received
+  uint64_t nbyte_total  = 0; ///< Number of data bytes received
+
+  //! Constructor of DadaTcpReceiver class.
+  /*!
+   *
+   * \param[in] hdu       HDU locked for write, the class does not unlock it
+   * \param[in] sock      Connected socket, the class does not close it
+   * \param[in] ninflight Number of blocks the socket receive buffer should hold, 0 keeps the default
+   *
+   */
+  DadaTcpReceiver(dada_hdu_t *hdu, int sock, int ninflight = 0);
+
+  /*! Receive header and blocks until end of data
+   *
+   * \returns EXIT_SUCCESS at end of data, EXIT_FAILURE on error or broken stream
+   */
+  int run();
+
+  DadaTcpReceiver(const DadaTcpReceiver&) = delete;
+  DadaTcpReceiver& operator=(const DadaTcpReceiver&) = delete;
+
+private:
+  int sock;                ///< Socket to receive blocks from
+  ipcbuf_t *header_block;  ///< Header ring of the HDU
+  ipcbuf_t *data_block;    ///< Data ring of the HDU
+
+  int receive_frame(dada_frame_t &frame); ///< Receive and check a frame
+};
+
+#endif
@@ -0,0 +1,333 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "epoll_engine.h"
+
+static inline int64_t now_ns(){
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (int64_t)now.tv_sec*1000000000L + now.tv_nsec;
+}
+
+static inline struct timespec to_timespec(double second){
+  struct timespec ts;
+  ts.tv_sec  = (time_t)second;
+  ts.tv_nsec = (long)((second - ts.tv_sec)*1E9);
+  return ts;
+}
+
+EpollEngine::EpollEngine(int spin_us, int busy_poll_us)
+  :busy_poll_us(busy_poll_us){
+
+  spin_max = spin_us > 0 ? spin_us*1000 : 0;
+  spin_ns  = spin_max;
+
+  epfd   = epoll_create1(EPOLL_CLOEXEC);
+  wakefd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  toutfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  if(epfd < 0 || wakefd < 0 || toutfd < 0){
+    fprintf(stderr, "EPOLL_ENGINE_ERROR: Could not create epoll instance with \"%s\", "
+	    "which happens at \"%s\", line [%d], has to abort.\n",
+	    strerror(errno), __FILE__, __LINE__);
+    exit(EXIT_FAILURE);
+  }
+
+  wake_handler = {wakefd, EPOLL_HANDLER_WAKE, false, nullptr, nullptr};
+  tout_handler = {toutfd, EPOLL_HANDLER_TOUT, false, nullptr, nullptr};
+
+  struct epoll_event event = {0};
+  event.events = EPOLLIN;
+  event.data.ptr = &wake_handler;
+  int ret = epoll_ctl(epfd, EPOLL_CTL_ADD, wakefd, &event);
+  event.data.ptr = &tout_handler;
+  ret |= epoll_ctl(epfd, EPOLL_CTL_ADD, toutfd, &event);
+  if(ret){
+    fprintf(stderr, "EPOLL_ENGINE_ERROR: Could not watch internal fds with \"%s\", "
+	    "which happens at \"%s\", line [%d], has to abort.\n",
+	    strerror(errno), __FILE__, __LINE__);
+    exit(EXIT_FAILURE);
+  }
+}
+
+EpollEngine::~EpollEngine(){
+  for(auto &item : handlers){
+    if(item.second->kind == EPOLL_HANDLER_TIMER){
+      close(item.first);
+    }
+    delete item.second;
+  }
+  for(handler *h : graveyard){
+    delete h;
+  }
+
+  close(toutfd);
+  close(wakefd);
+  close(epfd);
+}
+
+int EpollEngine::add(int fd, event_callback callback, uint32_t events){
+
+  if(busy_poll_us > 0){
+    if(setsockopt(fd, SOL_SOCKET, SO_BUSY_POLL, &busy_poll_us, sizeof(busy_poll_us))){
+      if(errno != ENOTSOCK){
+	fprintf(stderr, "EPOLL_ENGINE_ERROR: Could not setup SO_BUSY_POLL to %d microseconds with \"%s\", "
+		"which happens at \"%s\", line [%d], has to abort.\n",
+		busy_poll_us, strerror(errno), __FILE__, __LINE__);
+	return EXIT_FAILURE;
+      }
+    }
+    else{
+      // Best effort, older kernels do not have it
+      int enable = 1;
+      setsockopt(fd, SOL_SOCKET, SO_PREFER_BUSY_POLL, &enable, sizeof(enable));
+    }
+  }
+
+  handler *h = new handler{fd, EPOLL_HANDLER_FD, false, callback, nullptr};
+
+  struct epoll_event event = {0};
+  event.events   = events;
+  event.data.ptr = h;
+  if(epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &event)){
+    fprintf(stderr, "EPOLL_ENGINE_ERROR: Could not watch fd %d with \"%s\", "
+	    "which happens at \"%s\", line [%d], has to abort.\n",
+	    fd, strerror(errno), __FILE__, __LINE__);
+    delete h;
+    return EXIT_FAILURE;
+  }
+
+  handlers[fd] = h;
+  return EXIT_SUCCESS;
+}
+
+int EpollEngine::remove(int fd){
+  auto item = handlers.find(fd);
+  if(item == handlers.end()){
+    fprintf(stderr, "EPOLL_ENGINE_ERROR: fd %d is not watched, "
+	    "which happens at \"%s\", line [%d], has to abort.\n",
+	    fd, __FILE__, __LINE__);
+    return EXIT_FAILURE;
+  }
+
+  handler *h = item->second;
+  handlers.erase(item);
+
+  int ret = EXIT_SUCCESS;
+  if(epoll_ctl(epfd, EPOLL_CTL_DEL, fd, NULL)){
+    fprintf(stderr, "EPOLL_ENGINE_ERROR: Could not stop watching fd %d with \"%s\", "
+	    "which happens at \"%s\", line [%d], has to abort.\n",
+	    fd, strerror(errno), __FILE__, __LINE__);
+    ret = EXIT_FAILURE;
+  }
+  if(h->kind == EPOLL_HANDLER_TIMER){
+    close(fd);
+  }
+
+  // The handler may still be running or have events pending in the current batch
+  h->removed = true;
+  graveyard.push_back(h);
+
+  return ret;
+}
+
+int EpollEngine::arm(int fd, double first, double period){
+  struct itimerspec spec;
+  spec.it_value    = to_timespec(first);
+  spec.it_interval = to_timespec(period);
+  return timerfd_settime(fd, 0, &spec, NULL);
+}
+
+int EpollEngine::add_timer(double first, double period, timer_callback callback){
+
+  if(first <= 0){
+    fprintf(stderr, "EPOLL_ENGINE_ERROR: First expiration has to be positive, but it is %f, "
+	    "which happens at \"%s\", line [%d], has to abort.\n",
+	    first, __FILE__, __LINE__);
+    return -1;
+  }
+
+  int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  if(fd < 0 || arm(fd, first, period)){
+    fprintf(stderr, "EPOLL_ENGINE_ERROR: Could not create timer with \"%s\", "
+	    "which happens at \"%s\", line [%d], has to abort.\n",
+	    strerror(errno), __FILE__, __LINE__);
+    if(fd >= 0){
+      close(fd);
+    }
+    return -1;
+  }
+
+  handler *h = new handler{fd, EPOLL_HANDLER_TIMER, false, nullptr, callback};
+
+  struct epoll_event event = {0};
+  event.events   = EPOLLIN;
+  event.data.ptr = h;
+  if(epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &event)){
+    fprintf(stderr, "EPOLL_ENGINE_ERROR: Could not watch timer with \"%s\", "
+	    "which happens at \"%s\", line [%d], has to abort.\n",
+	    strerror(errno), __FILE__, __LINE__);
+    close(fd);
+    delete h;
+    return -1;
+  }
+
+  handlers[fd] = h;
+  return fd;
+}
+
+int EpollEngine::wait(double tout){
+
+  if(tout == 0){
+    nspin_total++;
+    int nevent = epoll_wait(epfd, events, EPOLL_ENGINE_NEVENT, 0);
+    return (nevent < 0 && errno == EINTR) ? 0 : nevent;
+  }
+
+  int64_t start    = now_ns();
+  int64_t deadline = tout > 0 ? start + (int64_t)(tout*1E9) : INT64_MAX;
+
+  // Spin phase
+  if(spin_max > 0){
+    int64_t spin_end = start + spin_ns < deadline ? start + spin_ns : deadline;
+    do{
+      nspin_total++;
+      int nevent = epoll_wait(epfd, events, EPOLL_ENGINE_NEVENT, 0);
+      if(nevent > 0){
+	nwake_spin++;
+	spin_ns = 2*spin_ns < spin_max ? 2*spin_ns : spin_max;
+	return nevent;
+      }
+      if(nevent < 0 && errno != EINTR){
+	return -1;
+      }
+      if(stopped.load(std::memory_order_relaxed)){
+	return 0;
+      }
+    }while(now_ns() < spin_end);
+
+    // Nothing during the spin, spin less next time
+    spin_ns = spin_ns/2 > EPOLL_ENGINE_SPIN_MIN ? spin_ns/2 : EPOLL_ENGINE_SPIN_MIN;
+  }
+
+  // Sleep phase, timerfd gives nanosecond timeout
+  if(tout > 0){
+    int64_t remain = deadline - now_ns();
+    if(remain <= 0){
+      return 0;
+    }
+    struct itimerspec spec = {{0, 0}, {remain/1000000000L, remain%1000000000L}};
+    if(timerfd_settime(toutfd, 0, &spec, NULL)){
+      return -1;
+    }
+  }
+
+  int nevent;
+  do{
+    nsleep_total++;
+    nevent = epoll_wait(epfd, events, EPOLL_ENGINE_NEVENT, -1);
+  }while(nevent < 0 && errno == EINTR);
+
+  // Disarm also clears an expiration we did not read
+  if(tout > 0){
+    arm(toutfd, 0, 0);
+  }
+
+  // Wake and timeout fds are not handler events
+  for(int i = 0; i < nevent; i++){
+    if(events[i].data.ptr != &wake_handler && events[i].data.ptr != &tout_handler){
+      nwake_sleep++;
+      break;
+    }
+  }
+  return nevent;
+}
+
+int EpollEngine::dispatch(int nevent){
+  int nhandled = 0;
+
+  for(int i = 0; i < nevent; i++){
+    handler *h = (handler *)events[i].data.ptr;
+    if(h->removed){
+      continue;
+    }
+
+    uint64_t count;
+    switch(h->kind){
+    case EPOLL_HANDLER_FD:
+      h->on_event(h->fd, events[i].events);
+      nhandled++;
+      break;
+
+    case EPOLL_HANDLER_TIMER:
+      if(read(h->fd, &count, sizeof(count)) == sizeof(count)){
+	h->on_timer(h->fd, count);
+	nhandled++;
+      }
+      break;
+
+    case EPOLL_HANDLER_WAKE:
+      if(read(h->fd, &count, sizeof(count)) < 0){
+	// Counter is already drained
+      }
+      break;
+
+    case EPOLL_HANDLER_TOUT:
+      // Timeout of run_once, nothing to handle
+      break;
+    }
+  }
+  nevent_total += nhandled;
+
+  for(handler *h : graveyard){
+    delete h;
+  }
+  graveyard.clear();
+
+  return nhandled;
+}
+
+int EpollEngine::run_once(double tout){
+  int nevent = wait(tout);
+  if(nevent < 0){
+    fprintf(stderr, "EPOLL_ENGINE_ERROR: epoll_wait failed with \"%s\", "
+	    "which happens at \"%s\", line [%d], has to abort.\n",
+	    strerror(errno), __FILE__, __LINE__);
+    return -1;
+  }
+
+  return dispatch(nevent);
+}
+
+int EpollEngine::run(double tout){
+  int ret = EXIT_SUCCESS;
+
+  while(!stopped.load(std::memory_order_acquire)){
+    int nhandled = run_once(tout);
+    if(nhandled < 0){
+      ret = EXIT_FAILURE;
+      break;
+    }
+    if(nhandled == 0 && tout >= 0 && !stopped.load(std::memory_order_acquire)){
+      // Idle for tout seconds
+      break;
+    }
+  }
+
+  // A stop while we were not asleep leaves its wake event, drain it so the next run does not see it as idle
+  uint64_t count;
+  if(read(wakefd, &count, sizeof(count)) < 0){
+    // Counter is already drained
+  }
+  stopped.store(false, std::memory_order_release);
+  return ret;
+}
+
+void EpollEngine::stop(){
+  stopped.store(true, std::memory_order_release);
+
+  uint64_t one = 1;
+  if(write(wakefd, &one, sizeof(one)) < 0){
+    // Counter is saturated, engine is going to wake up anyway
+  }
+}
@@ -0,0 +1,161 @@
+#ifndef _EPOLL_ENGINE_H
+#define _EPOLL_ENGINE_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include <time.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <sys/eventfd.h>
+
+#include <atomic>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+#ifndef SO_PREFER_BUSY_POLL
+#define SO_PREFER_BUSY_POLL 69
+#endif
+
+#define EPOLL_ENGINE_NEVENT   64   ///< Maximum number of events to pull with one `epoll_wait`
+#define EPOLL_ENGINE_SPIN_MIN 1000 ///< Lower bound of the adaptive spin window in nanoseconds
+
+/*! \brief An epoll based receive engine for nonblocking UDP and TCP sockets
+ *
+ * Sockets created by `create_udp_socket` or `create_tcp_socket` with `tout == 0` are nonblocking,
+ * the engine watches any number of them and calls a handler when one is ready, so callers do not spin on EAGAIN.
+ *
+ * Each wait spins with `epoll_wait(0)` for a short window first and sleeps in `epoll_wait(-1)` after it.
+ * The window is adaptive, it doubles up to \p spin_us when an event arrives during the spin
+ * and halves down to EPOLL_ENGINE_SPIN_MIN when the spin finds nothing,
+ * so a busy stream sees microsecond wake up latency and an idle stream does not pin a core.
+ *
+ * Timeouts use timerfd with nanosecond resolution instead of the millisecond timeout of `epoll_wait`
+ * or the SO_RCVTIMEO approximation of `tout`.
+ *
+ * Handlers run on the thread which calls run or run_once, they can add and remove fds, including their own.
+ *
+ */
+class EpollEngine{
+public:
+  /// Handler of a ready fd, \p events is the `epoll_event` mask
+  typedef std::function<void(int fd, uint32_t events)> event_callback;
+
+  /// Handler of a timer, \p nexpire is the number of expirations since the last call
+  typedef std::function<void(int fd, uint64_t nexpire)> timer_callback;
+
+  uint64_t nevent_total = 0; ///< Number of fd events handled since the class is created
+  uint64_t nspin_total  = 0; ///< Number of `epoll_wait(0)` calls since the class is created
+  uint64_t nsleep_total = 0; ///< Number of blocking `epoll_wait` calls since the class is created
+  uint64_t nwake_spin   = 0; ///< Number of waits which found events during the spin
+  uint64_t nwake_sleep  = 0; ///< Number of waits which found handler events after sleep, timeouts and stop do not count
+
+  //! Constructor of EpollEngine class.
+  /*!
+   *
+   * - create epoll instance, an eventfd to wake up the engine from other threads and a timerfd for run timeout
+   *
+   * \param[in] spin_us      Maximum spin window in microseconds before sleep, 0 disables spin
+   * \param[in] busy_poll_us SO_BUSY_POLL value in microseconds for sockets added later, 0 leaves sockets unchanged
+   *
+   */
+  EpollEngine(int spin_us = 50, int busy_poll_us = 0);
+
+  //! Deconstructor of EpollEngine class.
+  /*!
+   *
+   * - close timers created by the engine, the epoll instance and internal fds, watched sockets are not closed
+   */
+  ~EpollEngine();
+
+  /*! Watch \p fd and call \p callback when it is ready
+   *
+   * With busy_poll_us, sockets also get SO_BUSY_POLL and SO_PREFER_BUSY_POLL,
+   * values above net.core.busy_poll need CAP_NET_ADMIN.
+   *
+   * \param[in] fd       File descriptor to watch, it should be nonblocking
+   * \param[in] callback Handler of the fd
+   * \param[in] events   `epoll_event` mask, EPOLLIN by default, EPOLLET for edge trigger
+   *
+   * \returns EXIT_SUCCESS or EXIT_FAILURE
+   */
+  int add(int fd, event_callback callback, uint32_t events = EPOLLIN);
+
+  /*! Stop watching \p fd, timers created by add_timer are also closed
+   *
+   * \returns EXIT_SUCCESS or EXIT_FAILURE
+   */
+  int remove(int fd);
+
+  /*! Create a timer and call \p callback when it expires
+   *
+   * \param[in] first    Seconds to the first expiration, has to be positive
+   * \param[in] period   Seconds between later expirations, 0 for one shot timer
+   * \param[in] callback Handler of the timer
+   *
+   * \returns timer fd to be given to remove, -1 on failure
+   */
+  int add_timer(double first, double period, timer_callback callback);
+
+  /*! Wait once for events with spin then sleep, and call handlers
+   *
+   * \param[in] tout Timeout in seconds, negative value waits forever, 0 only polls
+   *
+   * \returns Number of events handled, 0 on timeout or stop, -1 on error
+   */
+  int run_once(double tout = -1);
+
+  /*! Call run_once until stop is called or no event arrives for \p tout seconds
+   *
+   * \param[in] tout Idle timeout in seconds, negative value waits forever
+   *
+   * \returns EXIT_SUCCESS on stop or timeout, EXIT_FAILURE on error
+   */
+  int run(double tout = -1);
+
+  //! Ask run to return, safe to call from handlers and other threads
+  void stop();
+
+  EpollEngine(const EpollEngine&) = delete;
+  EpollEngine& operator=(const EpollEngine&) = delete;
+
+private:
+  enum handler_kind {EPOLL_HANDLER_FD = 0, EPOLL_HANDLER_TIMER = 1, EPOLL_HANDLER_WAKE = 2, EPOLL_HANDLER_TOUT = 3};
+
+  struct handler{
+    int fd;
+    enum handler_kind kind;
+    bool removed;            ///< Set by remove, so that later events in the same batch are ignored
+    event_callback on_event;
+    timer_callback on_timer;
+  };
+
+  int epfd = -1;    ///< epoll instance
+  int wakefd = -1;  ///< eventfd to interrupt sleep from stop
+  int toutfd = -1;  ///< timerfd for run_once timeout
+
+  int spin_max;          ///< Maximum spin window in nanoseconds
+  int spin_ns;           ///< Current spin window in nanoseconds
+  int busy_poll_us;      ///< SO_BUSY_POLL for added sockets
+
+  std::atomic<bool> stopped{false};
+
+  handler wake_handler;  ///< Handler of wakefd
+  handler tout_handler;  ///< Handler of toutfd
+
+  std::unordered_map<int, handler *> handlers; ///< Watched fds
+  std::vector<handler *> graveyard;            ///< Removed handlers, freed after the current batch
+  struct epoll_event events[EPOLL_ENGINE_NEVENT];
+
+  int wait(double tout);             ///< Spin then sleep, returns number of events in events
+  int dispatch(int nevent);          ///< Call handlers of ready events, returns number of handled events
+  int arm(int fd, double first, double period); ///< Arm a timerfd
+};
+
+#endif
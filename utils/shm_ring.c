@@ -0,0 +1,310 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "shm_ring.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+static uint64_t align_up(uint64_t value, uint64_t align){
+  return (value + align - 1) / align * align;
+}
+
+static void spin_pause(void){
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#endif
+}
+
+// Size of one ring, sync area with filled bytes of every block and then the blocks
+static uint64_t ring_size(uint64_t nbufs, uint64_t bufsz){
+  return align_up(sizeof(shm_ring_sync_t) + nbufs*sizeof(uint64_t), SHM_RING_ALIGN) + align_up(nbufs*bufsz, SHM_RING_ALIGN);
+}
+
+static void init_sync(char *base, uint64_t offset, uint64_t nbufs, uint64_t bufsz){
+  shm_ring_sync_t *sync = (shm_ring_sync_t *)(base + offset);
+  sync->nbufs         = nbufs;
+  sync->bufsz         = bufsz;
+  sync->nbytes_offset = offset + sizeof(shm_ring_sync_t);
+  sync->offset        = offset + align_up(sizeof(shm_ring_sync_t) + nbufs*sizeof(uint64_t), SHM_RING_ALIGN);
+  sync->eod_count     = UINT64_MAX;
+}
+
+static void init_ring(shm_ring_t *ring, char *base, uint64_t offset){
+  ring->base   = base;
+  ring->sync   = (shm_ring_sync_t *)(base + offset);
+  ring->nbytes = (uint64_t *)(base + ring->sync->nbytes_offset);
+  ring->eod    = 0;
+}
+
+static int futex_wait(uint32_t *word, uint32_t value){
+  return syscall(SYS_futex, word, FUTEX_WAIT, value, NULL, NULL, 0);
+}
+
+static int futex_wake(uint32_t *word){
+  return syscall(SYS_futex, word, FUTEX_WAKE, 1, NULL, NULL, 0);
+}
+
+// Tell the other side a cursor moved, the futex is touched only when it sleeps
+static void notify(uint32_t *word, uint32_t *waiting){
+  __atomic_add_fetch(word, 1, __ATOMIC_SEQ_CST);
+  if(__atomic_exchange_n(waiting, 0, __ATOMIC_SEQ_CST)){
+    futex_wake(word);
+  }
+}
+
+static int readable(shm_ring_sync_t *sync, uint64_t r){
+  return __atomic_load_n(&sync->w_count, __ATOMIC_ACQUIRE) > r ||
+    __atomic_load_n(&sync->eod_count, __ATOMIC_ACQUIRE) <= r;
+}
+
+static int writable(shm_ring_sync_t *sync, uint64_t w){
+  return __atomic_load_n(&sync->r_count, __ATOMIC_ACQUIRE) + sync->nbufs > w;
+}
+
+/*
+  Poll for a while and then sleep on the futex word of the other side,
+  the word is read before waiting is set and the condition is checked after,
+  so a hand-off in between either shows up in the check or changes the word and the wait returns at once
+*/
+static void wait_for(shm_ring_sync_t *sync, uint64_t count, int (*ready)(shm_ring_sync_t *, uint64_t),
+		     uint32_t *word, uint32_t *waiting){
+  for(int i = 0; i < SHM_RING_NSPIN; i++){
+    if(ready(sync, count)){
+      return;
+    }
+    spin_pause();
+  }
+
+  while(1){
+    uint32_t value = __atomic_load_n(word, __ATOMIC_SEQ_CST);
+    __atomic_store_n(waiting, 1, __ATOMIC_SEQ_CST);
+    if(ready(sync, count)){
+      __atomic_store_n(waiting, 0, __ATOMIC_SEQ_CST);
+      return;
+    }
+    futex_wait(word, value);
+  }
+}
+
+shm_hdu_t *shm_create_hdu(uint64_t nhdr, uint64_t hdrsz, uint64_t nbufs, uint64_t bufsz, int hugepage){
+
+  if(nhdr == 0 || hdrsz == 0 || nbufs == 0 || bufsz == 0){
+    fprintf(stderr, "SHM_RING_ERROR: Ring needs at least one block of one byte, "
+	    "which happens at \"%s\", line [%d].\n",
+	    __FILE__, __LINE__);
+    return NULL;
+  }
+
+  uint64_t header_offset = align_up(sizeof(shm_hdu_layout_t), SHM_RING_ALIGN);
+  uint64_t data_offset   = header_offset + ring_size(nhdr, hdrsz);
+  uint64_t size          = align_up(data_offset + ring_size(nbufs, bufsz), hugepage ? SHM_RING_HUGEPAGE : SHM_RING_ALIGN);
+
+  int fd = memfd_create("shm_ring", hugepage ? MFD_HUGETLB : 0);
+  if(fd < 0){
+    fprintf(stderr, "SHM_RING_ERROR: memfd_create failed with \"%s\", "
+	    "which happens at \"%s\", line [%d].\n",
+	    strerror(errno), __FILE__, __LINE__);
+    return NULL;
+  }
+
+  if(ftruncate(fd, size)){
+    fprintf(stderr, "SHM_RING_ERROR: Could not size shared memory to %" PRIu64 " bytes, \"%s\", "
+	    "which happens at \"%s\", line [%d].\n",
+	    size, strerror(errno), __FILE__, __LINE__);
+    close(fd);
+    return NULL;
+  }
+
+  char *addr = (char *)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+  if(addr == MAP_FAILED){
+    fprintf(stderr, "SHM_RING_ERROR: mmap of %" PRIu64 " bytes failed with \"%s\", "
+	    "which happens at \"%s\", line [%d].\n",
+	    size, strerror(errno), __FILE__, __LINE__);
+    close(fd);
+    return NULL;
+  }
+
+  // A new memfd is zero, only non-zero fields are set
+  init_sync(addr, header_offset, nhdr, hdrsz);
+  init_sync(addr, data_offset, nbufs, bufsz);
+
+  shm_hdu_layout_t *layout = (shm_hdu_layout_t *)addr;
+  layout->size          = size;
+  layout->header_offset = header_offset;
+  layout->data_offset   = data_offset;
+  layout->version       = SHM_RING_VERSION;
+  __atomic_store_n(&layout->magic, SHM_RING_MAGIC, __ATOMIC_RELEASE);
+
+  shm_hdu_t *hdu = (shm_hdu_t *)malloc(sizeof(shm_hdu_t));
+  hdu->fd   = fd;
+  hdu->addr = addr;
+  hdu->size = size;
+  init_ring(&hdu->header_block, addr, header_offset);
+  init_ring(&hdu->data_block, addr, data_offset);
+
+  return hdu;
+}
+
+shm_hdu_t *shm_attach_hdu(int fd){
+
+  struct stat st;
+  if(fstat(fd, &st) || (uint64_t)st.st_size < sizeof(shm_hdu_layout_t)){
+    fprintf(stderr, "SHM_RING_ERROR: File descriptor %d is not a ring, "
+	    "which happens at \"%s\", line [%d].\n",
+	    fd, __FILE__, __LINE__);
+    return NULL;
+  }
+
+  uint64_t size = st.st_size;
+  char *addr = (char *)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+  if(addr == MAP_FAILED){
+    fprintf(stderr, "SHM_RING_ERROR: mmap of %" PRIu64 " bytes failed with \"%s\", "
+	    "which happens at \"%s\", line [%d].\n",
+	    size, strerror(errno), __FILE__, __LINE__);
+    return NULL;
+  }
+
+  shm_hdu_layout_t *layout = (shm_hdu_layout_t *)addr;
+  if(__atomic_load_n(&layout->magic, __ATOMIC_ACQUIRE) != SHM_RING_MAGIC ||
+     layout->version != SHM_RING_VERSION || layout->size != size){
+    fprintf(stderr, "SHM_RING_ERROR: File descriptor %d is not a ring of version %d, "
+	    "which happens at \"%s\", line [%d].\n",
+	    fd, SHM_RING_VERSION, __FILE__, __LINE__);
+    munmap(addr, size);
+    return NULL;
+  }
+
+  shm_hdu_t *hdu = (shm_hdu_t *)malloc(sizeof(shm_hdu_t));
+  hdu->fd   = fd;
+  hdu->addr = addr;
+  hdu->size = size;
+  init_ring(&hdu->header_block, addr, layout->header_offset);
+  init_ring(&hdu->data_block, addr, layout->data_offset);
+
+  return hdu;
+}
+
+int shm_remove_hdu(shm_hdu_t *hdu){
+  int status = EXIT_SUCCESS;
+
+  if(munmap(hdu->addr, hdu->size)){
+    fprintf(stderr, "SHM_RING_ERROR: munmap failed with \"%s\", "
+	    "which happens at \"%s\", line [%d].\n",
+	    strerror(errno), __FILE__, __LINE__);
+    status = EXIT_FAILURE;
+  }
+  close(hdu->fd);
+  free(hdu);
+
+  return status;
+}
+
+shm_ring_t *shm_get_data_block(shm_hdu_t *hdu){
+  return &hdu->data_block;
+}
+
+shm_ring_t *shm_get_header_block(shm_hdu_t *hdu){
+  return &hdu->header_block;
+}
+
+int shm_verify_block_size(int nbytes_expected, shm_ring_t *block){
+
+  int nbytes_actual = shm_ring_get_bufsz(block);
+
+  if(nbytes_expected != nbytes_actual){
+    fprintf(stderr, "SHM_RING_ERROR: Block size mismatch, "
+	    "expected %d bytes, but actual %d bytes, "
+	    "which happens at \"%s\", line [%d].\n",
+	    nbytes_expected, nbytes_actual,
+	    __FILE__, __LINE__);
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
+
+uint64_t shm_ring_get_bufsz(shm_ring_t *ring){
+  return ring->sync->bufsz;
+}
+
+uint64_t shm_ring_get_nbufs(shm_ring_t *ring){
+  return ring->sync->nbufs;
+}
+
+char *shm_ring_get_next_read(shm_ring_t *ring, uint64_t *nbytes){
+  shm_ring_sync_t *sync = ring->sync;
+  uint64_t r = __atomic_load_n(&sync->r_count, __ATOMIC_RELAXED);
+
+  wait_for(sync, r, readable, &sync->w_futex, &sync->r_waiting);
+
+  if(__atomic_load_n(&sync->w_count, __ATOMIC_ACQUIRE) <= r){
+    *nbytes = 0;
+    return NULL;
+  }
+
+  uint64_t slot = r % sync->nbufs;
+  *nbytes = ring->nbytes[slot];
+  return ring->base + sync->offset + slot*sync->bufsz;
+}
+
+int shm_ring_mark_cleared(shm_ring_t *ring){
+  shm_ring_sync_t *sync = ring->sync;
+  uint64_t r = __atomic_load_n(&sync->r_count, __ATOMIC_RELAXED);
+
+  if(r >= __atomic_load_n(&sync->w_count, __ATOMIC_ACQUIRE)){
+    fprintf(stderr, "SHM_RING_ERROR: No filled block to clear, "
+	    "which happens at \"%s\", line [%d].\n",
+	    __FILE__, __LINE__);
+    return EXIT_FAILURE;
+  }
+
+  __atomic_store_n(&sync->r_count, r + 1, __ATOMIC_SEQ_CST);
+  notify(&sync->r_futex, &sync->w_waiting);
+
+  return EXIT_SUCCESS;
+}
+
+char *shm_ring_get_next_write(shm_ring_t *ring){
+  shm_ring_sync_t *sync = ring->sync;
+  uint64_t w = __atomic_load_n(&sync->w_count, __ATOMIC_RELAXED);
+
+  wait_for(sync, w, writable, &sync->r_futex, &sync->w_waiting);
+
+  return ring->base + sync->offset + (w % sync->nbufs)*sync->bufsz;
+}
+
+int shm_ring_mark_filled(shm_ring_t *ring, uint64_t nbytes){
+  shm_ring_sync_t *sync = ring->sync;
+  uint64_t w = __atomic_load_n(&sync->w_count, __ATOMIC_RELAXED);
+
+  if(nbytes > sync->bufsz){
+    fprintf(stderr, "SHM_RING_ERROR: %" PRIu64 " bytes do not fit in a block of %" PRIu64 " bytes, "
+	    "which happens at \"%s\", line [%d].\n",
+	    nbytes, sync->bufsz, __FILE__, __LINE__);
+    return EXIT_FAILURE;
+  }
+
+  ring->nbytes[w % sync->nbufs] = nbytes;
+  if(ring->eod){
+    __atomic_store_n(&sync->eod_count, w + 1, __ATOMIC_RELEASE);
+    ring->eod = 0;
+  }
+  __atomic_store_n(&sync->w_count, w + 1, __ATOMIC_SEQ_CST);
+  notify(&sync->w_futex, &sync->r_waiting);
+
+  return EXIT_SUCCESS;
+}
+
+int shm_ring_enable_eod(shm_ring_t *ring){
+  ring->eod = 1;
+  return EXIT_SUCCESS;
+}
+
+int shm_ring_eod(shm_ring_t *ring){
+  shm_ring_sync_t *sync = ring->sync;
+  return __atomic_load_n(&sync->r_count, __ATOMIC_ACQUIRE) >= __atomic_load_n(&sync->eod_count, __ATOMIC_ACQUIRE);
+}
@@ -0,0 +1,141 @@
+#ifndef _SHM_RING_H
+#define _SHM_RING_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+#define SHM_RING_MAGIC    0x474E4952  ///< "RING" in little endian, first field of the shared memory
+#define SHM_RING_VERSION  1           ///< Layout version, a mismatch refuses to attach
+#define SHM_RING_ALIGN    4096        ///< Alignment of the sync area and of every block
+#define SHM_RING_HUGEPAGE (2 << 20)   ///< Size of a huge page, the mapping is rounded up to it with hugepage
+#define SHM_RING_NSPIN    128         ///< Number of polls before a side sleeps on the futex
+
+/*! \brief Cursors of one ring in shared memory
+ *
+ * Writer and reader counters live on their own cache lines, every counter has a single owner,
+ * the other side only loads it, so no lock is needed.
+ * The 32 bits words next to the counters are futex words, they change on every hand-off,
+ * a side which has to wait sleeps on the word of the other side, and is woken only when it says it sleeps.
+ *
+ */
+typedef struct shm_ring_sync_t{
+  uint64_t nbufs;          ///< Number of blocks
+  uint64_t bufsz;          ///< Size of each block in bytes
+  uint64_t offset;         ///< Offset of the first block from the start of the shared memory
+  uint64_t nbytes_offset;  ///< Offset of the filled bytes of every block from the start of the shared memory
+
+  uint64_t w_count __attribute__((aligned(64))); ///< Number of blocks filled, only the writer stores it
+  uint64_t eod_count;      ///< Number of blocks before end of data, UINT64_MAX when there is no end of data
+  uint32_t w_futex;        ///< Changes when a block is filled
+  uint32_t r_waiting;      ///< 1 when the reader sleeps on w_futex
+
+  uint64_t r_count __attribute__((aligned(64))); ///< Number of blocks cleared, only the reader stores it
+  uint32_t r_futex;        ///< Changes when a block is cleared
+  uint32_t w_waiting;      ///< 1 when the writer sleeps on r_futex
+}shm_ring_sync_t;
+
+/// One ring, the counterpart of `ipcbuf_t`, it points into the mapping of its HDU
+typedef struct shm_ring_t{
+  shm_ring_sync_t *sync;   ///< Cursors in shared memory
+  char *base;              ///< Start of the shared memory
+  uint64_t *nbytes;        ///< Filled bytes of every block
+  int eod;                 ///< 1 when the writer has enabled end of data for the next filled block
+}shm_ring_t;
+
+/// Start of the shared memory, tells where the header and data rings are
+typedef struct shm_hdu_layout_t{
+  uint32_t magic;          ///< SHM_RING_MAGIC
+  uint32_t version;        ///< SHM_RING_VERSION
+  uint64_t size;           ///< Size of the shared memory in bytes
+  uint64_t header_offset;  ///< Offset of the sync area of the header ring
+  uint64_t data_offset;    ///< Offset of the sync area of the data ring
+}shm_hdu_layout_t;
+
+/*! \brief A header ring and a data ring in one memfd, the counterpart of `dada_hdu_t`
+ *
+ * The memory comes from `memfd_create`, with hugepage from huge pages, so there is no key to manage
+ * and nothing to clean up, the memory goes away with the last process which maps it.
+ * Another process gets it with fork or by opening /proc/<pid>/fd/<fd>, and attaches with shm_attach_hdu.
+ *
+ * Each ring has one writer and one reader.
+ *
+ */
+typedef struct shm_hdu_t{
+  int fd;                  ///< memfd of the shared memory
+  char *addr;              ///< Start of the mapping
+  uint64_t size;           ///< Size of the mapping in bytes
+  shm_ring_t header_block; ///< Header ring
+  shm_ring_t data_block;   ///< Data ring
+}shm_hdu_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  /*! Create shared memory with a header ring and a data ring
+   *
+   * \param[in] nhdr     Number of header blocks
+   * \param[in] hdrsz    Size of each header block in bytes
+   * \param[in] nbufs    Number of data blocks
+   * \param[in] bufsz    Size of each data block in bytes
+   * \param[in] hugepage 1 to back the memory with huge pages
+   *
+   * \returns the HDU, NULL on failure
+   */
+  shm_hdu_t *shm_create_hdu(uint64_t nhdr, uint64_t hdrsz, uint64_t nbufs, uint64_t bufsz, int hugepage);
+
+  /*! Map shared memory created by shm_create_hdu in another process
+   *
+   * \param[in] fd memfd of the shared memory, the HDU takes it and closes it at shm_remove_hdu
+   *
+   * \returns the HDU, NULL when \p fd is not a ring of this version
+   */
+  shm_hdu_t *shm_attach_hdu(int fd);
+
+  /*! Unmap the shared memory and close its memfd
+   *
+   * \returns EXIT_FAILURE when `munmap` fails
+   */
+  int shm_remove_hdu(shm_hdu_t *hdu);
+
+  shm_ring_t *shm_get_data_block(shm_hdu_t *hdu);   ///< Data ring of the HDU
+  shm_ring_t *shm_get_header_block(shm_hdu_t *hdu); ///< Header ring of the HDU
+
+  int shm_verify_block_size(int nbytes_expected, shm_ring_t *block); ///< EXIT_FAILURE when the block size is not \p nbytes_expected
+
+  uint64_t shm_ring_get_bufsz(shm_ring_t *ring);  ///< Size of each block in bytes
+  uint64_t shm_ring_get_nbufs(shm_ring_t *ring);  ///< Number of blocks
+
+  /*! Wait for the next filled block
+   *
+   * \param[out] nbytes Filled bytes of the block
+   *
+   * \returns start of the block, NULL with \p nbytes 0 at end of data
+   */
+  char *shm_ring_get_next_read(shm_ring_t *ring, uint64_t *nbytes);
+
+  //! Give the block from shm_ring_get_next_read back to the writer
+  int shm_ring_mark_cleared(shm_ring_t *ring);
+
+  //! Wait for the next free block and return its start
+  char *shm_ring_get_next_write(shm_ring_t *ring);
+
+  //! Hand \p nbytes of the block from shm_ring_get_next_write to the reader
+  int shm_ring_mark_filled(shm_ring_t *ring, uint64_t nbytes);
+
+  //! Make the next shm_ring_mark_filled the last block before end of data
+  int shm_ring_enable_eod(shm_ring_t *ring);
+
+  //! 1 when the reader has cleared every block before end of data
+  int shm_ring_eod(shm_ring_t *ring);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,124 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "tcp_reader.h"
+
+TcpReader::TcpReader(int sock, size_t bufsz, int lowat)
+  :sock(sock), bufsz(bufsz){
+
+  buf = (char *)malloc(bufsz);
+  if(buf == NULL){
+    fprintf(stderr, "TCP_READER_ERROR: Could not allocate %zu bytes buffer, "
+	    "which happens at \"%s\", line [%d], has to abort.\n",
+	    bufsz, __FILE__, __LINE__);
+    exit(EXIT_FAILURE);
+  }
+
+  if(lowat > 0){
+    if(setsockopt(sock, SOL_SOCKET, SO_RCVLOWAT, &lowat, sizeof(lowat))){
+      fprintf(stderr, "TCP_READER_ERROR: Could not set SO_RCVLOWAT to %d with \"%s\", "
+	      "which happens at \"%s\", line [%d], has to abort.\n",
+	      lowat, strerror(errno), __FILE__, __LINE__);
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  nonblock = fcntl(sock, F_GETFL, 0) & O_NONBLOCK;
+}
+
+TcpReader::~TcpReader(){
+  free(buf);
+}
+
+int TcpReader::fill(size_t need){
+
+  // Move unread bytes to the front when the rest does not fit
+  if(head + need > bufsz){
+    memmove(buf, buf + head, tail - head);
+    tail -= head;
+    head  = 0;
+  }
+
+  while(tail - head < need){
+    ssize_t nread = recv(sock, buf + tail, bufsz - tail, 0);
+    nsyscall_total++;
+
+    if(nread < 0){
+      if(errno == EINTR){
+	continue;
+      }
+      if((errno == EAGAIN || errno == EWOULDBLOCK) && nonblock){
+	struct pollfd pfd = {sock, POLLIN, 0};
+	poll(&pfd, 1, -1);
+	continue;
+      }
+      fprintf(stderr, "TCP_READER_ERROR: recv failed with \"%s\", "
+	      "which happens at \"%s\", line [%d], has to abort.\n",
+	      strerror(errno), __FILE__, __LINE__);
+      return EXIT_FAILURE;
+    }
+    if(nread == 0){
+      fprintf(stderr, "TCP_READER_WARN: Connection closed with %zu of %zu bytes, "
+	      "which happens at \"%s\", line [%d], has to abort.\n",
+	      tail - head, need, __FILE__, __LINE__);
+      return EXIT_FAILURE;
+    }
+    tail += nread;
+  }
+
+  return EXIT_SUCCESS;
+}
+
+int TcpReader::read(char *dst, uint64_t nbytes){
+
+  // Buffered bytes first
+  size_t ncopy = tail - head < nbytes ? tail - head : nbytes;
+  memcpy(dst, buf + head, ncopy);
+  head += ncopy;
+  dst  += ncopy;
+  nbyte_total += ncopy;
+  uint64_t nleft = nbytes - ncopy;
+  if(nleft == 0){
+    return EXIT_SUCCESS;
+  }
+
+  // Buffer is empty now, large reads go straight to the caller
+  head = tail = 0;
+  if(nleft >= bufsz/2){
+    uint64_t nreceived = 0;
+    int ret = recvbuf_tcp(sock, dst, nleft, &nreceived);
+    nsyscall_total++;
+    ndirect_total += nreceived;
+    nbyte_total   += nreceived;
+    return ret;
+  }
+
+  if(fill(nleft)){
+    return EXIT_FAILURE;
+  }
+  memcpy(dst, buf, nleft);
+  head = nleft;
+  nbyte_total += nleft;
+
+  return EXIT_SUCCESS;
+}
+
+const char *TcpReader::next(size_t nbytes){
+  if(nbytes > bufsz){
+    fprintf(stderr, "TCP_READER_ERROR: %zu bytes do not fit in %zu bytes buffer, "
+	    "which happens at \"%s\", line [%d], has to abort.\n",
+	    nbytes, bufsz, __FILE__, __LINE__);
+    return NULL;
+  }
+
+  if(tail - head < nbytes && fill(nbytes)){
+    return NULL;
+  }
+
+  const char *ptr = buf + head;
+  head += nbytes;
+  nbyte_total += nbytes;
+
+  return ptr;
+}
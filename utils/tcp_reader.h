@@ -0,0 +1,75 @@
+#ifndef _TCP_READER_H
+#define _TCP_READER_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+
+#include <sys/socket.h>
+
+#include "tcp_utils.h"
+
+/*! \brief A buffered reader of a TCP stream with large reads
+ *
+ * The class wraps a socket created by `create_tcp_socket` and follows its timeout convention,
+ * a nonblocking socket waits until it is readable, a socket with timeout fails when no data arrives in time.
+ *
+ * Small reads, for example frame headers, are served from an internal buffer which is refilled
+ * with one `recv` of as many bytes as it can hold. Reads of at least half of the buffer go straight into
+ * the caller buffer with `recvbuf_tcp` and MSG_WAITALL, so large blocks are not copied twice.
+ *
+ * With \p lowat the socket gets SO_RCVLOWAT, so that a blocking read wakes up only when that many bytes are queued.
+ *
+ */
+class TcpReader{
+public:
+  uint64_t nbyte_total    = 0; ///< Number of bytes given to the caller since the class is created
+  uint64_t ndirect_total  = 0; ///< Number of bytes received straight into caller buffers
+  uint64_t nsyscall_total = 0; ///< Number of `recv` calls to refill the buffer plus number of direct reads
+
+  //! Constructor of TcpReader class.
+  /*!
+   *
+   * \param[in] sock  Socket to read from, the class does not close it
+   * \param[in] bufsz Size of the internal buffer in bytes
+   * \param[in] lowat SO_RCVLOWAT in bytes, 0 or negative value leaves the socket unchanged
+   *
+   */
+  TcpReader(int sock, size_t bufsz = 1 << 20, int lowat = 0);
+
+  //! Deconstructor of TcpReader class.
+  ~TcpReader();
+
+  /*! Read exactly \p nbytes into \p dst
+   *
+   * \returns EXIT_SUCCESS or EXIT_FAILURE on error, timeout or when peer closes the connection
+   */
+  int read(char *dst, uint64_t nbytes);
+
+  /*! Get the next \p nbytes without copy, pointer is valid until the next call of read or next
+   *
+   * \param[in] nbytes Number of bytes, at most the buffer size
+   *
+   * \returns Pointer to the bytes in the internal buffer, NULL on failure
+   */
+  const char *next(size_t nbytes);
+
+  TcpReader(const TcpReader&) = delete;
+  TcpReader& operator=(const TcpReader&) = delete;
+
+private:
+  int sock;           ///< Socket to read from
+  int nonblock;       ///< Nonzero if the socket is nonblocking
+  char *buf = NULL;   ///< Internal buffer
+  size_t bufsz;       ///< Size of internal buffer
+  size_t head = 0;    ///< First unread byte in the buffer
+  size_t tail = 0;    ///< End of received bytes in the buffer
+
+  int fill(size_t need); ///< Receive until the buffer holds at least \p need unread bytes
+};
+
+#endif
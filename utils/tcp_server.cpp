@@ -0,0 +1,177 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "tcp_server.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+TcpServer::TcpServer(char *ip, int port, int nthread, size_t bufsz, int sockbuf, int spin_us)
+  :nthread(nthread), bufsz(bufsz){
+
+  if(create_tcp_listener(ip, port, listener, 1, sockbuf, 0)){
+    fprintf(stderr, "TCP_SERVER_ERROR: Could not listen on %s_%d, "
+	    "which happens at \"%s\", line [%d], has to abort.\n",
+	    ip, port, __FILE__, __LINE__);
+    exit(EXIT_FAILURE);
+  }
+
+  for(int i = 0; i < nthread; i++){
+    workers.emplace_back(new worker(spin_us));
+  }
+}
+
+TcpServer::~TcpServer(){
+  stop();
+
+  for(auto &w : workers){
+    for(char *buf : w->buffers){
+      free(buf);
+    }
+  }
+  close(listener);
+}
+
+void TcpServer::accept_all(worker &w){
+  while(true){
+    struct sockaddr_in peer;
+    socklen_t len = sizeof(peer);
+    int fd = accept4(listener, (struct sockaddr *)&peer, &len, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if(fd < 0){
+      if(errno == EINTR || errno == ECONNABORTED){
+	continue;
+      }
+      if(errno != EAGAIN && errno != EWOULDBLOCK){
+	fprintf(stderr, "TCP_SERVER_ERROR: accept failed with \"%s\", "
+		"which happens at \"%s\", line [%d], has to abort.\n",
+		strerror(errno), __FILE__, __LINE__);
+      }
+      // Another worker may have taken it
+      return;
+    }
+
+    // Reuse a buffer of a closed connection if we have one
+    char *buf;
+    if(w.buffers.empty()){
+      buf = (char *)malloc(bufsz);
+      if(buf == NULL){
+	fprintf(stderr, "TCP_SERVER_ERROR: Could not allocate %zu bytes buffer, "
+		"which happens at \"%s\", line [%d], has to abort.\n",
+		bufsz, __FILE__, __LINE__);
+	close(fd);
+	continue;
+      }
+      nbuffer_total++;
+    }
+    else{
+      buf = w.buffers.back();
+      w.buffers.pop_back();
+    }
+
+    struct tcp_connection *conn = new tcp_connection{fd, naccept_total++, peer, buf, bufsz, NULL};
+    w.connections[fd] = conn;
+    if(on_open){
+      on_open(*conn);
+    }
+
+    if(w.engine.add(fd, [this, &w, conn](int, uint32_t){serve(w, conn);})){
+      // Never registered, so only undo the accept
+      if(on_close){
+	on_close(*conn);
+      }
+      close(fd);
+      w.connections.erase(fd);
+      w.buffers.push_back(buf);
+      nclose_total++;
+      delete conn;
+    }
+  }
+}
+
+void TcpServer::serve(worker &w, struct tcp_connection *conn){
+  ssize_t nread = recv(conn->fd, conn->buf, conn->bufsz, 0);
+
+  if(nread > 0){
+    nbyte_total += nread;
+    if(on_data(*conn, conn->buf, nread)){
+      close_connection(w, conn);
+    }
+    return;
+  }
+  if(nread < 0 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK)){
+    return;
+  }
+
+  // Peer closed or connection failed
+  close_connection(w, conn);
+}
+
+void TcpServer::close_connection(worker &w, struct tcp_connection *conn){
+  if(on_close){
+    on_close(*conn);
+  }
+
+  w.engine.remove(conn->fd);
+  close(conn->fd);
+  w.connections.erase(conn->fd);
+  w.buffers.push_back(conn->buf);
+  nclose_total++;
+
+  delete conn;
+}
+
+void TcpServer::run(worker &w, int cpu){
+  if(cpu >= 0){
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    CPU_SET(cpu, &cpuset);
+    if(pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset)){
+      fprintf(stderr, "TCP_SERVER_ERROR: Could not pin worker to CPU %d, "
+	      "which happens at \"%s\", line [%d], has to abort.\n",
+	      cpu, __FILE__, __LINE__);
+    }
+  }
+
+  // Only one worker wakes up for a new connection
+  if(w.engine.add(listener, [this, &w](int, uint32_t){accept_all(w);}, EPOLLIN | EPOLLEXCLUSIVE)){
+    return;
+  }
+
+  w.engine.run();
+
+  // Close what is still open on this worker
+  while(!w.connections.empty()){
+    close_connection(w, w.connections.begin()->second);
+  }
+  w.engine.remove(listener);
+}
+
+void TcpServer::start(data_callback on_data, connection_callback on_open,
+		      connection_callback on_close, const int *cpus){
+  if(running){
+    return;
+  }
+  this->on_data  = on_data;
+  this->on_open  = on_open;
+  this->on_close = on_close;
+
+  for(int i = 0; i < nthread; i++){
+    worker &w = *workers[i];
+    w.thread = std::thread(&TcpServer::run, this, std::ref(w), cpus ? cpus[i] : -1);
+  }
+  running = true;
+}
+
+void TcpServer::stop(){
+  if(!running){
+    return;
+  }
+  for(auto &w : workers){
+    w->engine.stop();
+  }
+  for(auto &w : workers){
+    w->thread.join();
+  }
+  running = false;
+}
@@ -0,0 +1,126 @@
+#ifndef _TCP_SERVER_H
+#define _TCP_SERVER_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "tcp_utils.h"
+#include "epoll_engine.h"
+
+/// One accepted connection, it lives on the worker thread which accepted it
+struct tcp_connection{
+  int fd;                    ///< Connected socket
+  uint64_t id;               ///< Connection number since the server starts
+  struct sockaddr_in peer;   ///< Address of the peer
+  char *buf;                 ///< Receive buffer, reused by later connections after close
+  size_t bufsz;              ///< Size of receive buffer in bytes
+  void *user;                ///< Free for the caller, NULL at accept
+};
+
+/*! \brief A TCP server which serves many concurrent streams from a small thread pool
+ *
+ * The server keeps a nonblocking listening socket created by `create_tcp_listener`.
+ * Every worker thread runs its own EpollEngine which watches the listening socket with EPOLLEXCLUSIVE,
+ * so one worker wakes up for a new connection, accepts it and serves it until it closes,
+ * connections never move between threads and handlers need no lock.
+ *
+ * Receive buffers come from a free list of the worker, a closed connection gives its buffer back
+ * and the next accept takes it, so buffers are allocated only when concurrent connections grow.
+ *
+ * Handlers are called on the worker thread, the data handler gets the bytes of one `recv`
+ * and returns EXIT_FAILURE to close the connection.
+ *
+ */
+class TcpServer{
+public:
+  /// Handler of received bytes, \p data points into conn.buf and is valid until the handler returns
+  typedef std::function<int(struct tcp_connection &conn, const char *data, size_t nbytes)> data_callback;
+
+  /// Handler of a connection start or end, for example to setup or free conn.user
+  typedef std::function<void(struct tcp_connection &conn)> connection_callback;
+
+  std::atomic<uint64_t> naccept_total{0}; ///< Number of accepted connections
+  std::atomic<uint64_t> nclose_total{0};  ///< Number of closed connections
+  std::atomic<uint64_t> nbyte_total{0};   ///< Number of bytes received
+  std::atomic<uint64_t> nbuffer_total{0}; ///< Number of receive buffers allocated
+
+  //! Constructor of TcpServer class.
+  /*!
+   *
+   * - create listening socket, so clients can connect once the constructor returns
+   *
+   * \param[in] ip      IP address to listen on
+   * \param[in] port    Port to listen on
+   * \param[in] nthread Number of worker threads
+   * \param[in] bufsz   Receive buffer size of each connection in bytes
+   * \param[in] sockbuf Socket buffer size in MBytes, 0 means the default value
+   * \param[in] spin_us Spin window of the EpollEngine of each worker, 0 sleeps right away
+   *
+   */
+  TcpServer(char *ip, int port, int nthread, size_t bufsz, int sockbuf = 0, int spin_us = 0);
+
+  //! Deconstructor of TcpServer class.
+  /*!
+   *
+   * - stop workers if they run, close listening socket and free buffers
+   */
+  ~TcpServer();
+
+  /*! Start worker threads
+   *
+   * \param[in] on_data  Handler of received bytes
+   * \param[in] on_open  Handler of a new connection, can be nullptr
+   * \param[in] on_close Handler of a closing connection, can be nullptr
+   * \param[in] cpus     CPU for each worker, NULL leaves threads unpinned
+   */
+  void start(data_callback on_data, connection_callback on_open = nullptr,
+	     connection_callback on_close = nullptr, const int *cpus = NULL);
+
+  //! Stop worker threads and close all connections
+  void stop();
+
+  TcpServer(const TcpServer&) = delete;
+  TcpServer& operator=(const TcpServer&) = delete;
+
+private:
+  struct worker{
+    EpollEngine engine;
+    std::thread thread;
+    std::vector<char *> buffers;                             ///< Free receive buffers
+    std::unordered_map<int, struct tcp_connection *> connections; ///< Open connections
+
+    worker(int spin_us) : engine(spin_us) {}
+  };
+
+  int listener = -1;   ///< Listening socket
+  int nthread;         ///< Number of workers
+  size_t bufsz;        ///< Receive buffer size
+
+  data_callback on_data;
+  connection_callback on_open;
+  connection_callback on_close;
+
+  std::vector<std::unique_ptr<worker>> workers;
+  bool running = false;
+
+  void accept_all(worker &w);                          ///< Accept pending connections on a worker
+  void serve(worker &w, struct tcp_connection *conn);  ///< Receive once from a ready connection
+  void close_connection(worker &w, struct tcp_connection *conn); ///< Close a connection and recycle its buffer
+  void run(worker &w, int cpu);                        ///< Worker loop
+};
+
+#endif
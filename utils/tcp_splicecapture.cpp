@@ -0,0 +1,179 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "tcp_splicecapture.h"
+
+TcpSpliceCapture::TcpSpliceCapture(int sock, const char *prefix, uint64_t file_size,
+				   size_t sample_size, uint64_t sample_interval,
+				   sample_callback on_sample)
+  :sock(sock), file_size(file_size), sample_size(sample_size),
+   sample_interval(sample_interval), on_sample(on_sample){
+
+  snprintf(this->prefix, sizeof(this->prefix), "%s", prefix);
+
+  if(file_size == 0){
+    fprintf(stderr, "TCP_SPLICECAPTURE_ERROR: FILE_SIZE has to be positive, "
+	    "which happens at \"%s\", line [%d], has to abort.\n",
+	    __FILE__, __LINE__);
+    exit(EXIT_FAILURE);
+  }
+
+  if(pipe2(pipefd, O_CLOEXEC) || (sample_size && pipe2(teefd, O_CLOEXEC))){
+    fprintf(stderr, "TCP_SPLICECAPTURE_ERROR: Could not create pipe with \"%s\", "
+	    "which happens at \"%s\", line [%d], has to abort.\n",
+	    strerror(errno), __FILE__, __LINE__);
+    exit(EXIT_FAILURE);
+  }
+
+  // Larger pipe means fewer splice calls, kernel may give less than we ask
+  fcntl(pipefd[1], F_SETPIPE_SZ, TCP_SPLICE_PIPE_SIZE);
+  int size = fcntl(pipefd[1], F_GETPIPE_SZ);
+  pipe_size = size > 0 ? size : 65536;
+
+  if(sample_size){
+    if(fcntl(teefd[1], F_SETPIPE_SZ, (int)sample_size) < 0){
+      // Sample is cut to whatever the pipe holds
+    }
+    sample = (char *)malloc(sample_size);
+    if(sample == NULL){
+      fprintf(stderr, "TCP_SPLICECAPTURE_ERROR: Could not allocate %zu bytes sample buffer, "
+	      "which happens at \"%s\", line [%d], has to abort.\n",
+	      sample_size, __FILE__, __LINE__);
+      exit(EXIT_FAILURE);
+    }
+  }
+}
+
+TcpSpliceCapture::~TcpSpliceCapture(){
+  if(fd >= 0){
+    close(fd);
+  }
+  for(int i = 0; i < 2; i++){
+    if(pipefd[i] >= 0){
+      close(pipefd[i]);
+    }
+    if(teefd[i] >= 0){
+      close(teefd[i]);
+    }
+  }
+  free(sample);
+}
+
+int TcpSpliceCapture::rotate(){
+  if(fd >= 0){
+    close(fd);
+  }
+
+  char fname[PATH_MAX + 32];
+  snprintf(fname, sizeof(fname), "%s_%016" PRIu64 ".raw", prefix, nbyte_total);
+  fd = open(fname, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if(fd < 0){
+    fprintf(stderr, "TCP_SPLICECAPTURE_ERROR: Could not open %s with \"%s\", "
+	    "which happens at \"%s\", line [%d], has to abort.\n",
+	    fname, strerror(errno), __FILE__, __LINE__);
+    return EXIT_FAILURE;
+  }
+  file_written = 0;
+  nfile++;
+
+  return EXIT_SUCCESS;
+}
+
+int TcpSpliceCapture::take_sample(size_t nbytes){
+  size_t want = nbytes < sample_size ? nbytes : sample_size;
+
+  // tee duplicates pipe content without consuming it
+  ssize_t ntee = tee(pipefd[0], teefd[1], want, SPLICE_F_NONBLOCK);
+  nsyscall_total++;
+  if(ntee <= 0){
+    return EXIT_SUCCESS;
+  }
+
+  ssize_t nread = 0;
+  while(nread < ntee){
+    ssize_t n = read(teefd[0], sample + nread, ntee - nread);
+    if(n < 0 && errno == EINTR){
+      continue;
+    }
+    if(n <= 0){
+      fprintf(stderr, "TCP_SPLICECAPTURE_ERROR: Could not read sample with \"%s\", "
+	      "which happens at \"%s\", line [%d], has to abort.\n",
+	      strerror(errno), __FILE__, __LINE__);
+      return EXIT_FAILURE;
+    }
+    nread += n;
+  }
+
+  nsample_total++;
+  if(on_sample){
+    on_sample(nbyte_total, sample, nread);
+  }
+
+  return EXIT_SUCCESS;
+}
+
+int TcpSpliceCapture::capture(){
+
+  while(true){
+    if(fd < 0 || file_written == file_size){
+      if(rotate()){
+	return EXIT_FAILURE;
+      }
+    }
+
+    // Never take more than the current file has room for, so files end at file_size exactly
+    uint64_t room = file_size - file_written;
+    size_t want = room < pipe_size ? room : pipe_size;
+
+    ssize_t nin = splice(sock, NULL, pipefd[1], NULL, want, SPLICE_F_MOVE | SPLICE_F_MORE);
+    nsyscall_total++;
+    if(nin < 0){
+      if(errno == EINTR){
+	continue;
+      }
+      if(errno == EAGAIN || errno == EWOULDBLOCK){
+	struct pollfd pfd = {sock, POLLIN, 0};
+	poll(&pfd, 1, -1);
+	continue;
+      }
+      fprintf(stderr, "TCP_SPLICECAPTURE_ERROR: splice from socket failed with \"%s\", "
+	      "which happens at \"%s\", line [%d], has to abort.\n",
+	      strerror(errno), __FILE__, __LINE__);
+      return EXIT_FAILURE;
+    }
+    if(nin == 0){
+      // Peer closed the connection
+      return EXIT_SUCCESS;
+    }
+
+    if(sample_size && nbyte_total + nin > next_sample){
+      if(take_sample(nin)){
+	return EXIT_FAILURE;
+      }
+      // Keep to the schedule, a chunk covers at most one sample
+      do{
+	next_sample += sample_interval > 0 ? sample_interval : 1;
+      }while(next_sample < nbyte_total + nin);
+    }
+
+    // Drain the pipe into the file
+    size_t nleft = nin;
+    while(nleft > 0){
+      ssize_t nout = splice(pipefd[0], NULL, fd, NULL, nleft, SPLICE_F_MOVE);
+      nsyscall_total++;
+      if(nout < 0 && errno == EINTR){
+	continue;
+      }
+      if(nout <= 0){
+	fprintf(stderr, "TCP_SPLICECAPTURE_ERROR: splice to file failed with \"%s\", "
+		"which happens at \"%s\", line [%d], has to abort.\n",
+		strerror(errno), __FILE__, __LINE__);
+	return EXIT_FAILURE;
+      }
+      nleft        -= nout;
+      file_written += nout;
+      nbyte_total  += nout;
+    }
+  }
+}
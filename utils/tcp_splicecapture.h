@@ -0,0 +1,99 @@
+#ifndef _TCP_SPLICECAPTURE_H
+#define _TCP_SPLICECAPTURE_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <limits.h>
+
+#include <functional>
+
+#define TCP_SPLICE_PIPE_SIZE (1 << 20) ///< Pipe capacity we ask for, bytes moved with one `splice`
+
+/*! \brief A class to capture a TCP stream to disk with `splice`
+ *
+ * Bytes move from the socket into a pipe and from the pipe into the output file with `splice`,
+ * so the stream never passes through user space. Output rotates to a new file every \p file_size bytes,
+ * the same as FILE_SIZE in a DADA header, files are named prefix_OFFSET.raw with OFFSET the raw stream offset
+ * of their first byte, counted from the first byte the sender sends, header included, so it is not OBS_OFFSET.
+ * Files are raw segments of the stream, not DADA files, only the first one starts with what the sender
+ * sends first, for example its header, so a DADA reader needs that header put in front of every later segment.
+ *
+ * For monitoring, every \p sample_interval bytes the first \p sample_size bytes in the pipe are
+ * duplicated with `tee` into a second pipe and read into a small user buffer, the data in the first pipe
+ * is not consumed, so the file still gets every byte.
+ *
+ * The socket can come from `create_tcp_socket` in TCP_RECV direction, blocking or nonblocking.
+ *
+ */
+class TcpSpliceCapture{
+public:
+  /// Handler of a sample, \p offset is the stream offset of the first byte
+  typedef std::function<void(uint64_t offset, const char *data, size_t nbytes)> sample_callback;
+
+  uint64_t nbyte_total    = 0; ///< Number of bytes written to files
+  uint64_t nfile          = 0; ///< Number of files opened
+  uint64_t nsample_total  = 0; ///< Number of samples taken
+  uint64_t nsyscall_total = 0; ///< Number of `splice` and `tee` calls
+
+  //! Constructor of TcpSpliceCapture class.
+  /*!
+   *
+   * - create the pipes and allocate the sample buffer, files are opened when data arrives
+   *
+   * \param[in] sock            Socket to capture, the class does not close it
+   * \param[in] prefix          Output file prefix, it can have directories
+   * \param[in] file_size       Bytes per output file, FILE_SIZE in DADA header
+   * \param[in] sample_size     Bytes per sample, 0 disables sampling
+   * \param[in] sample_interval Stream bytes between two samples
+   * \param[in] on_sample       Handler of samples, called on the capture thread
+   *
+   */
+  TcpSpliceCapture(int sock, const char *prefix, uint64_t file_size,
+		   size_t sample_size = 0, uint64_t sample_interval = 0,
+		   sample_callback on_sample = nullptr);
+
+  //! Deconstructor of TcpSpliceCapture class.
+  /*!
+   *
+   * - close the current file and pipes, free sample buffer
+   */
+  ~TcpSpliceCapture();
+
+  /*! Capture until the peer closes the connection
+   *
+   * \returns EXIT_SUCCESS at end of stream, EXIT_FAILURE on error
+   */
+  int capture();
+
+  TcpSpliceCapture(const TcpSpliceCapture&) = delete;
+  TcpSpliceCapture& operator=(const TcpSpliceCapture&) = delete;
+
+private:
+  int sock;                  ///< Socket to capture
+  char prefix[PATH_MAX];     ///< Output file prefix
+  uint64_t file_size;        ///< Bytes per output file
+  size_t sample_size;        ///< Bytes per sample
+  uint64_t sample_interval;  ///< Bytes between samples
+  sample_callback on_sample; ///< Handler of samples
+
+  int pipefd[2] = {-1, -1};  ///< Socket to file pipe
+  int teefd[2]  = {-1, -1};  ///< Pipe for samples
+  size_t pipe_size;          ///< Capacity of pipes
+  char *sample = NULL;       ///< Sample buffer
+
+  int fd = -1;               ///< Current output file
+  uint64_t file_written = 0; ///< Bytes in the current output file
+  uint64_t next_sample = 0;  ///< Stream offset of the next sample
+
+  int rotate();              ///< Close current file and open the next one
+  int take_sample(size_t nbytes); ///< Copy up to sample_size bytes at the pipe head
+};
+
+#endif
@@ -0,0 +1,237 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "tcp_striped.h"
+
+TcpStriped::TcpStriped(int nstream, uint64_t stripe_size)
+  :nstream(nstream), stripe_size(stripe_size){
+
+  if(nstream <= 0 || stripe_size == 0){
+    fprintf(stderr, "TCP_STRIPED_ERROR: Number of streams %d and stripe size %" PRIu64 " have to be positive, "
+	    "which happens at \"%s\", line [%d], has to abort.\n",
+	    nstream, stripe_size, __FILE__, __LINE__);
+    exit(EXIT_FAILURE);
+  }
+
+  for(int i = 0; i < nstream; i++){
+    streams.emplace_back(new stream);
+    streams[i]->index = i;
+  }
+}
+
+TcpStriped::~TcpStriped(){
+  stop();
+}
+
+void TcpStriped::stripes(stream &s, uint64_t nbytes){
+  // Stripe k starts at k*stripe_size and goes over stream k % nstream
+  s.iov.resize(1);
+  for(uint64_t offset = s.index*stripe_size; offset < nbytes; offset += nstream*stripe_size){
+    uint64_t size = nbytes - offset < stripe_size ? nbytes - offset : stripe_size;
+    s.iov.push_back({block + offset, size});
+  }
+}
+
+void TcpStriped::run(stream &s, int cpu){
+  if(cpu >= 0){
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    CPU_SET(cpu, &cpuset);
+    if(pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset)){
+      fprintf(stderr, "TCP_STRIPED_ERROR: Could not pin stream to CPU %d, "
+	      "which happens at \"%s\", line [%d], has to abort.\n",
+	      cpu, __FILE__, __LINE__);
+    }
+  }
+
+  uint64_t seen = 0;
+  while(true){
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      cv_job.wait(lock, [&]{return quit || generation != seen;});
+      if(quit){
+	return;
+      }
+      seen = generation;
+    }
+
+    int status = transfer(s);
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      s.status = status;
+      if(++ndone == nstream){
+	cv_done.notify_one();
+      }
+    }
+  }
+}
+
+void TcpStriped::start(const int *cpus){
+  for(int i = 0; i < nstream; i++){
+    stream &s = *streams[i];
+    s.iov.reserve(2);
+    s.thread = std::thread(&TcpStriped::run, this, std::ref(s), cpus ? cpus[i] : -1);
+  }
+  running = true;
+}
+
+void TcpStriped::stop(){
+  if(running){
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      quit = true;
+    }
+    cv_job.notify_all();
+    for(auto &s : streams){
+      s->thread.join();
+    }
+    running = false;
+  }
+
+  for(auto &s : streams){
+    if(s->sock >= 0){
+      close(s->sock);
+      s->sock = -1;
+    }
+  }
+}
+
+int TcpStriped::dispatch(){
+  std::unique_lock<std::mutex> lock(mutex);
+  ndone = 0;
+  generation++;
+  cv_job.notify_all();
+  cv_done.wait(lock, [&]{return ndone == nstream;});
+
+  for(auto &s : streams){
+    if(s->status != EXIT_SUCCESS){
+      return EXIT_FAILURE;
+    }
+  }
+  return EXIT_SUCCESS;
+}
+
+TcpStripedSender::TcpStripedSender(char *ip, int port, int nstream, uint64_t stripe_size, int bufsz, const int *cpus)
+  :TcpStriped(nstream, stripe_size){
+
+  for(int i = 0; i < nstream; i++){
+    if(create_tcp_socket(ip, port + i, streams[i]->sock, 0, bufsz, -1, 0, TCP_SEND)){
+      fprintf(stderr, "TCP_STRIPEDSENDER_ERROR: Could not connect stream %d to %s_%d, "
+	      "which happens at \"%s\", line [%d], has to abort.\n",
+	      i, ip, port + i, __FILE__, __LINE__);
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  start(cpus);
+}
+
+TcpStripedSender::~TcpStripedSender(){
+  stop();
+}
+
+int TcpStripedSender::transfer(stream &s){
+  // Frame and all stripes of this stream go with one call
+  s.iov[0].iov_base = &s.frame;
+  s.iov[0].iov_len  = sizeof(s.frame);
+
+  return sendbufv_tcp(s.sock, s.iov.data(), s.iov.size());
+}
+
+int TcpStripedSender::send(const char *buf, uint64_t nbytes){
+  block = (char *)buf;
+  this->nbytes = nbytes;
+  for(int i = 0; i < nstream; i++){
+    streams[i]->frame = {nblock_total, nbytes};
+    stripes(*streams[i], nbytes);
+  }
+
+  if(dispatch()){
+    return EXIT_FAILURE;
+  }
+
+  nblock_total++;
+  nbyte_total += nbytes;
+  return EXIT_SUCCESS;
+}
+
+TcpStripedReceiver::TcpStripedReceiver(char *ip, int port, int nstream, uint64_t stripe_size, int bufsz, const int *cpus)
+  :TcpStriped(nstream, stripe_size){
+
+  // Accept blocks, so every stream listens at the same time and the sender can connect in any order
+  std::vector<std::thread> accepters;
+  std::vector<int> status(nstream, EXIT_SUCCESS);
+  for(int i = 0; i < nstream; i++){
+    accepters.emplace_back([&, i]{
+	status[i] = create_tcp_socket(ip, port + i, streams[i]->sock, 1, bufsz, -1, 0, TCP_RECV);
+      });
+  }
+  for(auto &t : accepters){
+    t.join();
+  }
+
+  for(int i = 0; i < nstream; i++){
+    if(status[i]){
+      fprintf(stderr, "TCP_STRIPEDRECEIVER_ERROR: Could not accept stream %d on %s_%d, "
+	      "which happens at \"%s\", line [%d], has to abort.\n",
+	      i, ip, port + i, __FILE__, __LINE__);
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  start(cpus);
+}
+
+TcpStripedReceiver::~TcpStripedReceiver(){
+  stop();
+}
+
+int TcpStripedReceiver::transfer(stream &s){
+  if(recvbuf_tcp(s.sock, (char *)&s.frame, sizeof(s.frame))){
+    return EXIT_FAILURE;
+  }
+  if(s.frame.sequence != nblock_total || s.frame.nbytes > nbytes){
+    fprintf(stderr, "TCP_STRIPEDRECEIVER_ERROR: Expect block %" PRIu64 " of at most %" PRIu64 " bytes, "
+	    "but got block %" PRIu64 " of %" PRIu64 " bytes, "
+	    "which happens at \"%s\", line [%d], has to abort.\n",
+	    nblock_total, nbytes, s.frame.sequence, s.frame.nbytes, __FILE__, __LINE__);
+    return EXIT_FAILURE;
+  }
+
+  // Each stripe lands at its offset in the block
+  stripes(s, s.frame.nbytes);
+  for(size_t k = 1; k < s.iov.size(); k++){
+    if(recvbuf_tcp(s.sock, (char *)s.iov[k].iov_base, s.iov[k].iov_len)){
+      return EXIT_FAILURE;
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
+
+int TcpStripedReceiver::receive(char *buf, uint64_t capacity, uint64_t &nbytes){
+  block = buf;
+  this->nbytes = capacity;
+
+  if(dispatch()){
+    return EXIT_FAILURE;
+  }
+
+  // Every stream has the block size in its frame, they have to agree
+  nbytes = streams[0]->frame.nbytes;
+  for(auto &s : streams){
+    if(s->frame.nbytes != nbytes){
+      fprintf(stderr, "TCP_STRIPEDRECEIVER_ERROR: Stream %d has block size %" PRIu64 ", "
+	      "but stream 0 has %" PRIu64 ", "
+	      "which happens at \"%s\", line [%d], has to abort.\n",
+	      s->index, s->frame.nbytes, nbytes, __FILE__, __LINE__);
+      return EXIT_FAILURE;
+    }
+  }
+
+  nblock_total++;
+  nbyte_total += nbytes;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,167 @@
+#ifndef _TCP_STRIPED_H
+#define _TCP_STRIPED_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include <sys/uio.h>
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "tcp_utils.h"
+
+/// Frame in front of the stripes of one block on every stream
+typedef struct tcp_stripe_frame_t{
+  uint64_t sequence; ///< Block number
+  uint64_t nbytes;   ///< Number of bytes of the whole block
+}tcp_stripe_frame_t;
+
+/*! \brief Stream threads shared by TcpStripedSender and TcpStripedReceiver
+ *
+ * A block is cut into stripes of \p stripe_size bytes, stripe k goes over stream k % nstream,
+ * so each stream knows the offset of its stripes from the block size alone and no stripe needs a header.
+ * Every stream has its own socket and thread, all threads move their stripes of a block in parallel
+ * and the caller waits until the last one is done.
+ *
+ */
+class TcpStriped{
+public:
+  uint64_t nblock_total = 0; ///< Number of blocks moved since the class is created
+  uint64_t nbyte_total  = 0; ///< Number of block bytes moved since the class is created
+
+  int nstream;          ///< Number of parallel streams
+  uint64_t stripe_size; ///< Stripe size in bytes
+
+  TcpStriped(const TcpStriped&) = delete;
+  TcpStriped& operator=(const TcpStriped&) = delete;
+
+protected:
+  struct stream{
+    int index = 0;                 ///< Stream number, stream i carries stripes i, i + nstream ...
+    int sock = -1;
+    std::thread thread;
+    int status = EXIT_SUCCESS;     ///< Status of the last block
+    tcp_stripe_frame_t frame;      ///< Frame of the last block
+    std::vector<struct iovec> iov; ///< Stripes of the last block
+  };
+
+  std::vector<std::unique_ptr<stream>> streams;
+
+  char *block = NULL;     ///< Block of the current job
+  uint64_t nbytes = 0;    ///< Block size of the current job, capacity for receiver
+
+  TcpStriped(int nstream, uint64_t stripe_size);
+  virtual ~TcpStriped();
+
+  void start(const int *cpus); ///< Start stream threads, sockets have to be ready
+  void stop();                 ///< Stop stream threads and close sockets
+  int dispatch();              ///< Let every stream move its stripes of block, returns EXIT_FAILURE if any stream fails
+
+  void stripes(stream &s, uint64_t nbytes); ///< Fill iov of a stream with its stripes of a block of nbytes
+  virtual int transfer(stream &s) = 0;      ///< Move stripes of one block on one stream
+
+private:
+  std::mutex mutex;
+  std::condition_variable cv_job;
+  std::condition_variable cv_done;
+  uint64_t generation = 0; ///< Job counter, a new value wakes stream threads
+  int ndone = 0;           ///< Number of streams done with the current job
+  bool quit = false;
+  bool running = false;
+
+  void run(stream &s, int cpu); ///< Stream thread loop
+};
+
+/*! \brief A class to send blocks over several parallel TCP connections
+ *
+ * A single stream does not fill a 25 or 100 GbE link from one core,
+ * the class cuts each block into stripes and sends them over \p nstream connections,
+ * each connection created with `create_tcp_socket` to port + i and served by its own thread.
+ * Each stream sends a tcp_stripe_frame_t and all its stripes of the block with one `sendbufv_tcp`.
+ *
+ */
+class TcpStripedSender : public TcpStriped{
+public:
+  //! Constructor of TcpStripedSender class.
+  /*!
+   *
+   * - connect \p nstream sockets to port, port + 1 ... port + nstream - 1
+   * - start one thread for each socket
+   *
+   * \param[in] ip          IP address of receiver
+   * \param[in] port        Port of the first stream
+   * \param[in] nstream     Number of streams
+   * \param[in] stripe_size Stripe size in bytes, has to match the receiver
+   * \param[in] bufsz       Socket buffer size in MBytes, 0 keeps the default
+   * \param[in] cpus        CPU for each stream thread, NULL leaves threads unpinned
+   *
+   */
+  TcpStripedSender(char *ip, int port, int nstream, uint64_t stripe_size, int bufsz = 0, const int *cpus = NULL);
+
+  //! Deconstructor of TcpStripedSender class, stop threads and close sockets, which ends the receiver
+  ~TcpStripedSender();
+
+  /*! Send a block, it returns when every stripe is handed to the kernel
+   *
+   * \param[in] buf    Block to send
+   * \param[in] nbytes Block size in bytes, any size up to the receiver capacity
+   *
+   * \returns EXIT_SUCCESS or EXIT_FAILURE
+   */
+  int send(const char *buf, uint64_t nbytes);
+
+private:
+  int transfer(stream &s) override;
+};
+
+/*! \brief A class to receive blocks sent by TcpStripedSender
+ *
+ * Each stream thread receives its stripes with `recvbuf_tcp` straight to their offsets in the destination buffer,
+ * so the block is reassembled in order without copy.
+ *
+ */
+class TcpStripedReceiver : public TcpStriped{
+public:
+  //! Constructor of TcpStripedReceiver class.
+  /*!
+   *
+   * - accept \p nstream connections on port, port + 1 ... port + nstream - 1 in parallel
+   * - start one thread for each socket
+   *
+   * \param[in] ip          IP address to listen on, 0.0.0.0 is INADDR_ANY
+   * \param[in] port        Port of the first stream
+   * \param[in] nstream     Number of streams
+   * \param[in] stripe_size Stripe size in bytes, has to match the sender
+   * \param[in] bufsz       Socket buffer size in MBytes, 0 keeps the default
+   * \param[in] cpus        CPU for each stream thread, NULL leaves threads unpinned
+   *
+   */
+  TcpStripedReceiver(char *ip, int port, int nstream, uint64_t stripe_size, int bufsz = 0, const int *cpus = NULL);
+
+  //! Deconstructor of TcpStripedReceiver class, stop threads and close sockets
+  ~TcpStripedReceiver();
+
+  /*! Receive a block
+   *
+   * \param[in]  buf      Buffer to receive the block into
+   * \param[in]  capacity Size of buf in bytes
+   * \param[out] nbytes   Block size in bytes
+   *
+   * \returns EXIT_SUCCESS or EXIT_FAILURE, also when the sender closes the streams
+   */
+  int receive(char *buf, uint64_t capacity, uint64_t &nbytes);
+
+private:
+  int transfer(stream &s) override;
+};
+
+#endif
@@ -151,6 +151,71 @@ int create_tcp_socket(char *ip, int port, int &sock,
   return EXIT_SUCCESS;
 }
 
+int create_tcp_listener(char *ip, int port, int &sock,
+			int reuse, int bufsz, int depth){
+
+  sock = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_TCP);
+  if (sock < 0){
+    fprintf(stderr, "CREATE_TCP_LISTENER_ERROR: Could not create socket for %s_%d, "
+	    "which happens at \"%s\", line [%d], has to abort.\n",
+	    ip, port, __FILE__, __LINE__);
+    return EXIT_FAILURE;
+  }
+
+  // Setup reuse if it is required
+  if(reuse){
+    if (setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse))){
+      fprintf(stderr, "CREATE_TCP_LISTENER_ERROR: Could not enable SO_REUSEADDR to %s_%d, "
+	      "which happens at \"%s\", line [%d], has to abort.\n",
+	      ip, port, __FILE__, __LINE__);
+      
+      close(sock);
+      return EXIT_FAILURE;
+    }    
+  }
+
+  // Accepted sockets inherit buffer size from listening socket
+  if(bufsz > 0){
+    int nbyte_buffer = bufsz*1E6;
+    if (setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &nbyte_buffer, sizeof(nbyte_buffer))) {
+      fprintf(stderr, "CREATE_TCP_LISTENER_ERROR: Could not set socket BUF to %s_%d, "
+	      "which happens at \"%s\", line [%d], has to abort.\n",
+	      ip, port, __FILE__, __LINE__);
+      
+      close(sock);
+      return EXIT_FAILURE;
+    }
+  }
+
+  struct sockaddr_in sa = {0};
+  sa.sin_port   = htons(port);
+  sa.sin_family = AF_INET;
+  sa.sin_addr.s_addr = inet_addr(ip);
+  
+  if (bind(sock, (struct sockaddr *) &sa, sizeof(sa)) < 0) {        
+    fprintf(stderr, "CREATE_TCP_LISTENER_ERROR: Could not bind to %s_%d, "
+	    "which happens at \"%s\", line [%d], has to abort.\n",
+	    ip, port, __FILE__, __LINE__);
+    
+    close(sock);
+    return EXIT_FAILURE;
+  }
+  
+  if(depth <= 0){
+    depth = TCP_DEFAULT_BACKLOG;
+  }
+  if (listen(sock, depth) < 0){        
+    fprintf(stderr, "CREATE_TCP_LISTENER_ERROR: Could not listen to %s_%d, "
+	    "which happens at \"%s\", line [%d], has to abort.\n",
+	    ip, port, __FILE__, __LINE__);
+    
+    close(sock);
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
+
 int sendbuf_tcp(int sock, char *buf, int nbytes) {
   int nwrote;
   int ntowrite = nbytes;
@@ -180,3 +245,187 @@ int sendbuf_tcp(int sock, char *buf, int nbytes) {
   
   return EXIT_SUCCESS;
 }
+
+int sendbufv_tcp(int sock, const struct iovec *iov, int niov, uint64_t *nsent) {
+  int iseg = 0;       // First segment which is not fully sent
+  size_t offset = 0;  // Bytes of iov[iseg] already sent
+  uint64_t nwrote_total = 0;
+
+  struct iovec window[TCP_IOV_MAX];
+  struct msghdr msg = {0};
+
+  // A blocking socket reports its SO_SNDTIMEO as EAGAIN, only a nonblocking one is polled
+  int nonblock = fcntl(sock, F_GETFL, 0) & O_NONBLOCK;
+  
+  while (iseg < niov) {
+    // Skip empty segments
+    if (iov[iseg].iov_len == offset) {
+      iseg++;
+      offset = 0;
+      continue;
+    }
+
+    // Window of remaining segments, the first one starts from where the last write stopped
+    int nwindow = 0;
+    for (int i = iseg; i < niov && nwindow < TCP_IOV_MAX; i++) {
+      size_t skip = (i == iseg) ? offset : 0;
+      window[nwindow].iov_base = (char *)iov[i].iov_base + skip;
+      window[nwindow].iov_len  = iov[i].iov_len - skip;
+      nwindow++;
+    }
+    msg.msg_iov    = window;
+    msg.msg_iovlen = nwindow;
+
+    ssize_t nwrote = sendmsg(sock, &msg, 0);
+    if (nwrote==-1) {
+      if (errno == EINTR)
+	continue;
+      if ((errno == EAGAIN || errno == EWOULDBLOCK) && nonblock) {
+	// Nonblocking socket is full, wait until it drains
+	struct pollfd pfd = {sock, POLLOUT, 0};
+	poll(&pfd, 1, -1);
+	continue;
+      }
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+	fprintf(stderr, "SENDBUFV_TCP_ERROR: Timeout after %" PRIu64 " bytes, "
+		"which happens at \"%s\", line [%d], has to abort.\n",
+		nwrote_total, __FILE__, __LINE__);
+      } else {
+	fprintf(stderr, "SENDBUFV_TCP_ERROR: Error writing to network with \"%s\", "
+		"which happens at \"%s\", line [%d], has to abort.\n",
+		strerror(errno), __FILE__, __LINE__);
+      }
+      if (nsent != NULL)
+	*nsent = nwrote_total;
+      return EXIT_FAILURE;
+    } else if (nwrote==0) {
+      fprintf(stderr, "SENDBUFV_TCP_WARN: Did not write any bytes (0 bytes) "
+	      "which happens at \"%s\", line [%d], has to abort.\n",
+	      __FILE__, __LINE__);
+      if (nsent != NULL)
+	*nsent = nwrote_total;
+      return EXIT_FAILURE;
+    }
+    nwrote_total += nwrote;
+
+    // Move to the segment where this write stops
+    size_t nleft = nwrote;
+    while (nleft > 0) {
+      size_t remain = iov[iseg].iov_len - offset;
+      if (nleft >= remain) {
+	nleft -= remain;
+	iseg++;
+	offset = 0;
+      } else {
+	offset += nleft;
+	nleft = 0;
+      }
+    }
+  }
+
+  if (nsent != NULL)
+    *nsent = nwrote_total;
+  return EXIT_SUCCESS;
+}
+
+int recvbuf_tcp(int sock, char *buf, uint64_t nbytes, uint64_t *nreceived) {
+  uint64_t nread_total = 0;
+  int ret = EXIT_SUCCESS;
+  
+  // MSG_WAITALL does nothing on a nonblocking socket, we poll instead
+  int nonblock = fcntl(sock, F_GETFL, 0) & O_NONBLOCK;
+  
+  while (nread_total < nbytes) {
+    ssize_t nread = recv(sock, buf + nread_total, nbytes - nread_total, MSG_WAITALL);
+    if (nread==-1) {
+      if (errno == EINTR)
+	continue;
+      if ((errno == EAGAIN || errno == EWOULDBLOCK) && nonblock) {
+	struct pollfd pfd = {sock, POLLIN, 0};
+	poll(&pfd, 1, -1);
+	continue;
+      }
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+	fprintf(stderr, "RECVBUF_TCP_ERROR: Timeout after %" PRIu64 " of %" PRIu64 " bytes, "
+		"which happens at \"%s\", line [%d], has to abort.\n",
+		nread_total, nbytes, __FILE__, __LINE__);
+      } else {
+	fprintf(stderr, "RECVBUF_TCP_ERROR: Error reading from network with \"%s\", "
+		"which happens at \"%s\", line [%d], has to abort.\n",
+		strerror(errno), __FILE__, __LINE__);
+      }
+      ret = EXIT_FAILURE;
+      break;
+    } else if (nread==0) {
+      fprintf(stderr, "RECVBUF_TCP_WARN: Connection closed after %" PRIu64 " of %" PRIu64 " bytes, "
+	      "which happens at \"%s\", line [%d], has to abort.\n",
+	      nread_total, nbytes, __FILE__, __LINE__);
+      ret = EXIT_FAILURE;
+      break;
+    }
+    nread_total += nread;
+  }
+
+  if (nreceived != NULL)
+    *nreceived = nread_total;
+  return ret;
+}
+
+void tcp_default_options(tcp_options_t *options) {
+  options->nodelay       = TCP_OPTION_DEFAULT;
+  options->cork          = TCP_OPTION_DEFAULT;
+  options->notsent_lowat = TCP_OPTION_DEFAULT;
+  options->quickack      = TCP_OPTION_DEFAULT;
+  options->sndbuf        = TCP_OPTION_DEFAULT;
+  options->rcvbuf        = TCP_OPTION_DEFAULT;
+  options->force         = 0;
+  options->congestion[0] = '\0';
+
+  options->sndbuf_granted = TCP_OPTION_DEFAULT;
+  options->rcvbuf_granted = TCP_OPTION_DEFAULT;
+}
+
+int apply_tcp_options(int sock, tcp_options_t *options) {
+  struct {
+    int level;
+    int name;
+    int value;
+    const char *label;
+  } items[] = {
+    {IPPROTO_TCP, TCP_NODELAY,       options->nodelay,       "TCP_NODELAY"},
+    {IPPROTO_TCP, TCP_CORK,          options->cork,          "TCP_CORK"},
+    {IPPROTO_TCP, TCP_NOTSENT_LOWAT, options->notsent_lowat, "TCP_NOTSENT_LOWAT"},
+    {IPPROTO_TCP, TCP_QUICKACK,      options->quickack,      "TCP_QUICKACK"},
+    {SOL_SOCKET,  options->force ? SO_SNDBUFFORCE : SO_SNDBUF, options->sndbuf, "SO_SNDBUF"},
+    {SOL_SOCKET,  options->force ? SO_RCVBUFFORCE : SO_RCVBUF, options->rcvbuf, "SO_RCVBUF"},
+  };
+
+  for (size_t i = 0; i < sizeof(items)/sizeof(items[0]); i++) {
+    if (items[i].value == TCP_OPTION_DEFAULT)
+      continue;
+    
+    if (setsockopt(sock, items[i].level, items[i].name, &items[i].value, sizeof(items[i].value))) {
+      fprintf(stderr, "APPLY_TCP_OPTIONS_ERROR: Could not set %s to %d with \"%s\", "
+	      "which happens at \"%s\", line [%d], has to abort.\n",
+	      items[i].label, items[i].value, strerror(errno), __FILE__, __LINE__);
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (options->congestion[0] != '\0') {
+    if (setsockopt(sock, IPPROTO_TCP, TCP_CONGESTION, options->congestion, strlen(options->congestion))) {
+      fprintf(stderr, "APPLY_TCP_OPTIONS_ERROR: Could not set TCP_CONGESTION to %s with \"%s\", "
+	      "which happens at \"%s\", line [%d], has to abort.\n",
+	      options->congestion, strerror(errno), __FILE__, __LINE__);
+      return EXIT_FAILURE;
+    }
+  }
+
+  // Read back what the kernel gave us
+  socklen_t len = sizeof(int);
+  getsockopt(sock, SOL_SOCKET, SO_SNDBUF, &options->sndbuf_granted, &len);
+  len = sizeof(int);
+  getsockopt(sock, SOL_SOCKET, SO_RCVBUF, &options->rcvbuf_granted, &len);
+  
+  return EXIT_SUCCESS;
+}
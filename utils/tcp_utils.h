@@ -4,6 +4,8 @@
 #include <stdlib.h>
 #include <assert.h>
 #include <limits.h>
+#include <stdint.h>
+#include <inttypes.h>
 
 #include <time.h>
 #include <errno.h>
@@ -14,13 +16,47 @@
 #include <string.h>
 
 #include <sys/socket.h>
+#include <sys/uio.h>
+#include <poll.h>
 #include <netinet/ip.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <arpa/inet.h>
 #include <fcntl.h>
 
 enum tcp_direction {TCP_SEND = 0, TCP_RECV = 1};
 #define TCP_DEFAULT_BACKLOG 4096
+#define TCP_IOV_MAX 64 ///< Maximum number of segments given to one `sendmsg` call
+
+#define TCP_OPTION_DEFAULT -1 ///< Leave the option as the kernel sets it
+
+/*! Typed socket options for a tcp socket, fields with TCP_OPTION_DEFAULT or empty congestion are not touched
+ */
+typedef struct tcp_options_t{
+  int nodelay;        ///< TCP_NODELAY, 1 sends small segments right away
+  int cork;           ///< TCP_CORK, 1 holds partial segments until uncorked
+  int notsent_lowat;  ///< TCP_NOTSENT_LOWAT in bytes, caps unsent bytes in the socket so writers wake up later
+  int quickack;       ///< TCP_QUICKACK, 1 acks right away, kernel may reset it after a while
+  int sndbuf;         ///< SO_SNDBUF in bytes
+  int rcvbuf;         ///< SO_RCVBUF in bytes
+  int force;          ///< Nonzero uses SO_SNDBUFFORCE and SO_RCVBUFFORCE to go over the limits, needs CAP_NET_ADMIN
+  char congestion[16];///< TCP_CONGESTION name, for example cubic, reno or bbr
+
+  int sndbuf_granted; ///< SO_SNDBUF the kernel granted, filled by apply_tcp_options
+  int rcvbuf_granted; ///< SO_RCVBUF the kernel granted, filled by apply_tcp_options
+}tcp_options_t;
+
+/*! A function to set all fields of \p options to TCP_OPTION_DEFAULT
+ */
+void tcp_default_options(tcp_options_t *options);
+
+/*! A function to apply socket options to a tcp socket, for example one created by `create_tcp_socket`,
+  it reads back buffer sizes the kernel granted, which are usually twice the request and capped by net.core.[rw]mem_max
+  
+ * @param[in]     sock    socket to apply options to
+ * @param[in,out] options options to apply, granted buffer sizes are filled
+ */
+int apply_tcp_options(int sock, tcp_options_t *options);
 
 /*! A function to create tcp socket for different mode (unicast, broadcast and multicast) and two directions (send and receive)
   
@@ -38,10 +74,50 @@ int create_tcp_socket(char *ip, int port, int &sock,
 		      int reuse, int bufsz, double tout, int depth,
 		      enum tcp_direction direction);
 
+/*! A function to create a nonblocking listening tcp socket, it returns without accept so that the caller can serve many connections
+  
+ * @param[in] ip        IP address, 0.0.0.0 is INADDR_ANY
+ * @param[in] port      port number 
+ * @param[in] reuse     reuse the interface if it is nonzero
+ * @param[in] bufsz     socket buffer size in MBytes for accepted sockets, 0 or negative value means the default value will be used 
+ * @param[in] depth     Depth of listen option, 0 or negative number apply default value 4096
+
+ * @param[out] sock     to return listening socket
+ */
+int create_tcp_listener(char *ip, int port, int &sock,
+			int reuse, int bufsz, int depth);
+
 /*! A function to send buffer with TCP protocol 
   @param[in] sock   socket to send data to
   @param[in] buf    buffer to be sent 
   @param[in] nbytes length of the buffer in bytes    
  */
 int sendbuf_tcp(int sock, char *buf, int nbytes);
+
+/*! A function to send a list of buffers with TCP protocol, for example a DADA header and a data block, without copy them together
+  It keeps calling `sendmsg` until every segment is written, partial writes continue from where they stop,
+  EINTR is retried and EAGAIN of a nonblocking socket waits until the socket is writable,
+  a socket with timeout from `create_tcp_socket` fails when the peer does not drain it in time.
+  Segment sizes are 64 bits, so a multi-GB block goes with one call.
+
+  @param[in] sock   socket to send data to
+  @param[in] iov    segments to be sent in order, the array is not changed
+  @param[in] niov   number of segments
+  @param[out] nsent number of bytes sent, also on failure, can be NULL
+ */
+int sendbufv_tcp(int sock, const struct iovec *iov, int niov, uint64_t *nsent = NULL);
+
+/*! A function to receive exact number of bytes with TCP protocol, the counterpart of sendbuf_tcp and sendbufv_tcp
+  It asks for all remaining bytes with one `recv` and MSG_WAITALL, so a blocking socket wakes up once the request is filled.
+  Timeout follows `create_tcp_socket`, a socket with timeout fails when no data arrives in time,
+  a nonblocking socket waits until it is readable.
+
+  @param[in] sock       socket to receive data from
+  @param[in] buf        buffer to receive data into
+  @param[in] nbytes     number of bytes to receive
+  @param[out] nreceived number of bytes received, also on failure, can be NULL
+
+  @returns EXIT_SUCCESS when all bytes are received, EXIT_FAILURE on error, timeout or when peer closes the connection
+ */
+int recvbuf_tcp(int sock, char *buf, uint64_t nbytes, uint64_t *nreceived = NULL);
 #endif
@@ -0,0 +1,111 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "udp_batchreceiver.h"
+
+UdpBatchReceiver::UdpBatchReceiver(int sock, int pktsz, int nbatch, int control)
+  :sock(sock), pktsz(pktsz), nbatch(nbatch), control(control){
+
+  // Round packet slot up to cache line, 8200 bytes packet takes 8256 bytes slot
+  stride = ((size_t)pktsz + UDP_CACHELINE_SIZE - 1)/UDP_CACHELINE_SIZE*UDP_CACHELINE_SIZE;
+
+  if(posix_memalign((void **)&data, UDP_CACHELINE_SIZE, stride*nbatch)){
+    fprintf(stderr, "UDP_BATCHRECEIVER_ERROR: Could not allocate %zu bytes packet arena, "
+	    "which happens at \"%s\", line [%d], has to abort.\n",
+	    stride*nbatch, __FILE__, __LINE__);
+    exit(EXIT_FAILURE);
+  }
+  memset(data, 0, stride*nbatch);
+
+  msgs = (struct mmsghdr *)calloc(nbatch, sizeof(struct mmsghdr));
+  iovs = (struct iovec *)calloc(nbatch, sizeof(struct iovec));
+  stamps = (struct timespec *)calloc(nbatch, sizeof(struct timespec));
+  if(control){
+    controls = (char *)calloc(nbatch, UDP_CONTROL_SIZE);
+  }
+  if(msgs == NULL || iovs == NULL || stamps == NULL || (control && controls == NULL)){
+    fprintf(stderr, "UDP_BATCHRECEIVER_ERROR: Could not allocate message headers, "
+	    "which happens at \"%s\", line [%d], has to abort.\n",
+	    __FILE__, __LINE__);
+    exit(EXIT_FAILURE);
+  }
+
+  // Each iovec only covers pktsz bytes, so that larger packets come back with MSG_TRUNC
+  for(int i = 0; i < nbatch; i++){
+    iovs[i].iov_base = data + i*stride;
+    iovs[i].iov_len  = pktsz;
+    msgs[i].msg_hdr.msg_iov    = &iovs[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+  }
+}
+
+void UdpBatchReceiver::parse_control(int i){
+  struct msghdr *hdr = &msgs[i].msg_hdr;
+
+  for(struct cmsghdr *cmsg = CMSG_FIRSTHDR(hdr); cmsg != NULL; cmsg = CMSG_NXTHDR(hdr, cmsg)){
+    if(cmsg->cmsg_level != SOL_SOCKET){
+      continue;
+    }
+    if(cmsg->cmsg_type == SCM_TIMESTAMPNS){
+      memcpy(&stamps[i], CMSG_DATA(cmsg), sizeof(struct timespec));
+    }
+    else if(cmsg->cmsg_type == SO_RXQ_OVFL){
+      memcpy(&ndrop_kernel, CMSG_DATA(cmsg), sizeof(uint32_t));
+    }
+  }
+}
+
+UdpBatchReceiver::~UdpBatchReceiver(){
+  free(msgs);
+  free(iovs);
+  free(controls);
+  free(stamps);
+  free(data);
+}
+
+int UdpBatchReceiver::receive(int flags){
+
+  npacket    = 0;
+  ntruncated = 0;
+  nshort     = 0;
+
+  // Kernel overwrites msg_controllen, so we have to set it for every batch
+  if(control){
+    for(int i = 0; i < nbatch; i++){
+      msgs[i].msg_hdr.msg_control    = controls + (size_t)i*UDP_CONTROL_SIZE;
+      msgs[i].msg_hdr.msg_controllen = UDP_CONTROL_SIZE;
+    }
+  }
+
+  int nrecv;
+  do{
+    nrecv = recvmmsg(sock, msgs, nbatch, flags, NULL);
+    nsyscall_total++;
+  }while(nrecv < 0 && errno == EINTR);
+
+  if(nrecv < 0){
+    // EAGAIN and EWOULDBLOCK are expected for nonblock and timeout sockets, leave it to caller
+    return -1;
+  }
+
+  for(int i = 0; i < nrecv; i++){
+    if(msgs[i].msg_hdr.msg_flags & MSG_TRUNC){
+      ntruncated++;
+    }
+    else if((int)msgs[i].msg_len < pktsz){
+      nshort++;
+    }
+
+    if(control){
+      parse_control(i);
+    }
+  }
+
+  npacket = nrecv;
+  npacket_total    += nrecv;
+  ntruncated_total += ntruncated;
+  nshort_total     += nshort;
+
+  return nrecv;
+}
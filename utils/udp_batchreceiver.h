@@ -0,0 +1,105 @@
+#ifndef _UDP_BATCHRECEIVER_H
+#define _UDP_BATCHRECEIVER_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#include <time.h>
+#include <sys/socket.h>
+
+#include "udp_utils.h"
+
+#define UDP_CACHELINE_SIZE 64 ///< Packet slots in the arena start on a cache line boundary
+
+/// Control message space of one packet, kernel timestamp and drop counter
+#define UDP_CONTROL_SIZE (CMSG_SPACE(sizeof(struct timespec)) + CMSG_SPACE(sizeof(uint32_t)))
+
+/*! \brief A class to receive a batch of UDP packets with one `recvmmsg` call
+ *
+ * The class wraps a socket created by `create_udp_socket` in UDP_RECV direction,
+ * it preallocates a packet arena for \p nbatch packets, each packet slot is \p pktsz bytes
+ * and starts on a cache line boundary, and pulls up to \p nbatch datagrams per system call.
+ *
+ * Packets larger than \p pktsz are counted as truncated, packets smaller than \p pktsz are counted as short,
+ * both counters are per batch, accumulated counters are also available.
+ *
+ * With \p control, the class also pulls the kernel receive timestamp and the socket drop counter out of control messages,
+ * the socket has to be created with UDP_OPTION_TIMESTAMP.
+ *
+ */
+class UdpBatchReceiver{
+public:
+  char *data = NULL;       ///< Packet arena, packet i starts at data + i*stride
+  int npacket = 0;         ///< Number of packets received with the last call of receive
+  int ntruncated = 0;      ///< Number of truncated packets in the last batch
+  int nshort = 0;          ///< Number of short packets in the last batch
+
+  uint64_t npacket_total    = 0; ///< Number of packets received since the class is created
+  uint64_t ntruncated_total = 0; ///< Number of truncated packets since the class is created
+  uint64_t nshort_total     = 0; ///< Number of short packets since the class is created
+  uint64_t nsyscall_total   = 0; ///< Number of `recvmmsg` calls since the class is created
+  uint32_t ndrop_kernel     = 0; ///< Number of packets dropped by the kernel on the socket, from SO_RXQ_OVFL, only with control
+
+  //! Constructor of UdpBatchReceiver class.
+  /*!
+   *
+   * - allocate cache aligned packet arena for \p nbatch packets
+   * - setup `mmsghdr` and `iovec` for all packet slots once, so that we do not need to do it for each batch
+   *
+   * \param[in] sock   Socket created by `create_udp_socket` in UDP_RECV direction, the class does not close it
+   * \param[in] pktsz  Expected packet size in bytes, PKT_SIZE in DADA header
+   * \param[in] nbatch Maximum number of packets to receive with one system call
+   * \param[in] control Nonzero to receive kernel timestamp and drop counter
+   *
+   */
+  UdpBatchReceiver(int sock, int pktsz, int nbatch, int control = 0);
+
+  //! Deconstructor of UdpBatchReceiver class.
+  /*!
+   *
+   * - free packet arena and message headers at the class life end
+   */
+  ~UdpBatchReceiver();
+
+  /*! Receive a batch of packets
+   *
+   * With the default MSG_WAITFORONE flag, the call follows the block/timeout/nonblock setup of the socket for the first packet
+   * and then returns with the packets which are already queued in the kernel.
+   *
+   * \param[in] flags Flags for `recvmmsg`
+   *
+   * \returns Number of packets received, -1 on error or timeout (check errno)
+   */
+  int receive(int flags = MSG_WAITFORONE);
+
+  //! Pointer to packet \p i of the last batch
+  char *packet(int i) const {return data + (size_t)i*stride;}
+
+  //! Number of bytes received for packet \p i of the last batch
+  int packet_size(int i) const {return msgs[i].msg_len;}
+
+  //! Kernel receive timestamp (CLOCK_REALTIME) of packet \p i of the last batch, zero without control
+  const struct timespec &timestamp(int i) const {return stamps[i];}
+
+  UdpBatchReceiver(const UdpBatchReceiver&) = delete;
+  UdpBatchReceiver& operator=(const UdpBatchReceiver&) = delete;
+
+private:
+  int sock;    ///< Socket to receive packets from
+  int pktsz;   ///< Expected packet size in bytes
+  int nbatch;  ///< Maximum number of packets per batch
+  size_t stride; ///< Packet slot size in bytes, pktsz rounded up to cache line size
+  int control;   ///< Do we receive control messages?
+
+  struct mmsghdr *msgs = NULL; ///< Message headers, one for each packet slot
+  struct iovec   *iovs = NULL; ///< IO vectors, one for each packet slot
+  char *controls = NULL;        ///< Control message buffers, one for each packet slot
+  struct timespec *stamps = NULL; ///< Kernel receive timestamps, one for each packet slot
+
+  void parse_control(int i); ///< Get timestamp and drop counter of packet \p i from its control messages
+};
+
+#endif
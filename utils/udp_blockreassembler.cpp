@@ -0,0 +1,322 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "udp_blockreassembler.h"
+
+#define UDP_CLAIM_OK     0
+#define UDP_CLAIM_DROP   1
+#define UDP_CLAIM_BEYOND 2
+
+uint64_t udp_counter_le(const char *hdr, int hdr_size){
+  uint64_t counter = 0;
+  int nbyte = hdr_size < (int)sizeof(counter) ? hdr_size : (int)sizeof(counter);
+
+  for(int i = nbyte - 1; i >= 0; i--){
+    counter = (counter << 8) | (uint8_t)hdr[i];
+  }
+  return counter;
+}
+
+UdpBlockReassembler::UdpBlockReassembler(int sock, int hdr_size, int dat_size, int npkt, int nbatch, int nwindow,
+					 block_opener opener, block_closer closer, counter_decoder decode)
+  :sock(sock), hdr_size(hdr_size), dat_size(dat_size), npkt(npkt), nbatch(nbatch), nwindow(nwindow),
+   opener(opener), closer(closer), decode(decode), window(nwindow),
+   counters(nbatch), srcs(nbatch), states(nbatch), predicted(nbatch), reordered(nbatch){
+
+  hdrs = (char *)malloc((size_t)nbatch*hdr_size);
+  temp = (char *)malloc(dat_size);
+  msgs = (struct mmsghdr *)calloc(nbatch, sizeof(struct mmsghdr));
+  iovs = (struct iovec *)calloc(2*nbatch, sizeof(struct iovec));
+  if(posix_memalign((void **)&scratch, UDP_CACHELINE_SIZE, (size_t)nbatch*dat_size) ||
+     hdrs == NULL || temp == NULL || msgs == NULL || iovs == NULL){
+    fprintf(stderr, "UDP_BLOCKREASSEMBLER_ERROR: Could not allocate packet arenas, "
+	    "which happens at \"%s\", line [%d], has to abort.\n",
+	    __FILE__, __LINE__);
+    exit(EXIT_FAILURE);
+  }
+
+  for(int i = 0; i < nbatch; i++){
+    iovs[2*i].iov_base   = hdrs + (size_t)i*hdr_size;
+    iovs[2*i].iov_len    = hdr_size;
+    iovs[2*i+1].iov_base = scratch + (size_t)i*dat_size;
+    iovs[2*i+1].iov_len  = dat_size;
+    msgs[i].msg_hdr.msg_iov    = &iovs[2*i];
+    msgs[i].msg_hdr.msg_iovlen = 2;
+  }
+
+  for(auto &wb : window){
+    wb.data = NULL;
+    wb.bitmap.resize((npkt + 63)/64);
+  }
+}
+
+UdpBlockReassembler::~UdpBlockReassembler(){
+  free(hdrs);
+  free(scratch);
+  free(temp);
+  free(msgs);
+  free(iovs);
+}
+
+void UdpBlockReassembler::start(uint64_t counter){
+  first       = counter;
+  expected    = counter;
+  max_counter = counter;
+  ioldest     = 0;
+
+  for(uint64_t b = 0; b < (uint64_t)nwindow; b++){
+    open(b);
+  }
+  started = true;
+}
+
+void UdpBlockReassembler::close(uint64_t iblock){
+  window_block_t &wb = window[iblock%nwindow];
+
+  // Fill missing packets with zeros
+  for(int i = 0; i < npkt; i++){
+    if(!(wb.bitmap[i/64] & (1ULL << (i%64)))){
+      memset(wb.data + (size_t)i*dat_size, 0, dat_size);
+    }
+  }
+  wb.stat.nlost = npkt - wb.stat.nreceived;
+  nlost_total += wb.stat.nlost;
+  nblock_total++;
+
+  closer(wb.data, wb.stat);
+  wb.data = NULL;
+}
+
+void UdpBlockReassembler::open(uint64_t iblock){
+  window_block_t &wb = window[iblock%nwindow];
+  wb.data = opener(iblock);
+  std::fill(wb.bitmap.begin(), wb.bitmap.end(), 0);
+  wb.stat = {iblock, 0, 0, 0, 0};
+}
+
+void UdpBlockReassembler::slide(uint64_t iblock){
+
+  // A jump of two windows or more, for example a corrupt counter, closes the window and restarts it at iblock,
+  // blocks in between are never opened, otherwise we would open and close them one by one
+  if(iblock >= ioldest + 2*(uint64_t)nwindow){
+    for(uint64_t b = ioldest; b < ioldest + nwindow; b++){
+      close(b);
+    }
+    nskip_total += iblock - (ioldest + nwindow);
+    ioldest = iblock;
+    for(uint64_t b = iblock; b < iblock + nwindow; b++){
+      open(b);
+    }
+    return;
+  }
+
+  while(iblock >= ioldest + nwindow){
+    close(ioldest);
+
+    // The slot of the closed block is reused by the new block
+    open(ioldest + nwindow);
+    ioldest++;
+  }
+}
+
+void UdpBlockReassembler::flush(){
+  if(started){
+    for(uint64_t b = ioldest; b < ioldest + nwindow; b++){
+      close(b);
+    }
+    started = false;
+  }
+}
+
+void UdpBlockReassembler::predict(){
+
+  // The block of the next in order packet has to be open, otherwise a whole batch lands in scratch
+  if(started){
+    slide((expected - first)/npkt);
+  }
+
+  for(int i = 0; i < nbatch; i++){
+    predicted[i] = 0;
+    iovs[2*i+1].iov_base = scratch + (size_t)i*dat_size;
+
+    if(!started){
+      continue;
+    }
+
+    // Only predict into open blocks and only into empty slots
+    uint64_t c = expected + i - first;
+    window_block_t *wb = find(c/npkt);
+    int idx = c%npkt;
+    if(wb != NULL && !(wb->bitmap[idx/64] & (1ULL << (idx%64)))){
+      iovs[2*i+1].iov_base = wb->data + (size_t)idx*dat_size;
+      predicted[i] = 1;
+    }
+  }
+}
+
+int UdpBlockReassembler::claim(int j, char **dst){
+  if(counters[j] < first){
+    nlate_total++;
+    return UDP_CLAIM_DROP;
+  }
+
+  uint64_t c = counters[j] - first;
+  uint64_t b = c/npkt;
+  int idx = c%npkt;
+
+  if(b < ioldest){
+    nlate_total++;
+    return UDP_CLAIM_DROP;
+  }
+
+  window_block_t *wb = find(b);
+  if(wb == NULL){
+    return UDP_CLAIM_BEYOND;
+  }
+
+  if(wb->bitmap[idx/64] & (1ULL << (idx%64))){
+    wb->stat.nduplicate++;
+    nduplicate_total++;
+    return UDP_CLAIM_DROP;
+  }
+
+  *dst = wb->data + (size_t)idx*dat_size;
+  return UDP_CLAIM_OK;
+}
+
+void UdpBlockReassembler::commit(int j){
+  uint64_t c = counters[j] - first;
+  window_block_t *wb = find(c/npkt);
+  int idx = c%npkt;
+
+  wb->bitmap[idx/64] |= 1ULL << (idx%64);
+  wb->stat.nreceived++;
+  if(reordered[j]){
+    wb->stat.nreordered++;
+  }
+  states[j] = PACKET_DONE;
+}
+
+void UdpBlockReassembler::place(int j){
+  states[j] = PACKET_MOVING;
+
+  // The slot may hold payload of another packet in this batch, which has to move out first
+  if(counters[j] >= expected && counters[j] - expected < (uint64_t)nrecv){
+    int k = counters[j] - expected;
+    if(predicted[k]){
+      if(states[k] == PACKET_PENDING){
+	place(k);
+      }
+      else if(states[k] == PACKET_MOVING){
+	// We are back to the start of a cycle, park its payload
+	memcpy(temp, srcs[k], dat_size);
+	srcs[k] = temp;
+	ncopy_total++;
+      }
+    }
+  }
+
+  char *dst = NULL;
+  int claimed = claim(j, &dst);
+  if(claimed == UDP_CLAIM_DROP){
+    states[j] = PACKET_DONE;
+    return;
+  }
+
+  if(claimed == UDP_CLAIM_BEYOND){
+    // Block is not open yet, keep the payload in its scratch slot, it may be sitting in a slot of an open block
+    char *hold = scratch + (size_t)j*dat_size;
+    if(srcs[j] != hold){
+      memcpy(hold, srcs[j], dat_size);
+      srcs[j] = hold;
+      ncopy_total++;
+    }
+    states[j] = PACKET_DEFERRED;
+    return;
+  }
+
+  memcpy(dst, srcs[j], dat_size);
+  ncopy_total++;
+  commit(j);
+}
+
+int UdpBlockReassembler::receive(int flags){
+
+  predict();
+
+  do{
+    nrecv = recvmmsg(sock, msgs, nbatch, flags, NULL);
+  }while(nrecv < 0 && errno == EINTR);
+
+  if(nrecv < 0){
+    return -1;
+  }
+
+  // Decode counters and find out of order packets in arrival order
+  for(int j = 0; j < nrecv; j++){
+    srcs[j]      = (char *)iovs[2*j+1].iov_base;
+    reordered[j] = 0;
+
+    if((msgs[j].msg_hdr.msg_flags & MSG_TRUNC) || (int)msgs[j].msg_len != hdr_size + dat_size){
+      nbad_total++;
+      states[j] = PACKET_DONE;
+      continue;
+    }
+    states[j] = PACKET_PENDING;
+
+    counters[j] = decode(hdrs + (size_t)j*hdr_size, hdr_size);
+    if(!started){
+      start(counters[j]);
+    }
+    else if(counters[j] < max_counter){
+      reordered[j] = 1;
+      nreordered_total++;
+    }
+    else{
+      max_counter = counters[j];
+    }
+  }
+  npacket_total += nrecv;
+
+  // Packets which are already in their slot
+  for(int j = 0; j < nrecv; j++){
+    if(states[j] == PACKET_PENDING && predicted[j] && counters[j] == expected + j){
+      char *dst;
+      if(claim(j, &dst) == UDP_CLAIM_OK){
+	commit(j);
+      }
+      else{
+	states[j] = PACKET_DONE;
+      }
+    }
+  }
+
+  // Packets which have to move to an open block
+  for(int j = 0; j < nrecv; j++){
+    if(states[j] == PACKET_PENDING){
+      place(j);
+    }
+  }
+
+  // Packets for blocks beyond the window, in arrival order
+  for(int j = 0; j < nrecv; j++){
+    if(states[j] == PACKET_DEFERRED){
+      slide((counters[j] - first)/npkt);
+
+      char *dst;
+      if(claim(j, &dst) == UDP_CLAIM_OK){
+	memcpy(dst, srcs[j], dat_size);
+	ncopy_total++;
+	commit(j);
+      }
+      states[j] = PACKET_DONE;
+    }
+  }
+
+  if(started){
+    expected = max_counter + 1;
+  }
+
+  return nrecv;
+}
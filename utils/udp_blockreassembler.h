@@ -0,0 +1,176 @@
+#ifndef _UDP_BLOCKREASSEMBLER_H
+#define _UDP_BLOCKREASSEMBLER_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#include <sys/socket.h>
+
+#include <functional>
+#include <vector>
+
+#include "udp_utils.h"
+#include "udp_batchreceiver.h"
+
+/*! \brief Statistics of one reassembled block
+ *
+ */
+typedef struct udp_block_stat_t{
+  uint64_t iblock;  ///< Block index since the first packet
+  int nreceived;    ///< Number of packets placed into the block
+  int nlost;        ///< Number of packets missing when the block is closed, they are filled with zeros
+  int nreordered;   ///< Number of packets which arrived after a packet with a larger counter
+  int nduplicate;   ///< Number of duplicate packets dropped
+}udp_block_stat_t;
+
+/*! Default packet counter decoder, little endian unsigned integer at the start of the packet header
+ *
+ * \param[in] hdr Packet header
+ * \param[in] hdr_size Packet header size in bytes, only the first min(hdr_size, 8) bytes are used
+ */
+uint64_t udp_counter_le(const char *hdr, int hdr_size);
+
+/*! \brief A class to reassemble a UDP packet stream into blocks with packet counter placement
+ *
+ * Packet i of block b carries counter first + b*npkt + i, where first is the counter of the first packet received.
+ * The class receives with `recvmmsg` and scatters each packet into two iovecs,
+ * the header goes to a small header arena and the payload goes straight to the slot where the next in order packet belongs.
+ * In order packets are never copied in user space, out of order packets are moved once to their slot,
+ * only a packet which is part of a cycle of swapped packets in one batch takes one extra copy.
+ *
+ * \p nwindow blocks are open at the same time, the newest one is the block of the next in order packet,
+ * a packet for a block beyond the window closes the oldest block,
+ * missing packets of a closed block are filled with zeros, packets for closed blocks are counted as late and dropped.
+ * A packet two windows or more ahead closes the whole window and restarts it at its block,
+ * the blocks jumped over are not opened and only counted in nskip_total.
+ * Duplicates are detected with a bitmap per block.
+ *
+ */
+class UdpBlockReassembler{
+public:
+  /*! Called when a block is needed
+   *
+   * \param[in] iblock Block index since the first packet
+   *
+   * \returns Buffer of npkt*dat_size bytes for the block
+   */
+  typedef std::function<char *(uint64_t iblock)> block_opener;
+
+  /*! Called when a block is complete, the buffer is not used by the class after that
+   *
+   * \param[in] block Buffer returned by block_opener
+   * \param[in] stat  Statistics of the block
+   */
+  typedef std::function<void(char *block, const udp_block_stat_t &stat)> block_closer;
+
+  //! Packet counter decoder, see udp_counter_le
+  typedef uint64_t (*counter_decoder)(const char *hdr, int hdr_size);
+
+  uint64_t npacket_total    = 0; ///< Number of packets received since the class is created
+  uint64_t nlate_total      = 0; ///< Number of packets dropped as their block is already closed
+  uint64_t nduplicate_total = 0; ///< Number of duplicate packets dropped
+  uint64_t nbad_total       = 0; ///< Number of packets dropped as their size is not hdr_size+dat_size
+  uint64_t nreordered_total = 0; ///< Number of out of order packets
+  uint64_t nlost_total      = 0; ///< Number of packets filled with zeros
+  uint64_t nblock_total     = 0; ///< Number of blocks closed
+  uint64_t nskip_total      = 0; ///< Number of blocks never opened as the counter jumps past them
+  uint64_t ncopy_total      = 0; ///< Number of payloads copied in user space
+
+  //! Constructor of UdpBlockReassembler class.
+  /*!
+   *
+   * \param[in] sock     Socket created by `create_udp_socket` in UDP_RECV direction, the class does not close it
+   * \param[in] hdr_size Packet header size in bytes, PKT_HDR_SIZE in DADA header
+   * \param[in] dat_size Packet payload size in bytes, PKT_DAT_SIZE in DADA header
+   * \param[in] npkt     Number of packets per block, NPKT in DADA header
+   * \param[in] nbatch   Maximum number of packets to receive with one system call
+   * \param[in] nwindow  Number of blocks open at the same time, which sets how late a packet can be
+   * \param[in] opener   Called to get a new block
+   * \param[in] closer   Called when a block is complete
+   * \param[in] decode   Packet counter decoder
+   *
+   */
+  UdpBlockReassembler(int sock, int hdr_size, int dat_size, int npkt, int nbatch, int nwindow,
+		      block_opener opener, block_closer closer, counter_decoder decode = udp_counter_le);
+
+  //! Deconstructor of UdpBlockReassembler class.
+  /*!
+   *
+   * - free packet arenas at the class life end, open blocks are not closed, call flush before that
+   */
+  ~UdpBlockReassembler();
+
+  /*! Receive a batch of packets and place them into blocks
+   *
+   * \param[in] flags Flags for `recvmmsg`
+   *
+   * \returns Number of packets received, -1 on error or timeout (check errno)
+   */
+  int receive(int flags = MSG_WAITFORONE);
+
+  //! Close all open blocks, the next packet starts a new stream, a block opened ahead of the stream end is closed with nreceived == 0
+  void flush();
+
+  UdpBlockReassembler(const UdpBlockReassembler&) = delete;
+  UdpBlockReassembler& operator=(const UdpBlockReassembler&) = delete;
+
+private:
+  typedef struct window_block_t{
+    char *data;
+    std::vector<uint64_t> bitmap;
+    udp_block_stat_t stat;
+  }window_block_t;
+
+  enum packet_state {PACKET_PENDING, PACKET_MOVING, PACKET_DEFERRED, PACKET_DONE};
+
+  int sock;       ///< Socket to receive packets from
+  int hdr_size;   ///< Packet header size in bytes
+  int dat_size;   ///< Packet payload size in bytes
+  int npkt;       ///< Number of packets per block
+  int nbatch;     ///< Maximum number of packets per batch
+  int nwindow;    ///< Number of open blocks
+
+  block_opener opener;    ///< Called to get a new block
+  block_closer closer;    ///< Called when a block is complete
+  counter_decoder decode; ///< Packet counter decoder
+
+  bool started = false;     ///< Do we have the first packet?
+  uint64_t first = 0;       ///< Counter of the first packet of block 0
+  uint64_t ioldest = 0;     ///< Index of the oldest open block
+  uint64_t expected = 0;    ///< Counter we expect for the first packet of the next batch
+  uint64_t max_counter = 0; ///< Largest counter so far
+
+  std::vector<window_block_t> window; ///< Open blocks, block b is at b%nwindow
+
+  char *hdrs    = NULL; ///< Packet headers of a batch
+  char *scratch = NULL; ///< Payload landing place when the slot of a packet is unknown
+  char *temp    = NULL; ///< One payload to break a cycle of swapped packets
+
+  struct mmsghdr *msgs = NULL; ///< Message headers, one for each packet of a batch
+  struct iovec   *iovs = NULL; ///< IO vectors, two for each packet of a batch
+
+  int nrecv = 0;                    ///< Number of packets in the current batch
+  std::vector<uint64_t> counters;   ///< Packet counters of the current batch
+  std::vector<char *>   srcs;       ///< Where the payloads of the current batch are
+  std::vector<int>      states;     ///< packet_state of the current batch
+  std::vector<char>     predicted;  ///< Is the payload iovec pointing to its predicted slot in a block?
+  std::vector<char>     reordered;  ///< Did the packet arrive out of order?
+
+  void start(uint64_t counter);   ///< Open first window with \p counter as the first packet
+  void open(uint64_t iblock);     ///< Get an empty block \p iblock into its window slot
+  void slide(uint64_t iblock);    ///< Close old blocks until \p iblock is inside window
+  void close(uint64_t iblock);    ///< Zero fill, report and close a block
+  void predict();                 ///< Point payload iovecs to predicted slots
+  void place(int j);              ///< Move packet \p j to its slot
+  int  claim(int j, char **dst);  ///< Check late and duplicate, find slot of packet \p j
+  void commit(int j);             ///< Mark slot of packet \p j as filled
+
+  window_block_t *find(uint64_t iblock){
+    return (iblock >= ioldest && iblock < ioldest + nwindow) ? &window[iblock%nwindow] : NULL;
+  }
+};
+
+#endif
@@ -0,0 +1,114 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "udp_groreceiver.h"
+
+#define UDP_GRO_CONTROL_SIZE CMSG_SPACE(sizeof(int))
+
+UdpGroReceiver::UdpGroReceiver(int sock, int pktsz, int nbatch)
+  :sock(sock), pktsz(pktsz), nbatch(nbatch){
+
+  if(posix_memalign((void **)&data, UDP_CACHELINE_SIZE, (size_t)UDP_GRO_BUFSZ*nbatch)){
+    fprintf(stderr, "UDP_GRORECEIVER_ERROR: Could not allocate %zu bytes buffers, "
+	    "which happens at \"%s\", line [%d], has to abort.\n",
+	    (size_t)UDP_GRO_BUFSZ*nbatch, __FILE__, __LINE__);
+    exit(EXIT_FAILURE);
+  }
+
+  msgs     = (struct mmsghdr *)calloc(nbatch, sizeof(struct mmsghdr));
+  iovs     = (struct iovec *)calloc(nbatch, sizeof(struct iovec));
+  controls = (char *)calloc(nbatch, UDP_GRO_CONTROL_SIZE);
+  if(msgs == NULL || iovs == NULL || controls == NULL){
+    fprintf(stderr, "UDP_GRORECEIVER_ERROR: Could not allocate message headers, "
+	    "which happens at \"%s\", line [%d], has to abort.\n",
+	    __FILE__, __LINE__);
+    exit(EXIT_FAILURE);
+  }
+
+  for(int i = 0; i < nbatch; i++){
+    iovs[i].iov_base = data + (size_t)i*UDP_GRO_BUFSZ;
+    iovs[i].iov_len  = UDP_GRO_BUFSZ;
+    msgs[i].msg_hdr.msg_iov    = &iovs[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+  }
+
+  // Each buffer holds at least one packet, most buffers hold UDP_GRO_BUFSZ/pktsz packets
+  int nper = pktsz > 0 ? UDP_GRO_BUFSZ/pktsz : 1;
+  packets.reserve((size_t)nbatch*(nper > 1 ? nper : 1));
+  sizes.reserve(packets.capacity());
+}
+
+UdpGroReceiver::~UdpGroReceiver(){
+  free(msgs);
+  free(iovs);
+  free(controls);
+  free(data);
+}
+
+int UdpGroReceiver::receive(int flags){
+
+  npacket    = 0;
+  ntruncated = 0;
+  nshort     = 0;
+  packets.clear();
+  sizes.clear();
+
+  // Kernel overwrites msg_controllen, so we have to set it for every batch
+  for(int i = 0; i < nbatch; i++){
+    msgs[i].msg_hdr.msg_control    = controls + (size_t)i*UDP_GRO_CONTROL_SIZE;
+    msgs[i].msg_hdr.msg_controllen = UDP_GRO_CONTROL_SIZE;
+  }
+
+  int nrecv;
+  do{
+    nrecv = recvmmsg(sock, msgs, nbatch, flags, NULL);
+    nsyscall_total++;
+  }while(nrecv < 0 && errno == EINTR);
+
+  if(nrecv < 0){
+    return -1;
+  }
+
+  for(int i = 0; i < nrecv; i++){
+    struct msghdr *hdr = &msgs[i].msg_hdr;
+    int len = msgs[i].msg_len;
+
+    // Without UDP_GRO control message the buffer is a single datagram
+    int segment = len;
+    for(struct cmsghdr *cmsg = CMSG_FIRSTHDR(hdr); cmsg != NULL; cmsg = CMSG_NXTHDR(hdr, cmsg)){
+      if(cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO){
+	memcpy(&segment, CMSG_DATA(cmsg), sizeof(int));
+      }
+    }
+
+    if(segment <= 0){
+      segment = len;
+    }
+
+    if(hdr->msg_flags & MSG_TRUNC){
+      ntruncated++;
+    }
+
+    char *buf = (char *)iovs[i].iov_base;
+    for(int offset = 0; offset < len; offset += segment){
+      int size = len - offset < segment ? len - offset : segment;
+      if(size > pktsz){
+	ntruncated++;
+      }
+      else if(size < pktsz){
+	nshort++;
+      }
+      packets.push_back(buf + offset);
+      sizes.push_back(size);
+    }
+  }
+
+  npacket = packets.size();
+  npacket_total    += npacket;
+  ntruncated_total += ntruncated;
+  nshort_total     += nshort;
+  nbuffer_total    += nrecv;
+
+  return npacket;
+}
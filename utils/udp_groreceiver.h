@@ -0,0 +1,92 @@
+#ifndef _UDP_GRORECEIVER_H
+#define _UDP_GRORECEIVER_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#include <sys/socket.h>
+
+#include <vector>
+
+#include "udp_utils.h"
+#include "udp_batchreceiver.h"
+
+#define UDP_GRO_BUFSZ 65536 ///< Size of one coalesced buffer, the largest UDP datagram fits
+
+/*! \brief A class to receive coalesced UDP buffers with `recvmmsg` and split them back into packets
+ *
+ * The class wraps a socket created by `create_udp_socket` with UDP_OPTION_GRO in UDP_RECV direction.
+ * Kernel delivers same flow datagrams as one buffer with the segment size in a UDP_GRO control message,
+ * the class splits each buffer into packet pointers without copy.
+ *
+ * It offers the same batch interface as UdpBatchReceiver, receive, npacket, packet and packet_size,
+ * pointers are valid until the next call of receive.
+ *
+ */
+class UdpGroReceiver{
+public:
+  int npacket = 0;         ///< Number of packets received with the last call of receive
+  int ntruncated = 0;      ///< Number of truncated packets in the last batch
+  int nshort = 0;          ///< Number of short packets in the last batch
+
+  uint64_t npacket_total    = 0; ///< Number of packets received since the class is created
+  uint64_t ntruncated_total = 0; ///< Number of truncated packets since the class is created
+  uint64_t nshort_total     = 0; ///< Number of short packets since the class is created
+  uint64_t nsyscall_total   = 0; ///< Number of `recvmmsg` calls since the class is created
+  uint64_t nbuffer_total    = 0; ///< Number of coalesced buffers since the class is created
+
+  //! Constructor of UdpGroReceiver class.
+  /*!
+   *
+   * - allocate \p nbatch cache aligned buffers of UDP_GRO_BUFSZ bytes
+   * - setup `mmsghdr`, `iovec` and control messages once
+   *
+   * \param[in] sock   Socket created by `create_udp_socket` with UDP_OPTION_GRO, the class does not close it
+   * \param[in] pktsz  Expected packet size in bytes, PKT_SIZE in DADA header
+   * \param[in] nbatch Maximum number of coalesced buffers to receive with one system call
+   *
+   */
+  UdpGroReceiver(int sock, int pktsz, int nbatch);
+
+  //! Deconstructor of UdpGroReceiver class.
+  /*!
+   *
+   * - free buffers and message headers at the class life end
+   */
+  ~UdpGroReceiver();
+
+  /*! Receive a batch of coalesced buffers and split them into packets
+   *
+   * \param[in] flags Flags for `recvmmsg`
+   *
+   * \returns Number of packets received, -1 on error or timeout (check errno)
+   */
+  int receive(int flags = MSG_WAITFORONE);
+
+  //! Pointer to packet \p i of the last batch
+  char *packet(int i) const {return packets[i];}
+
+  //! Number of bytes of packet \p i of the last batch
+  int packet_size(int i) const {return sizes[i];}
+
+  UdpGroReceiver(const UdpGroReceiver&) = delete;
+  UdpGroReceiver& operator=(const UdpGroReceiver&) = delete;
+
+private:
+  int sock;    ///< Socket to receive packets from
+  int pktsz;   ///< Expected packet size in bytes
+  int nbatch;  ///< Maximum number of buffers per batch
+
+  char *data = NULL;           ///< Coalesced buffers, buffer i starts at data + i*UDP_GRO_BUFSZ
+  char *controls = NULL;       ///< Control message buffers, one for each buffer
+  struct mmsghdr *msgs = NULL; ///< Message headers, one for each buffer
+  struct iovec   *iovs = NULL; ///< IO vectors, one for each buffer
+
+  std::vector<char *> packets; ///< Packet pointers of the last batch
+  std::vector<int>    sizes;   ///< Packet sizes of the last batch
+};
+
+#endif
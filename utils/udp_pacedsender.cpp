@@ -0,0 +1,161 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "udp_pacedsender.h"
+
+// We sleep only when we need to wait longer than this, otherwise spin
+#define UDP_PACING_SPIN_NS 50000.0
+
+static inline double elapsed_ns(const struct timespec &start, const struct timespec &stop){
+  return (stop.tv_sec - start.tv_sec)*1E9 + (stop.tv_nsec - start.tv_nsec);
+}
+
+UdpPacedSender::UdpPacedSender(int sock, int pktsz, int nbatch, double rate, enum udp_rate_unit unit, int gso)
+  :sock(sock), pktsz(pktsz), nbatch(nbatch), unit(unit){
+
+  npkt_per_msg = 1;
+  if(gso){
+    npkt_per_msg = UDP_GSO_MAX_BYTES/pktsz;
+    if(npkt_per_msg > UDP_GSO_MAX_SEGMENTS){
+      npkt_per_msg = UDP_GSO_MAX_SEGMENTS;
+    }
+    if(npkt_per_msg < 1){
+      npkt_per_msg = 1;
+    }
+  }
+
+  msgs = (struct mmsghdr *)calloc(nbatch, sizeof(struct mmsghdr));
+  iovs = (struct iovec *)calloc(nbatch, sizeof(struct iovec));
+  if(gso){
+    control = (char *)calloc(1, CMSG_SPACE(sizeof(uint16_t)));
+  }
+  if(msgs == NULL || iovs == NULL || (gso && control == NULL)){
+    fprintf(stderr, "UDP_PACEDSENDER_ERROR: Could not allocate message headers, "
+	    "which happens at \"%s\", line [%d], has to abort.\n",
+	    __FILE__, __LINE__);
+    exit(EXIT_FAILURE);
+  }
+
+  if(gso){
+    struct msghdr hdr = {0};
+    hdr.msg_control    = control;
+    hdr.msg_controllen = CMSG_SPACE(sizeof(uint16_t));
+
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&hdr);
+    cmsg->cmsg_level = SOL_UDP;
+    cmsg->cmsg_type  = UDP_SEGMENT;
+    cmsg->cmsg_len   = CMSG_LEN(sizeof(uint16_t));
+    uint16_t segment = pktsz;
+    memcpy(CMSG_DATA(cmsg), &segment, sizeof(segment));
+  }
+
+  for(int i = 0; i < nbatch; i++){
+    msgs[i].msg_hdr.msg_iov    = &iovs[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+    if(gso){
+      msgs[i].msg_hdr.msg_control    = control;
+      msgs[i].msg_hdr.msg_controllen = CMSG_SPACE(sizeof(uint16_t));
+    }
+  }
+
+  capacity = (double)pktsz*npkt_per_msg*nbatch;
+  set_rate(rate);
+}
+
+UdpPacedSender::~UdpPacedSender(){
+  free(msgs);
+  free(iovs);
+  free(control);
+}
+
+void UdpPacedSender::set_rate(double rate){
+  if(rate <= 0){
+    bytes_per_ns = 0;
+  }
+  else if(unit == UDP_RATE_GBPS){
+    bytes_per_ns = rate/8.0;
+  }
+  else{
+    bytes_per_ns = rate*pktsz/1E9;
+  }
+
+  // Start with a full bucket so that the first batch goes out immediately
+  tokens = capacity;
+  clock_gettime(CLOCK_MONOTONIC, &last);
+}
+
+void UdpPacedSender::wait_tokens(double nbytes){
+  struct timespec now;
+
+  while(true){
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    tokens += elapsed_ns(last, now)*bytes_per_ns;
+    last = now;
+    if(tokens > capacity){
+      tokens = capacity;
+    }
+
+    if(tokens >= nbytes){
+      tokens -= nbytes;
+      return;
+    }
+
+    double wait = (nbytes - tokens)/bytes_per_ns;
+    if(wait > UDP_PACING_SPIN_NS){
+      // Sleep a bit less than required, the rest is covered by spin
+      struct timespec nap = {0, (long)(wait - UDP_PACING_SPIN_NS)};
+      if(nap.tv_nsec >= 1000000000L){
+	nap.tv_sec  = nap.tv_nsec/1000000000L;
+	nap.tv_nsec = nap.tv_nsec%1000000000L;
+      }
+      nanosleep(&nap, NULL);
+    }
+  }
+}
+
+int UdpPacedSender::send(const char *buf, int npacket){
+
+  int isent = 0;
+  while(isent < npacket){
+    // Up to nbatch messages, each with up to npkt_per_msg packets
+    int nmsg = 0;
+    int nbatch_now = 0;
+    while(nmsg < nbatch && isent + nbatch_now < npacket){
+      int nleft = npacket - isent - nbatch_now;
+      int npkt  = nleft < npkt_per_msg ? nleft : npkt_per_msg;
+
+      iovs[nmsg].iov_base = (void *)(buf + (size_t)(isent + nbatch_now)*pktsz);
+      iovs[nmsg].iov_len  = (size_t)npkt*pktsz;
+      nbatch_now += npkt;
+      nmsg++;
+    }
+
+    if(bytes_per_ns > 0){
+      wait_tokens((double)nbatch_now*pktsz);
+    }
+
+    // sendmmsg may send less than asked, keep going until the batch is out
+    int imsg = 0;
+    while(imsg < nmsg){
+      int nsent = sendmmsg(sock, msgs + imsg, nmsg - imsg, 0);
+      nsyscall_total++;
+
+      if(nsent < 0){
+	if(errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS){
+	  continue;
+	}
+	fprintf(stderr, "UDP_PACEDSENDER_ERROR: sendmmsg failed with \"%s\", "
+		"which happens at \"%s\", line [%d], has to abort.\n",
+		strerror(errno), __FILE__, __LINE__);
+	return EXIT_FAILURE;
+      }
+      imsg += nsent;
+    }
+
+    isent         += nbatch_now;
+    npacket_total += nbatch_now;
+  }
+
+  return EXIT_SUCCESS;
+}
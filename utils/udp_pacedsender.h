@@ -0,0 +1,92 @@
+#ifndef _UDP_PACEDSENDER_H
+#define _UDP_PACEDSENDER_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include <sys/socket.h>
+
+#include "udp_utils.h"
+
+enum udp_rate_unit {UDP_RATE_GBPS = 0, UDP_RATE_PPS = 1};
+
+#define UDP_GSO_MAX_SEGMENTS 64    ///< Maximum number of segments kernel accepts in one UDP_SEGMENT send
+#define UDP_GSO_MAX_BYTES    65507 ///< Maximum UDP payload of one UDP_SEGMENT send over IPv4
+
+/*! \brief A class to send UDP packets in batches with `sendmmsg` at a steady rate
+ *
+ * The class wraps a connected socket created by `create_udp_socket` in UDP_SEND direction,
+ * unicast, multicast or broadcast is decided when the socket is created.
+ *
+ * Pacing uses a token bucket, tokens are bytes and the bucket refills at the target rate.
+ * The bucket holds at most one batch worth of tokens, so the sender never bursts more than one batch.
+ * It sleeps when it has to wait for a long time and spins for the last bit to keep the rate precise.
+ *
+ * With \p gso, each message carries as many packets as UDP_SEGMENT allows (7 packets of 8200 bytes)
+ * and the kernel segments it into packets, so a block of packets goes out with one `sendmmsg` of a few messages.
+ *
+ */
+class UdpPacedSender{
+public:
+  uint64_t npacket_total  = 0; ///< Number of packets sent since the class is created
+  uint64_t nsyscall_total = 0; ///< Number of `sendmmsg` calls since the class is created
+
+  //! Constructor of UdpPacedSender class.
+  /*!
+   *
+   * \param[in] sock   Connected socket created by `create_udp_socket` in UDP_SEND direction, the class does not close it
+   * \param[in] pktsz  Packet size in bytes
+   * \param[in] nbatch Maximum number of messages to send with one system call, a message is one packet without gso
+   * \param[in] rate   Target rate, 0 or negative value means no pacing
+   * \param[in] unit   Unit of \p rate, UDP_RATE_GBPS (payload bits) or UDP_RATE_PPS
+   * \param[in] gso    Nonzero to let kernel segment messages with UDP_SEGMENT
+   *
+   */
+  UdpPacedSender(int sock, int pktsz, int nbatch, double rate, enum udp_rate_unit unit, int gso = 0);
+
+  //! Deconstructor of UdpPacedSender class.
+  /*!
+   *
+   * - free message headers at the class life end
+   */
+  ~UdpPacedSender();
+
+  /*! Send \p npacket packets from a contiguous buffer, packet i starts at buf + i*pktsz
+   *
+   * \param[in] buf     Packets to send
+   * \param[in] npacket Number of packets to send
+   *
+   * \returns EXIT_SUCCESS when all packets are sent, EXIT_FAILURE otherwise
+   */
+  int send(const char *buf, int npacket);
+
+  //! Change the target rate, with the same unit as the one given at construction
+  void set_rate(double rate);
+
+  UdpPacedSender(const UdpPacedSender&) = delete;
+  UdpPacedSender& operator=(const UdpPacedSender&) = delete;
+
+private:
+  int sock;    ///< Socket to send packets to
+  int pktsz;   ///< Packet size in bytes
+  int nbatch;  ///< Maximum number of messages per batch
+  enum udp_rate_unit unit; ///< Unit of target rate
+  int npkt_per_msg;        ///< Number of packets per message, 1 without gso
+
+  double bytes_per_ns = 0; ///< Refill rate of token bucket, 0 means no pacing
+  double tokens = 0;       ///< Tokens in bytes
+  double capacity = 0;     ///< Capacity of token bucket in bytes
+  struct timespec last;    ///< Last time the bucket is refilled
+
+  struct mmsghdr *msgs = NULL; ///< Message headers, one for each message in a batch
+  struct iovec   *iovs = NULL; ///< IO vectors, one for each message in a batch
+  char *control = NULL;        ///< UDP_SEGMENT control message shared by all messages
+
+  void wait_tokens(double nbytes); ///< Refill the bucket and wait until it has \p nbytes tokens
+};
+
+#endif
@@ -0,0 +1,128 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "udp_reuseportreceiver.h"
+
+int udp_steer_program(const udp_steer_t &steer, int nsocket, std::vector<struct sock_filter> &prog){
+
+  if(steer.size != 1 && steer.size != 2 && steer.size != 4){
+    fprintf(stderr, "UDP_STEER_PROGRAM_ERROR: Field size %d is not supported, "
+	    "which happens at \"%s\", line [%d], has to abort.\n",
+	    steer.size, __FILE__, __LINE__);
+    return EXIT_FAILURE;
+  }
+
+  prog.clear();
+
+  // The program runs with UDP header pulled, so offset 0 is the start of UDP payload
+  if(steer.size == 1){
+    prog.push_back((struct sock_filter)BPF_STMT(BPF_LD | BPF_B | BPF_ABS, (uint32_t)steer.offset));
+  }
+  else if(!steer.little_endian){
+    // BPF_ABS loads are in network byte order
+    uint16_t width = steer.size == 2 ? BPF_H : BPF_W;
+    prog.push_back((struct sock_filter)BPF_STMT(BPF_LD | width | BPF_ABS, (uint32_t)steer.offset));
+  }
+  else{
+    // No byte swap in classic BPF, assemble little endian field byte by byte from the most significant one
+    prog.push_back((struct sock_filter)BPF_STMT(BPF_LD | BPF_B | BPF_ABS, (uint32_t)(steer.offset + steer.size - 1)));
+    for(int k = steer.size - 2; k >= 0; k--){
+      prog.push_back((struct sock_filter)BPF_STMT(BPF_ALU | BPF_LSH | BPF_K, 8));
+      prog.push_back((struct sock_filter)BPF_STMT(BPF_ST, 0));
+      prog.push_back((struct sock_filter)BPF_STMT(BPF_LD | BPF_B | BPF_ABS, (uint32_t)(steer.offset + k)));
+      prog.push_back((struct sock_filter)BPF_STMT(BPF_MISC | BPF_TAX, 0));
+      prog.push_back((struct sock_filter)BPF_STMT(BPF_LD | BPF_MEM, 0));
+      prog.push_back((struct sock_filter)BPF_STMT(BPF_ALU | BPF_OR | BPF_X, 0));
+    }
+  }
+
+  uint32_t range = steer.range > 0 ? steer.range : 1;
+  if(range > 1){
+    prog.push_back((struct sock_filter)BPF_STMT(BPF_ALU | BPF_DIV | BPF_K, range));
+  }
+  prog.push_back((struct sock_filter)BPF_STMT(BPF_ALU | BPF_MOD | BPF_K, (uint32_t)nsocket));
+  prog.push_back((struct sock_filter)BPF_STMT(BPF_RET | BPF_A, 0));
+
+  return EXIT_SUCCESS;
+}
+
+UdpReusePortReceiver::UdpReusePortReceiver(char *ip, int port, int nsocket, int bufsz, double tout,
+					   int pktsz, int nbatch, const udp_steer_t *steer)
+  :nsocket(nsocket), pktsz(pktsz), nbatch(nbatch), socks(nsocket, -1), npackets(nsocket){
+
+  if(tout < 0){
+    tout = UDP_REUSEPORT_POLL_TOUT;
+  }
+
+  // Socket index in the reuseport group follows bind order
+  for(int i = 0; i < nsocket; i++){
+    if(create_udp_socket(ip, NULL, port, socks[i], UDP_REUSE_ADDR | UDP_REUSE_PORT,
+			 bufsz, tout, UDP_UNICAST, UDP_RECV)){
+      fprintf(stderr, "UDP_REUSEPORTRECEIVER_ERROR: Could not create socket %d of %d, "
+	      "which happens at \"%s\", line [%d], has to abort.\n",
+	      i, nsocket, __FILE__, __LINE__);
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  if(steer != NULL){
+    std::vector<struct sock_filter> prog;
+    if(udp_steer_program(*steer, nsocket, prog)){
+      exit(EXIT_FAILURE);
+    }
+
+    // One socket is enough, the program applies to the whole group
+    struct sock_fprog fprog = {(unsigned short)prog.size(), prog.data()};
+    if(setsockopt(socks[0], SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &fprog, sizeof(fprog))){
+      fprintf(stderr, "UDP_REUSEPORTRECEIVER_ERROR: Could not attach steering program with \"%s\", "
+	      "which happens at \"%s\", line [%d], has to abort.\n",
+	      strerror(errno), __FILE__, __LINE__);
+      exit(EXIT_FAILURE);
+    }
+  }
+}
+
+UdpReusePortReceiver::~UdpReusePortReceiver(){
+  stop();
+  for(int sock : socks){
+    close(sock);
+  }
+}
+
+void UdpReusePortReceiver::start(batch_callback callback, const int *cpus){
+  running = true;
+  for(int i = 0; i < nsocket; i++){
+    threads.emplace_back(&UdpReusePortReceiver::receive, this, i, callback, cpus == NULL ? -1 : cpus[i]);
+  }
+}
+
+void UdpReusePortReceiver::stop(){
+  running = false;
+  for(auto &thread : threads){
+    thread.join();
+  }
+  threads.clear();
+}
+
+void UdpReusePortReceiver::receive(int ithread, batch_callback callback, int cpu){
+
+  if(cpu >= 0){
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    CPU_SET(cpu, &cpuset);
+    if(pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset)){
+      fprintf(stderr, "UDP_REUSEPORTRECEIVER_WARN: Could not pin thread %d to CPU %d, "
+	      "which happens at \"%s\", line [%d].\n",
+	      ithread, cpu, __FILE__, __LINE__);
+    }
+  }
+
+  UdpBatchReceiver receiver(socks[ithread], pktsz, nbatch);
+  while(running){
+    if(receiver.receive() > 0){
+      npackets[ithread].fetch_add(receiver.npacket, std::memory_order_relaxed);
+      callback(ithread, receiver);
+    }
+  }
+}
@@ -0,0 +1,118 @@
+#ifndef _UDP_REUSEPORTRECEIVER_H
+#define _UDP_REUSEPORTRECEIVER_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#include <pthread.h>
+#include <sched.h>
+#include <linux/filter.h>
+
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "udp_utils.h"
+#include "udp_batchreceiver.h"
+
+#define UDP_REUSEPORT_POLL_TOUT 0.1 ///< Timeout in seconds used instead of block without timeout, so that threads can notice stop
+
+/*! \brief Where to find the steering field in the packet header
+ *
+ * The thread index of a packet is (field/range)%nsocket,
+ * so that each thread owns a fixed range of beams or channels.
+ */
+typedef struct udp_steer_t{
+  int offset;        ///< Byte offset of the field from the start of UDP payload, it should be inside the packet header (PKT_HDR_SIZE)
+  int size;          ///< Size of the field in bytes, 1, 2 or 4
+  int little_endian; ///< Byte order of the field, nonzero for little endian
+  uint32_t range;    ///< Number of field values owned by each thread
+}udp_steer_t;
+
+/*! Build a classic BPF program for `SO_ATTACH_REUSEPORT_CBPF` which steers packets by a field in the packet header
+ *
+ * \param[in]  steer   Where to find the steering field
+ * \param[in]  nsocket Number of sockets in the reuseport group
+ * \param[out] prog    Program instructions
+ *
+ * \returns EXIT_SUCCESS or EXIT_FAILURE if \p steer is not supported
+ */
+int udp_steer_program(const udp_steer_t &steer, int nsocket, std::vector<struct sock_filter> &prog);
+
+/*! \brief A class to fan out UDP receive to multiple sockets bound to the same ip and port with `SO_REUSEPORT`
+ *
+ * Each socket is drained by its own thread with a UdpBatchReceiver, threads can be pinned to given CPUs.
+ * Without steering the kernel spreads flows over sockets by hash,
+ * with steering a classic BPF program picks the socket from a field in the packet header,
+ * a stream always lands on the same socket so packet order within a stream is preserved.
+ *
+ */
+class UdpReusePortReceiver{
+public:
+  /*! Callback for each batch, it runs on the receive thread
+   *
+   * \param[in] ithread  Index of the receive thread, which is also the index of the socket in the reuseport group
+   * \param[in] receiver Receiver with the batch of packets
+   */
+  typedef std::function<void(int ithread, UdpBatchReceiver &receiver)> batch_callback;
+
+  //! Constructor of UdpReusePortReceiver class.
+  /*!
+   *
+   * - create \p nsocket sockets with `create_udp_socket` and SO_REUSEPORT
+   * - attach steering program to the group if \p steer is not NULL
+   *
+   * \param[in] ip      IP address to bind, NULL for INADDR_ANY
+   * \param[in] port    Port number
+   * \param[in] nsocket Number of sockets and receive threads
+   * \param[in] bufsz   Socket buffer size in MBytes of each socket
+   * \param[in] tout    Socket timeout in seconds, negative value is replaced by UDP_REUSEPORT_POLL_TOUT
+   * \param[in] pktsz   Expected packet size in bytes
+   * \param[in] nbatch  Maximum number of packets per batch
+   * \param[in] steer   Steering field, NULL to leave it to the kernel hash
+   *
+   */
+  UdpReusePortReceiver(char *ip, int port, int nsocket, int bufsz, double tout,
+		       int pktsz, int nbatch, const udp_steer_t *steer = NULL);
+
+  //! Deconstructor of UdpReusePortReceiver class.
+  /*!
+   *
+   * - stop receive threads and close all sockets at the class life end
+   */
+  ~UdpReusePortReceiver();
+
+  /*! Start receive threads
+   *
+   * \param[in] callback Called for each batch on the receive thread
+   * \param[in] cpus     CPU for each thread, NULL to not pin threads
+   */
+  void start(batch_callback callback, const int *cpus = NULL);
+
+  //! Stop receive threads and wait for them to finish
+  void stop();
+
+  //! Number of packets received by thread \p ithread
+  uint64_t npacket(int ithread) const {return npackets[ithread].load(std::memory_order_relaxed);}
+
+  UdpReusePortReceiver(const UdpReusePortReceiver&) = delete;
+  UdpReusePortReceiver& operator=(const UdpReusePortReceiver&) = delete;
+
+private:
+  int nsocket; ///< Number of sockets in the group
+  int pktsz;   ///< Expected packet size in bytes
+  int nbatch;  ///< Maximum number of packets per batch
+
+  std::vector<int> socks;           ///< Sockets in the group, in bind order
+  std::vector<std::thread> threads; ///< Receive threads
+  std::vector<std::atomic<uint64_t>> npackets; ///< Number of packets received by each thread
+  std::atomic<bool> running{false}; ///< Receive threads keep going while it is true
+
+  void receive(int ithread, batch_callback callback, int cpu); ///< Receive loop of one thread
+};
+
+#endif
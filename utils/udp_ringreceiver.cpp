@@ -0,0 +1,205 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "udp_ringreceiver.h"
+
+#include <unistd.h>
+
+#ifndef PACKET_IGNORE_OUTGOING
+#define PACKET_IGNORE_OUTGOING 23
+#endif
+
+UdpRingReceiver::UdpRingReceiver(const char *ifname, int port, int pktsz, double tout,
+				 int block_size, int nblock)
+  :pktsz(pktsz), block_size(block_size), nblock(nblock){
+
+  // Same time out convention as create_udp_socket
+  if(tout == 0){
+    timeout = 0;
+  }
+  else if(tout > 0){
+    timeout = tout*1E3;
+  }
+  else{
+    timeout = -1;
+  }
+
+  // SOCK_DGRAM removes link layer header, so the filter and packet offsets start at IP header
+  sock = socket(AF_PACKET, SOCK_DGRAM, htons(ETH_P_IP));
+  if(sock < 0){
+    fprintf(stderr, "UDP_RINGRECEIVER_ERROR: Could not create AF_PACKET socket with \"%s\", "
+	    "which happens at \"%s\", line [%d], has to abort.\n",
+	    strerror(errno), __FILE__, __LINE__);
+    exit(EXIT_FAILURE);
+  }
+
+  // Filter IPv4 UDP packets to given port in kernel, fragments are dropped
+  struct sock_filter code[] = {
+    BPF_STMT(BPF_LD  | BPF_B   | BPF_ABS, 9),
+    BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, IPPROTO_UDP, 0, 6),
+    BPF_STMT(BPF_LD  | BPF_H   | BPF_ABS, 6),
+    BPF_JUMP(BPF_JMP | BPF_JSET| BPF_K, 0x1fff, 4, 0),
+    BPF_STMT(BPF_LDX | BPF_B   | BPF_MSH, 0),
+    BPF_STMT(BPF_LD  | BPF_H   | BPF_IND, 2),
+    BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, (uint32_t)port, 0, 1),
+    BPF_STMT(BPF_RET | BPF_K, 0x40000),
+    BPF_STMT(BPF_RET | BPF_K, 0),
+  };
+  struct sock_fprog fprog = {sizeof(code)/sizeof(code[0]), code};
+  if(setsockopt(sock, SOL_SOCKET, SO_ATTACH_FILTER, &fprog, sizeof(fprog))){
+    fprintf(stderr, "UDP_RINGRECEIVER_ERROR: Could not attach port filter with \"%s\", "
+	    "which happens at \"%s\", line [%d], has to abort.\n",
+	    strerror(errno), __FILE__, __LINE__);
+    exit(EXIT_FAILURE);
+  }
+
+  // On loopback we see every packet twice without this, failure is fine on old kernels
+  int enable = 1;
+  setsockopt(sock, SOL_PACKET, PACKET_IGNORE_OUTGOING, &enable, sizeof(enable));
+
+  int version = TPACKET_V3;
+  if(setsockopt(sock, SOL_PACKET, PACKET_VERSION, &version, sizeof(version))){
+    fprintf(stderr, "UDP_RINGRECEIVER_ERROR: Could not setup TPACKET_V3 with \"%s\", "
+	    "which happens at \"%s\", line [%d], has to abort.\n",
+	    strerror(errno), __FILE__, __LINE__);
+    exit(EXIT_FAILURE);
+  }
+
+  // Frame size is only used by kernel to verify ring geometry with TPACKET_V3
+  struct tpacket_req3 req = {0};
+  req.tp_block_size = block_size;
+  req.tp_block_nr   = nblock;
+  req.tp_frame_size = TPACKET_ALIGNMENT << 7;
+  req.tp_frame_nr   = (block_size/req.tp_frame_size)*nblock;
+  req.tp_retire_blk_tov = UDP_RING_BLOCK_TOUT;
+  if(setsockopt(sock, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req))){
+    fprintf(stderr, "UDP_RINGRECEIVER_ERROR: Could not setup %d blocks ring with \"%s\", "
+	    "which happens at \"%s\", line [%d], has to abort.\n",
+	    nblock, strerror(errno), __FILE__, __LINE__);
+    exit(EXIT_FAILURE);
+  }
+
+  ring = (char *)mmap(NULL, (size_t)block_size*nblock, PROT_READ | PROT_WRITE,
+		      MAP_SHARED | MAP_LOCKED, sock, 0);
+  if(ring == MAP_FAILED){
+    // MAP_LOCKED needs RLIMIT_MEMLOCK, try without it
+    ring = (char *)mmap(NULL, (size_t)block_size*nblock, PROT_READ | PROT_WRITE,
+			MAP_SHARED, sock, 0);
+  }
+  if(ring == MAP_FAILED){
+    fprintf(stderr, "UDP_RINGRECEIVER_ERROR: Could not map ring with \"%s\", "
+	    "which happens at \"%s\", line [%d], has to abort.\n",
+	    strerror(errno), __FILE__, __LINE__);
+    exit(EXIT_FAILURE);
+  }
+
+  struct sockaddr_ll sll = {0};
+  sll.sll_family   = AF_PACKET;
+  sll.sll_protocol = htons(ETH_P_IP);
+  sll.sll_ifindex  = if_nametoindex(ifname);
+  if(sll.sll_ifindex == 0 || bind(sock, (struct sockaddr *)&sll, sizeof(sll))){
+    fprintf(stderr, "UDP_RINGRECEIVER_ERROR: Could not bind to interface %s, "
+	    "which happens at \"%s\", line [%d], has to abort.\n",
+	    ifname, __FILE__, __LINE__);
+    exit(EXIT_FAILURE);
+  }
+
+  // A block can hold at most this number of packets
+  int nmax = block_size/TPACKET_ALIGN(sizeof(struct tpacket3_hdr) + sizeof(struct iphdr) + sizeof(struct udphdr)) + 1;
+  packets.resize(nmax);
+  sizes.resize(nmax);
+}
+
+UdpRingReceiver::~UdpRingReceiver(){
+  release();
+  munmap(ring, (size_t)block_size*nblock);
+  close(sock);
+}
+
+void UdpRingReceiver::release(){
+  if(current != NULL){
+    __atomic_store_n(&current->hdr.bh1.block_status, TP_STATUS_KERNEL, __ATOMIC_RELEASE);
+    current = NULL;
+    iblock = (iblock + 1)%nblock;
+  }
+}
+
+uint64_t UdpRingReceiver::ndrop(){
+  struct tpacket_stats_v3 stats = {0};
+  socklen_t len = sizeof(stats);
+
+  // Kernel resets counters after each read
+  if(getsockopt(sock, SOL_PACKET, PACKET_STATISTICS, &stats, &len)){
+    return 0;
+  }
+  return stats.tp_drops;
+}
+
+int UdpRingReceiver::receive(){
+
+  release();
+
+  npacket    = 0;
+  ntruncated = 0;
+  nshort     = 0;
+
+  struct tpacket_block_desc *block;
+  int num_pkts = 0;
+  while(num_pkts == 0){
+    block = (struct tpacket_block_desc *)(ring + (size_t)iblock*block_size);
+
+    // Only wait in kernel when the block is not ready yet
+    while(!(__atomic_load_n(&block->hdr.bh1.block_status, __ATOMIC_ACQUIRE) & TP_STATUS_USER)){
+      struct pollfd pfd = {sock, POLLIN | POLLERR, 0};
+      int ready = poll(&pfd, 1, timeout);
+      nsyscall_total++;
+
+      if(ready < 0 && errno == EINTR){
+	continue;
+      }
+      if(ready <= 0){
+	if(ready == 0){
+	  errno = EAGAIN;
+	}
+	return -1;
+      }
+    }
+    current = block;
+
+    // An empty block is possible, give it back and move on
+    num_pkts = block->hdr.bh1.num_pkts;
+    if(num_pkts == 0){
+      release();
+    }
+  }
+  struct tpacket3_hdr *hdr = (struct tpacket3_hdr *)((char *)block + block->hdr.bh1.offset_to_first_pkt);
+  for(int i = 0; i < num_pkts; i++){
+    char *ip = (char *)hdr + hdr->tp_net;
+    int ihl  = (((struct iphdr *)ip)->ihl)*4;
+    struct udphdr *udp = (struct udphdr *)(ip + ihl);
+
+    int size     = ntohs(udp->len) - (int)sizeof(struct udphdr);
+    int captured = (int)hdr->tp_snaplen - ihl - (int)sizeof(struct udphdr);
+
+    if(captured < size || size > pktsz){
+      ntruncated++;
+    }
+    else if(size < pktsz){
+      nshort++;
+    }
+
+    packets[i] = (char *)udp + sizeof(struct udphdr);
+    sizes[i]   = captured < size ? captured : size;
+
+    hdr = (struct tpacket3_hdr *)((char *)hdr + hdr->tp_next_offset);
+  }
+
+  npacket = num_pkts;
+  npacket_total    += num_pkts;
+  ntruncated_total += ntruncated;
+  nshort_total     += nshort;
+  nblock_total++;
+
+  return num_pkts;
+}
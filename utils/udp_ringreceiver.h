@@ -0,0 +1,111 @@
+#ifndef _UDP_RINGRECEIVER_H
+#define _UDP_RINGRECEIVER_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#include <poll.h>
+#include <net/if.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <netinet/ip.h>
+#include <netinet/udp.h>
+#include <linux/if_ether.h>
+#include <linux/if_packet.h>
+#include <linux/filter.h>
+
+#include <vector>
+
+#define UDP_RING_BLOCK_SIZE (1<<22) ///< Default ring block size in bytes, should be a multiple of page size
+#define UDP_RING_NBLOCK     64      ///< Default number of ring blocks
+#define UDP_RING_BLOCK_TOUT 8       ///< Time out in milliseconds to retire a partially filled block
+
+/*! \brief A class to capture UDP packets of a given port with a `TPACKET_V3` memory mapped ring
+ *
+ * The class opens an AF_PACKET socket on interface \p ifname, attaches a classic BPF filter
+ * so that the kernel only copies IPv4 UDP packets to \p port into the ring,
+ * and hands out whole blocks of packets straight from the ring without copy.
+ *
+ * It offers the same batch interface as UdpBatchReceiver, receive, npacket, packet and packet_size,
+ * pointers are valid until the next call of receive, which gives the block back to the kernel.
+ *
+ * It requires CAP_NET_RAW, it also works on the loopback interface "lo".
+ *
+ */
+class UdpRingReceiver{
+public:
+  int npacket = 0;         ///< Number of packets in the current block
+  int ntruncated = 0;      ///< Number of truncated packets in the current block
+  int nshort = 0;          ///< Number of short packets in the current block
+
+  uint64_t npacket_total    = 0; ///< Number of packets received since the class is created
+  uint64_t ntruncated_total = 0; ///< Number of truncated packets since the class is created
+  uint64_t nshort_total     = 0; ///< Number of short packets since the class is created
+  uint64_t nsyscall_total   = 0; ///< Number of `poll` calls since the class is created
+  uint64_t nblock_total     = 0; ///< Number of blocks received since the class is created
+
+  //! Constructor of UdpRingReceiver class.
+  /*!
+   *
+   * - create AF_PACKET socket with TPACKET_V3 ring and map it
+   * - attach BPF filter for UDP destination port \p port
+   * - bind socket to interface \p ifname
+   *
+   * \param[in] ifname     Interface name, "lo" for loopback
+   * \param[in] port       UDP destination port to capture
+   * \param[in] pktsz      Expected UDP payload size in bytes, PKT_SIZE in DADA header
+   * \param[in] tout       Time out in seconds, 0 means nonblock, negative means block without timeout
+   * \param[in] block_size Ring block size in bytes
+   * \param[in] nblock     Number of ring blocks
+   *
+   */
+  UdpRingReceiver(const char *ifname, int port, int pktsz, double tout,
+		  int block_size = UDP_RING_BLOCK_SIZE, int nblock = UDP_RING_NBLOCK);
+
+  //! Deconstructor of UdpRingReceiver class.
+  /*!
+   *
+   * - unmap the ring and close the socket at the class life end
+   */
+  ~UdpRingReceiver();
+
+  /*! Give the current block back to the kernel and wait for the next one
+   *
+   * \returns Number of packets in the block, -1 on error or timeout
+   */
+  int receive();
+
+  //! Pointer to UDP payload of packet \p i in the current block
+  char *packet(int i) const {return packets[i];}
+
+  //! UDP payload size in bytes of packet \p i in the current block
+  int packet_size(int i) const {return sizes[i];}
+
+  //! Number of packets dropped by the kernel since the last call, from PACKET_STATISTICS
+  uint64_t ndrop();
+
+  UdpRingReceiver(const UdpRingReceiver&) = delete;
+  UdpRingReceiver& operator=(const UdpRingReceiver&) = delete;
+
+private:
+  int sock = -1;   ///< AF_PACKET socket
+  int pktsz;       ///< Expected UDP payload size in bytes
+  int timeout;     ///< Poll time out in milliseconds, -1 for infinite
+  int block_size;  ///< Ring block size in bytes
+  int nblock;      ///< Number of ring blocks
+
+  char *ring = NULL;  ///< Mapped ring
+  int iblock = 0;     ///< Index of the next block to check
+  struct tpacket_block_desc *current = NULL; ///< Block held by user space, NULL if none
+
+  std::vector<char *> packets; ///< Payload pointers of the current block
+  std::vector<int>    sizes;   ///< Payload sizes of the current block
+
+  void release(); ///< Give the current block back to kernel
+};
+
+#endif
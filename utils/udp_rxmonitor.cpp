@@ -0,0 +1,58 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "udp_rxmonitor.h"
+
+static inline int64_t diff_ns(const struct timespec &start, const struct timespec &stop){
+  return (int64_t)(stop.tv_sec - start.tv_sec)*1000000000LL + (stop.tv_nsec - start.tv_nsec);
+}
+
+UdpRxMonitor::UdpRxMonitor(){
+  for(int i = 0; i < UDP_RXMONITOR_NBIN; i++){
+    hist_interarrival[i].store(0, std::memory_order_relaxed);
+    hist_latency[i].store(0, std::memory_order_relaxed);
+  }
+  ndrops.store(0, std::memory_order_relaxed);
+  npackets.store(0, std::memory_order_relaxed);
+}
+
+int UdpRxMonitor::bin_index(int64_t ns){
+  if(ns <= 0){
+    return 0;
+  }
+  int i = 64 - __builtin_clzll((uint64_t)ns);
+  return i < UDP_RXMONITOR_NBIN ? i : UDP_RXMONITOR_NBIN - 1;
+}
+
+void UdpRxMonitor::record(const UdpBatchReceiver &receiver){
+  // One clock read per batch, kernel timestamps are CLOCK_REALTIME
+  struct timespec now;
+  clock_gettime(CLOCK_REALTIME, &now);
+
+  for(int i = 0; i < receiver.npacket; i++){
+    const struct timespec &stamp = receiver.timestamp(i);
+
+    increase(hist_latency[bin_index(diff_ns(stamp, now))]);
+    if(started){
+      increase(hist_interarrival[bin_index(diff_ns(last, stamp))]);
+    }
+    last    = stamp;
+    started = true;
+  }
+
+  increase(npackets, receiver.npacket);
+  ndrops.store(receiver.ndrop_kernel, std::memory_order_relaxed);
+}
+
+void UdpRxMonitor::interarrival(uint64_t *hist) const{
+  for(int i = 0; i < UDP_RXMONITOR_NBIN; i++){
+    hist[i] = hist_interarrival[i].load(std::memory_order_relaxed);
+  }
+}
+
+void UdpRxMonitor::latency(uint64_t *hist) const{
+  for(int i = 0; i < UDP_RXMONITOR_NBIN; i++){
+    hist[i] = hist_latency[i].load(std::memory_order_relaxed);
+  }
+}
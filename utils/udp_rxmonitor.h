@@ -0,0 +1,67 @@
+#ifndef _UDP_RXMONITOR_H
+#define _UDP_RXMONITOR_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+#include <atomic>
+
+#include "udp_batchreceiver.h"
+
+#define UDP_RXMONITOR_NBIN 64 ///< Number of log2 bins, bin i > 0 counts values in [2^(i-1), 2^i) nanoseconds, bin 0 counts 0
+
+/*! \brief A class to monitor UDP receive with kernel timestamps
+ *
+ * It keeps histograms of packet inter-arrival time and kernel-to-user latency in log2 nanosecond bins,
+ * and the cumulative number of packets dropped by the kernel, all from a UdpBatchReceiver with control enabled.
+ *
+ * record is called by the receive thread only, all other methods can be called from any thread while it runs,
+ * counters are atomics updated without read-modify-write, so the receive loop never takes a lock or a locked instruction.
+ *
+ */
+class UdpRxMonitor{
+public:
+  //! Constructor of UdpRxMonitor class, all histograms start empty
+  UdpRxMonitor();
+
+  /*! Add the last batch of \p receiver to histograms, only the receive thread should call it
+   *
+   * \param[in] receiver Receiver with control enabled
+   */
+  void record(const UdpBatchReceiver &receiver);
+
+  //! Copy inter-arrival histogram to \p hist, which has UDP_RXMONITOR_NBIN elements
+  void interarrival(uint64_t *hist) const;
+
+  //! Copy kernel-to-user latency histogram to \p hist, which has UDP_RXMONITOR_NBIN elements
+  void latency(uint64_t *hist) const;
+
+  //! Cumulative number of packets dropped by the kernel on the socket
+  uint64_t ndrop() const {return ndrops.load(std::memory_order_relaxed);}
+
+  //! Number of packets recorded
+  uint64_t npacket() const {return npackets.load(std::memory_order_relaxed);}
+
+  //! Lower edge of bin \p i in nanoseconds
+  static uint64_t bin_edge(int i) {return i == 0 ? 0 : 1ULL << (i - 1);}
+
+  //! Bin index of \p ns nanoseconds
+  static int bin_index(int64_t ns);
+
+private:
+  std::atomic<uint64_t> hist_interarrival[UDP_RXMONITOR_NBIN]; ///< Inter-arrival time histogram
+  std::atomic<uint64_t> hist_latency[UDP_RXMONITOR_NBIN];      ///< Kernel-to-user latency histogram
+  std::atomic<uint64_t> ndrops;   ///< Cumulative number of kernel drops
+  std::atomic<uint64_t> npackets; ///< Number of packets recorded
+
+  bool started = false;    ///< Do we have the previous packet timestamp?
+  struct timespec last;    ///< Timestamp of the previous packet
+
+  //! Single writer increment, cheaper than fetch_add
+  static void increase(std::atomic<uint64_t> &counter, uint64_t n = 1){
+    counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+  }
+};
+
+#endif
@@ -8,13 +8,15 @@
 
 int create_udp_socket(char *ip, char *group, int port, int &sock,
 		      int reuse, int bufsz, double tout,
-		      enum udp_mode mode, enum udp_direction direction){
+		      enum udp_mode mode, enum udp_direction direction,
+		      int options){
 
   sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
 
   // Setup reuse if it is required
   if(reuse){
-    if (setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse))){
+    int enable = 1;
+    if (setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable))){
       fprintf(stderr, "CREATE_UDP_SOCKET_ERROR: Could not enable SO_REUSEADDR to %s_%d, "
 	      "which happens at \"%s\", line [%d], has to abort.\n",
 	      ip, port, __FILE__, __LINE__);
@@ -24,6 +26,19 @@ int create_udp_socket(char *ip, char *group, int port, int &sock,
     }    
   }
 
+  // Setup reuse port if it is required, it has to be done before bind
+  if(reuse & UDP_REUSE_PORT){
+    int enable = 1;
+    if (setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(enable))){
+      fprintf(stderr, "CREATE_UDP_SOCKET_ERROR: Could not enable SO_REUSEPORT to %s_%d, "
+	      "which happens at \"%s\", line [%d], has to abort.\n",
+	      ip, port, __FILE__, __LINE__);
+      
+      close(sock);
+      return EXIT_FAILURE;
+    }    
+  }
+
   // Setup socket according tout
   // tout == 0, NONBLOCK
   // tout > 0, block with timeout
@@ -84,6 +99,33 @@ int create_udp_socket(char *ip, char *group, int port, int &sock,
     }
   }
 
+  // Setup kernel receive timestamp and drop counter if it is required
+  if((options & UDP_OPTION_TIMESTAMP) && direction == UDP_RECV){
+    int enable = 1;
+    if (setsockopt(sock, SOL_SOCKET, SO_TIMESTAMPNS, &enable, sizeof(enable)) ||
+	setsockopt(sock, SOL_SOCKET, SO_RXQ_OVFL, &enable, sizeof(enable))){
+      fprintf(stderr, "CREATE_UDP_SOCKET_ERROR: Could not enable SO_TIMESTAMPNS and SO_RXQ_OVFL to %s_%d, "
+	      "which happens at \"%s\", line [%d], has to abort.\n",
+	      ip, port, __FILE__, __LINE__);
+      
+      close(sock);
+      return EXIT_FAILURE;
+    }
+  }
+
+  // Setup receive coalescing if it is required
+  if((options & UDP_OPTION_GRO) && direction == UDP_RECV){
+    int enable = 1;
+    if (setsockopt(sock, SOL_UDP, UDP_GRO, &enable, sizeof(enable))){
+      fprintf(stderr, "CREATE_UDP_SOCKET_ERROR: Could not enable UDP_GRO to %s_%d, "
+	      "which happens at \"%s\", line [%d], has to abort.\n",
+	      ip, port, __FILE__, __LINE__);
+      
+      close(sock);
+      return EXIT_FAILURE;
+    }
+  }
+
   struct sockaddr_in sa = {0};
   sa.sin_family = AF_INET;
     
@@ -101,7 +143,33 @@ int create_udp_socket(char *ip, char *group, int port, int &sock,
       } // if (setsockopt(sock, SOL_SOCKET, SO_BROADCAST, &broadcast, sizeof(broadcast)))
     } // if(mode == UDP_BROADCAST)
 
-    if(ip != NULL){
+    // In send direction, UDP_MULTICAST sends to group and uses ip to pick up the interface
+    if(mode == UDP_MULTICAST && group != NULL){
+      if(ip != NULL){
+	struct in_addr iface = {0};
+	iface.s_addr = inet_addr(ip);
+	if (setsockopt(sock, IPPROTO_IP, IP_MULTICAST_IF, &iface, sizeof(iface))){
+	  fprintf(stderr, "CREATE_UDP_SOCKET_ERROR: Could not setup IP_MULTICAST_IF to %s, "
+		  "which happens at \"%s\", line [%d], has to abort.\n",
+		  ip, __FILE__, __LINE__);
+	  
+	  close(sock);
+	  return EXIT_FAILURE;
+	} // if (setsockopt(sock, IPPROTO_IP, IP_MULTICAST_IF, &iface, sizeof(iface)))
+      } // if(ip != NULL)
+      
+      sa.sin_port = htons(port);
+      sa.sin_addr.s_addr = inet_addr(group);
+      if (connect(sock, (struct sockaddr *)&sa, sizeof(sa))){
+	fprintf(stderr, "CREATE_UDP_SOCKET_ERROR: Can not connect to multicast group %s_%d, "
+		"which happens at \"%s\", line [%d], has to abort.\n",
+		group, port, __FILE__, __LINE__);
+	
+	close(sock);
+	return EXIT_FAILURE;
+      } // if (connect(sock, (struct sockaddr *)&sa, sizeof(sa))){
+    } // if(mode == UDP_MULTICAST && group != NULL)
+    else if(ip != NULL){
       // if send ip is INADDR_ANY, it connects to loopback,
       // with which we can not use it to send data to a remote machine
       // use NULL to let OS decide ip and port for sending
@@ -16,29 +16,38 @@
 #include <sys/socket.h>
 #include <netinet/ip.h>
 #include <netinet/in.h>
+#include <netinet/udp.h>
 #include <arpa/inet.h>
 #include <fcntl.h>
 
 enum udp_direction {UDP_SEND = 0,    UDP_RECV = 1};
 enum udp_mode      {UDP_UNICAST = 0, UDP_MULTICAST=1, UDP_BROADCAST=2};
 
+#define UDP_REUSE_ADDR 1 ///< reuse flag to enable SO_REUSEADDR
+#define UDP_REUSE_PORT 2 ///< reuse flag to enable SO_REUSEPORT, so that multiple sockets can bind to the same ip and port
+
+#define UDP_OPTION_TIMESTAMP 1 ///< option flag to enable SO_TIMESTAMPNS and SO_RXQ_OVFL on receive socket
+#define UDP_OPTION_GRO       2 ///< option flag to enable UDP_GRO on receive socket, so that kernel can coalesce same flow datagrams
+
 //#define UDP_DEFAULT_MODE      UDP_UNICAST
 //#define UDP_DEFAULT_DIRECTION UDP_SEND
 
 /*! A function to create udp socket for different mode (unicast, broadcast and multicast) and two directions (send and receive)
   
  * @param[in] ip        IP address, 0.0.0.0 is INADDR_ANY, 255.255.255.255 is INADDR_UDP_BROADCAST, for sender use NULL will not bind socket to a physical interface
- * @param[in] group     multicast group, only be used when mode == UDP_MULTICAST
+ * @param[in] group     multicast group, only be used when mode == UDP_MULTICAST, sender connects to group and uses ip as the interface if group is not NULL
  * @param[in] port      port number 
- * @param[in] reuse     reuse the interface if it is nonzero
+ * @param[in] reuse     reuse the interface if it is nonzero, UDP_REUSE_PORT bit also enables SO_REUSEPORT
  * @param[in] bufsz     socket buffer size in MBytes, 0 or negative value means the default value will be used 
  * @param[in] tout      time out in seconds, 0 means the socket is nonblock, negative means block without timeout
  * @param[in] mode      socket mode, which can be UDP_UNICAST, UDP_MULTICAST or UDP_BROADCAST
  * @param[in] direction which direction the traffic will be, send or receive
+ * @param[in] options   bitwise OR of UDP_OPTION_* flags, 0 means no extra option
 
  * @param[out] sock     to return create socket
  */
 int create_udp_socket(char *ip, char *group, int port, int &sock,
 		      int reuse, int bufsz, double tout,
-		      enum udp_mode mode, enum udp_direction direction);
+		      enum udp_mode mode, enum udp_direction direction,
+		      int options = 0);
 #endif
@@ -0,0 +1,252 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "uring_receiver.h"
+
+// Kernel updates heads and tails of the rings from another context
+#define URING_LOAD_ACQUIRE(p)     __atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define URING_STORE_RELEASE(p, v) __atomic_store_n(p, v, __ATOMIC_RELEASE)
+
+UringReceiver::UringReceiver(int sock, int pktsz, int depth, int nbatch)
+  :sock(sock), pktsz(pktsz), depth(depth), nbatch(nbatch){
+
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  params.flags = IORING_SETUP_COOP_TASKRUN;
+  ring = syscall(__NR_io_uring_setup, depth, &params);
+  if(ring < 0 && errno == EINVAL){
+    // Older kernel, setup without flags
+    memset(&params, 0, sizeof(params));
+    ring = syscall(__NR_io_uring_setup, depth, &params);
+  }
+  if(ring < 0){
+    fprintf(stderr, "URING_RECEIVER_ERROR: Could not setup io_uring with \"%s\", "
+	    "which happens at \"%s\", line [%d], has to abort.\n",
+	    strerror(errno), __FILE__, __LINE__);
+    exit(EXIT_FAILURE);
+  }
+  ext_arg = params.features & IORING_FEAT_EXT_ARG;
+
+  // Map rings
+  sq_size = params.sq_off.array + params.sq_entries*sizeof(unsigned);
+  cq_size = params.cq_off.cqes + params.cq_entries*sizeof(struct io_uring_cqe);
+  if(params.features & IORING_FEAT_SINGLE_MMAP){
+    sq_size = sq_size > cq_size ? sq_size : cq_size;
+    cq_size = sq_size;
+  }
+  sq_ptr = mmap(NULL, sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_SQ_RING);
+  if(params.features & IORING_FEAT_SINGLE_MMAP){
+    cq_ptr = sq_ptr;
+  }
+  else{
+    cq_ptr = mmap(NULL, cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_CQ_RING);
+  }
+  sqes_size = params.sq_entries*sizeof(struct io_uring_sqe);
+  sqes = (struct io_uring_sqe *)mmap(NULL, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_SQES);
+  if(sq_ptr == MAP_FAILED || cq_ptr == MAP_FAILED || sqes == MAP_FAILED){
+    fprintf(stderr, "URING_RECEIVER_ERROR: Could not map io_uring with \"%s\", "
+	    "which happens at \"%s\", line [%d], has to abort.\n",
+	    strerror(errno), __FILE__, __LINE__);
+    exit(EXIT_FAILURE);
+  }
+
+  sq_head  = (unsigned *)((char *)sq_ptr + params.sq_off.head);
+  sq_tail  = (unsigned *)((char *)sq_ptr + params.sq_off.tail);
+  sq_mask  = (unsigned *)((char *)sq_ptr + params.sq_off.ring_mask);
+  sq_array = (unsigned *)((char *)sq_ptr + params.sq_off.array);
+  cq_head  = (unsigned *)((char *)cq_ptr + params.cq_off.head);
+  cq_tail  = (unsigned *)((char *)cq_ptr + params.cq_off.tail);
+  cq_mask  = (unsigned *)((char *)cq_ptr + params.cq_off.ring_mask);
+  cqes     = (struct io_uring_cqe *)((char *)cq_ptr + params.cq_off.cqes);
+
+  // One slot for each posted receive, one extra byte per slot to catch larger datagrams
+  stride = ((size_t)pktsz + 1 + UDP_CACHELINE_SIZE - 1)/UDP_CACHELINE_SIZE*UDP_CACHELINE_SIZE;
+  if(posix_memalign((void **)&data, UDP_CACHELINE_SIZE, stride*depth)){
+    fprintf(stderr, "URING_RECEIVER_ERROR: Could not allocate %zu bytes arena, "
+	    "which happens at \"%s\", line [%d], has to abort.\n",
+	    stride*depth, __FILE__, __LINE__);
+    exit(EXIT_FAILURE);
+  }
+
+  // Register the whole arena as one fixed buffer
+  struct iovec iov = {data, stride*depth};
+  if(syscall(__NR_io_uring_register, ring, IORING_REGISTER_BUFFERS, &iov, 1)){
+    fprintf(stderr, "URING_RECEIVER_ERROR: Could not register %zu bytes arena with \"%s\", "
+	    "which happens at \"%s\", line [%d], has to abort.\n",
+	    stride*depth, strerror(errno), __FILE__, __LINE__);
+    exit(EXIT_FAILURE);
+  }
+
+  slots = (int *)calloc(nbatch, sizeof(int));
+  sizes = (int *)calloc(nbatch, sizeof(int));
+  if(slots == NULL || sizes == NULL){
+    fprintf(stderr, "URING_RECEIVER_ERROR: Could not allocate batch arrays, "
+	    "which happens at \"%s\", line [%d], has to abort.\n",
+	    __FILE__, __LINE__);
+    exit(EXIT_FAILURE);
+  }
+
+  // Receives on one stream may complete out of byte order, so a stream gets one at a time
+  int type = SOCK_DGRAM;
+  socklen_t len = sizeof(type);
+  getsockopt(sock, SOL_SOCKET, SO_TYPE, &type, &len);
+  stream = type == SOCK_STREAM;
+
+  for(int i = 0; i < (stream ? 1 : depth); i++){
+    post(i);
+  }
+  if(enter(0, 0) < 0){
+    fprintf(stderr, "URING_RECEIVER_ERROR: Could not post receives with \"%s\", "
+	    "which happens at \"%s\", line [%d], has to abort.\n",
+	    strerror(errno), __FILE__, __LINE__);
+    exit(EXIT_FAILURE);
+  }
+}
+
+UringReceiver::~UringReceiver(){
+  // Closing the ring cancels posted receives before we free the arena
+  close(ring);
+
+  munmap(sqes, sqes_size);
+  if(cq_ptr != sq_ptr){
+    munmap(cq_ptr, cq_size);
+  }
+  munmap(sq_ptr, sq_size);
+
+  free(slots);
+  free(sizes);
+  free(data);
+}
+
+void UringReceiver::post(int slot){
+  unsigned tail  = *sq_tail;
+  unsigned index = tail & *sq_mask;
+
+  struct io_uring_sqe *sqe = &sqes[index];
+  memset(sqe, 0, sizeof(*sqe));
+  sqe->opcode    = IORING_OP_READ_FIXED;
+  sqe->fd        = sock;
+  sqe->off       = (uint64_t)-1; // sockets have no file position
+  sqe->addr      = (uint64_t)(uintptr_t)(data + (size_t)slot*stride);
+  sqe->len       = stride;
+  sqe->buf_index = 0;
+  sqe->user_data = slot;
+
+  sq_array[index] = index;
+  URING_STORE_RELEASE(sq_tail, tail + 1);
+  ninflight++;
+}
+
+int UringReceiver::enter(unsigned min_complete, double tout){
+  unsigned nsubmit = *sq_tail - URING_LOAD_ACQUIRE(sq_head);
+  unsigned flags   = min_complete ? IORING_ENTER_GETEVENTS : 0;
+
+  int ret;
+  nsyscall_total++;
+  if(min_complete && tout > 0 && ext_arg){
+    struct __kernel_timespec ts;
+    ts.tv_sec  = (int64_t)tout;
+    ts.tv_nsec = (long long)((tout - ts.tv_sec)*1E9);
+
+    struct io_uring_getevents_arg arg;
+    memset(&arg, 0, sizeof(arg));
+    arg.ts = (uint64_t)(uintptr_t)&ts;
+    ret = syscall(__NR_io_uring_enter, ring, nsubmit, min_complete, flags | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+  }
+  else{
+    // Without IORING_FEAT_EXT_ARG we block without timeout
+    ret = syscall(__NR_io_uring_enter, ring, nsubmit, min_complete, flags, NULL, 0);
+  }
+
+  return ret;
+}
+
+int UringReceiver::receive(double tout){
+
+  npacket    = 0;
+  ntruncated = 0;
+  nshort     = 0;
+
+  // Slots of the last batch are free now
+  for(int i = 0; i < nrepost; i++){
+    post(slots[i]);
+  }
+  nrepost = 0;
+
+  // Every slot has seen end of stream, nothing would ever complete
+  if(eof && ninflight == 0){
+    errno = 0;
+    return -1;
+  }
+
+  unsigned head  = *cq_head;
+  unsigned ready = URING_LOAD_ACQUIRE(cq_tail) - head;
+  if(ready == 0){
+    // Nothing to reap, give reposted receives to kernel and wait
+    if(enter(tout == 0 ? 0 : 1, tout) < 0 && errno != ETIME && errno != EINTR){
+      return -1;
+    }
+    ready = URING_LOAD_ACQUIRE(cq_tail) - head;
+    if(ready == 0){
+      // The last enter may have submitted only
+      if(tout == 0){
+	errno = EAGAIN;
+      }
+      else if(errno != EINTR){
+	errno = ETIME;
+      }
+      return -1;
+    }
+  }
+  else if(*sq_tail - URING_LOAD_ACQUIRE(sq_head) >= (unsigned)depth/2){
+    // Keep the queue deep, submit without waiting
+    if(enter(0, 0) < 0){
+      return -1;
+    }
+  }
+
+  int error = 0;
+  while(ready > 0 && npacket < nbatch){
+    struct io_uring_cqe *cqe = &cqes[head & *cq_mask];
+    int slot = cqe->user_data;
+    int res  = cqe->res;
+    head++;
+    ready--;
+    ninflight--;
+
+    if(res > 0){
+      slots[npacket] = slot;
+      sizes[npacket] = res;
+      if(res > pktsz){
+	ntruncated++;
+      }
+      else if(res < pktsz){
+	nshort++;
+      }
+      nbyte_total += res;
+      npacket++;
+    }
+    else if(res == 0){
+      // Peer closed the stream, this slot stays idle
+      eof = 1;
+    }
+    else{
+      nerror_total++;
+      error = -res;
+      post(slot);
+    }
+  }
+  URING_STORE_RELEASE(cq_head, head);
+
+  nrepost = npacket;
+  npacket_total    += npacket;
+  ntruncated_total += ntruncated;
+  nshort_total     += nshort;
+
+  if(npacket == 0){
+    errno = error;
+    return -1;
+  }
+  return npacket;
+}
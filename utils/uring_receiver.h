@@ -0,0 +1,125 @@
+#ifndef _URING_RECEIVER_H
+#define _URING_RECEIVER_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+
+#include "udp_batchreceiver.h"
+
+/*! \brief A class to receive from a UDP or TCP socket with io_uring and registered buffers
+ *
+ * The class keeps \p depth receives posted on the socket all the time, each one reads into a slot of a
+ * cache aligned arena which is registered with the kernel once, so buffers are not mapped for every receive.
+ * Completions are reaped in batches of up to \p nbatch directly from the completion ring,
+ * a system call is needed only when the ring is empty or enough slots wait to be posted again,
+ * so at high packet rates many batches go without any system call.
+ *
+ * It offers the same batch interface as UdpBatchReceiver, receive, npacket, packet and packet_size,
+ * pointers are valid until the next call of receive, slots of the last batch are posted again at that point.
+ * For UDP one completion is one datagram, for TCP one completion is whatever the stream has, up to one slot.
+ * io_uring does not keep several receives on one stream in byte order, so a TCP socket has only one receive
+ * in flight and each batch has at most one packet, the stream data stays in order.
+ *
+ * Use it with a socket created by `create_udp_socket` or `create_tcp_socket` with `tout < 0` or `tout == 0`,
+ * the timeout is given to receive instead and follows the same convention.
+ * The kernel has to support io_uring, it is called with raw system calls so no extra library is needed.
+ *
+ */
+class UringReceiver{
+public:
+  int npacket = 0;         ///< Number of packets received with the last call of receive
+  int ntruncated = 0;      ///< Number of packets larger than pktsz in the last batch
+  int nshort = 0;          ///< Number of packets smaller than pktsz in the last batch
+  int eof = 0;             ///< Nonzero when peer closed a stream socket
+
+  uint64_t npacket_total    = 0; ///< Number of packets received since the class is created
+  uint64_t nbyte_total      = 0; ///< Number of bytes received since the class is created
+  uint64_t ntruncated_total = 0; ///< Number of truncated packets since the class is created
+  uint64_t nshort_total     = 0; ///< Number of short packets since the class is created
+  uint64_t nerror_total     = 0; ///< Number of failed receives since the class is created, they are posted again
+  uint64_t nsyscall_total   = 0; ///< Number of `io_uring_enter` calls since the class is created
+
+  //! Constructor of UringReceiver class.
+  /*!
+   *
+   * - setup io_uring with \p depth entries and map its rings
+   * - allocate and register a cache aligned arena of \p depth slots
+   * - post \p depth receives, only one for a stream socket
+   *
+   * \param[in] sock   Socket to receive from, the class does not close it
+   * \param[in] pktsz  Expected packet size in bytes, PKT_SIZE in DADA header
+   * \param[in] depth  Number of receives to keep posted, rounded up to a power of 2 by the kernel
+   * \param[in] nbatch Maximum number of packets to return with one call of receive
+   *
+   */
+  UringReceiver(int sock, int pktsz, int depth, int nbatch);
+
+  //! Deconstructor of UringReceiver class.
+  /*!
+   *
+   * - close io_uring, which cancels posted receives, unmap rings and free the arena
+   */
+  ~UringReceiver();
+
+  /*! Reap a batch of completed receives
+   *
+   * \param[in] tout Timeout in seconds, negative value blocks, 0 returns what is ready
+   *
+   * \returns Number of packets received, -1 on error, timeout (ETIME), nothing ready (EAGAIN) or end of stream,
+   *          after end of stream with no receive left in flight it returns -1 right away
+   */
+  int receive(double tout = -1);
+
+  //! Pointer to packet \p i of the last batch
+  char *packet(int i) const {return data + (size_t)slots[i]*stride;}
+
+  //! Number of bytes of packet \p i of the last batch
+  int packet_size(int i) const {return sizes[i];}
+
+  UringReceiver(const UringReceiver&) = delete;
+  UringReceiver& operator=(const UringReceiver&) = delete;
+
+private:
+  int sock;    ///< Socket to receive from
+  int pktsz;   ///< Expected packet size in bytes
+  int depth;   ///< Number of posted receives
+  int nbatch;  ///< Maximum number of packets per batch
+  size_t stride; ///< Bytes between slots, one more than pktsz so that larger datagrams show up
+
+  int ring = -1;        ///< io_uring fd
+  char *data = NULL;    ///< Registered arena, slot i starts at data + i*stride
+
+  void *sq_ptr = MAP_FAILED;   ///< Mapped submission ring
+  void *cq_ptr = MAP_FAILED;   ///< Mapped completion ring, same as sq_ptr with IORING_FEAT_SINGLE_MMAP
+  size_t sq_size = 0;
+  size_t cq_size = 0;
+  struct io_uring_sqe *sqes = (struct io_uring_sqe *)MAP_FAILED; ///< Mapped submission entries
+  size_t sqes_size = 0;
+
+  unsigned *sq_head, *sq_tail, *sq_mask, *sq_array;
+  unsigned *cq_head, *cq_tail, *cq_mask;
+  struct io_uring_cqe *cqes;
+
+  int ext_arg = 0;       ///< Kernel supports timeout with IORING_ENTER_EXT_ARG
+  int stream = 0;        ///< 1 for a stream socket, which keeps only one receive in flight
+  int ninflight = 0;     ///< Number of receives posted and not reaped yet
+
+  int *slots = NULL;     ///< Slot of packet i of the last batch
+  int *sizes = NULL;     ///< Size of packet i of the last batch
+  int nrepost = 0;       ///< Number of slots of the last batch to post again
+
+  void post(int slot);   ///< Queue a receive into slot
+  int enter(unsigned min_complete, double tout); ///< Submit queued receives and wait for completions
+};
+
+#endif
@@ -0,0 +1,188 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "zerocopy_sender.h"
+
+// Counters wrap at 32 bits, compare them by distance
+static inline bool before(uint32_t a, uint32_t b){
+  return (int32_t)(a - b) < 0;
+}
+
+ZerocopySender::ZerocopySender(int sock)
+  :sock(sock){
+
+  int enable = 1;
+  if(setsockopt(sock, SOL_SOCKET, SO_ZEROCOPY, &enable, sizeof(enable))){
+    fprintf(stderr, "ZEROCOPY_SENDER_ERROR: Could not enable SO_ZEROCOPY with \"%s\", "
+	    "which happens at \"%s\", line [%d], has to abort.\n",
+	    strerror(errno), __FILE__, __LINE__);
+    exit(EXIT_FAILURE);
+  }
+
+  int type = SOCK_DGRAM;
+  socklen_t len = sizeof(type);
+  getsockopt(sock, SOL_SOCKET, SO_TYPE, &type, &len);
+  stream = type == SOCK_STREAM;
+}
+
+int ZerocopySender::send(const char *buf, size_t nbytes, uint32_t &ticket){
+
+  const char *ptr = buf;
+  size_t ntowrite = nbytes;
+
+  // Zero bytes on a stream takes no kernel counter, hand out one which is already completed
+  if(stream && nbytes == 0){
+    ticket = upto - 1;
+    return EXIT_SUCCESS;
+  }
+
+  // Loop at least once, a zero length datagram still has to go out
+  while(true){
+    ssize_t nwrote = ::send(sock, ptr, ntowrite, MSG_ZEROCOPY);
+    nsyscall_total++;
+
+    if(nwrote < 0){
+      if(errno == EINTR){
+	continue;
+      }
+      if(errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS){
+	// Socket buffer is full or pinned memory is over the limit, wait and release what we can
+	struct pollfd pfd = {sock, POLLOUT, 0};
+	poll(&pfd, 1, 1);
+	if(reap() < 0){
+	  return EXIT_FAILURE;
+	}
+	continue;
+      }
+      fprintf(stderr, "ZEROCOPY_SENDER_ERROR: send failed with \"%s\", "
+	      "which happens at \"%s\", line [%d], has to abort.\n",
+	      strerror(errno), __FILE__, __LINE__);
+      return EXIT_FAILURE;
+    }
+
+    // Each successful call takes one counter, even a partial one
+    ticket = next++;
+    ntowrite    -= nwrote;
+    ptr         += nwrote;
+    nbyte_total += nwrote;
+
+    if(ntowrite == 0){
+      return EXIT_SUCCESS;
+    }
+  }
+}
+
+void ZerocopySender::complete(uint32_t lo, uint32_t hi){
+  if(before(upto, lo)){
+    // Out of order, keep it until the gap is filled
+    pending.push_back(std::make_pair(lo, hi));
+    return;
+  }
+  if(!before(hi, upto)){
+    upto = hi + 1;
+  }
+
+  // Merge ranges which are contiguous now
+  bool merged = true;
+  while(merged){
+    merged = false;
+    for(size_t i = 0; i < pending.size(); i++){
+      if(!before(upto, pending[i].first)){
+	if(!before(pending[i].second, upto)){
+	  upto = pending[i].second + 1;
+	}
+	pending[i] = pending.back();
+	pending.pop_back();
+	merged = true;
+	break;
+      }
+    }
+  }
+}
+
+int ZerocopySender::reap(){
+  int nmsg = 0;
+
+  while(true){
+    char control[CMSG_SPACE(sizeof(struct sock_extended_err)) + 64];
+    struct msghdr msg = {0};
+    msg.msg_control    = control;
+    msg.msg_controllen = sizeof(control);
+
+    if(recvmsg(sock, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0){
+      if(errno == EAGAIN || errno == EWOULDBLOCK){
+	return nmsg;
+      }
+      if(errno == EINTR){
+	continue;
+      }
+      fprintf(stderr, "ZEROCOPY_SENDER_ERROR: Could not read error queue with \"%s\", "
+	      "which happens at \"%s\", line [%d], has to abort.\n",
+	      strerror(errno), __FILE__, __LINE__);
+      return -1;
+    }
+
+    for(struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg)){
+      if(!((cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_RECVERR) ||
+	   (cmsg->cmsg_level == SOL_IPV6 && cmsg->cmsg_type == IPV6_RECVERR))){
+	continue;
+      }
+
+      struct sock_extended_err err;
+      memcpy(&err, CMSG_DATA(cmsg), sizeof(err));
+      if(err.ee_origin != SO_EE_ORIGIN_ZEROCOPY || err.ee_errno != 0){
+	continue;
+      }
+
+      // Completion of counters [ee_info, ee_data]
+      complete(err.ee_info, err.ee_data);
+      ncompleted_total += err.ee_data - err.ee_info + 1;
+      if(err.ee_code & SO_EE_CODE_ZEROCOPY_COPIED){
+	ncopied_total += err.ee_data - err.ee_info + 1;
+      }
+    }
+    nmsg++;
+  }
+}
+
+bool ZerocopySender::done(uint32_t ticket){
+  if(before(ticket, upto)){
+    return true;
+  }
+  reap();
+
+  return before(ticket, upto);
+}
+
+int ZerocopySender::wait(uint32_t ticket, double tout){
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  while(!done(ticket)){
+    int tout_ms = -1;
+    if(tout >= 0){
+      struct timespec now;
+      clock_gettime(CLOCK_MONOTONIC, &now);
+      double remain = tout - (now.tv_sec - start.tv_sec) - (now.tv_nsec - start.tv_nsec)/1E9;
+      if(remain <= 0){
+	fprintf(stderr, "ZEROCOPY_SENDER_ERROR: Buffer %u is not released in %f seconds, "
+		"which happens at \"%s\", line [%d], has to abort.\n",
+		ticket, tout, __FILE__, __LINE__);
+	return EXIT_FAILURE;
+      }
+      tout_ms = (int)(remain*1E3) + 1;
+    }
+
+    // Completions show up as POLLERR
+    struct pollfd pfd = {sock, 0, 0};
+    if(poll(&pfd, 1, tout_ms) < 0 && errno != EINTR){
+      fprintf(stderr, "ZEROCOPY_SENDER_ERROR: poll failed with \"%s\", "
+	      "which happens at \"%s\", line [%d], has to abort.\n",
+	      strerror(errno), __FILE__, __LINE__);
+      return EXIT_FAILURE;
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
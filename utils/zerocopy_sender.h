@@ -0,0 +1,95 @@
+#ifndef _ZEROCOPY_SENDER_H
+#define _ZEROCOPY_SENDER_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <time.h>
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <linux/errqueue.h>
+
+#include <vector>
+
+/*! \brief A class to send from user buffers with MSG_ZEROCOPY and track when the kernel releases them
+ *
+ * The class wraps a connected TCP or UDP socket, for example one created by `create_tcp_socket` or
+ * `create_udp_socket` in send direction, and enables SO_ZEROCOPY on it.
+ * Pages of a buffer are pinned and sent without copy, so the buffer must not be changed or freed
+ * until the kernel reports completion on the socket error queue.
+ *
+ * Every send returns a ticket, the buffer can be reused once done(ticket) returns true,
+ * wait(ticket) blocks until then. Completions are reaped from the error queue by done, wait and reap.
+ *
+ * The kernel falls back to copy when it can not send from user pages, loopback always does,
+ * ncopied_total counts such completions. Zero copy pays off for large sends, about 10 KB and above.
+ *
+ */
+class ZerocopySender{
+public:
+  uint64_t nbyte_total      = 0; ///< Number of bytes sent since the class is created
+  uint64_t nsyscall_total   = 0; ///< Number of `sendmsg` calls since the class is created
+  uint64_t ncompleted_total = 0; ///< Number of `sendmsg` calls completed by the kernel
+  uint64_t ncopied_total    = 0; ///< Number of completions for which the kernel copied data anyway
+
+  //! Constructor of ZerocopySender class.
+  /*!
+   *
+   * - enable SO_ZEROCOPY on \p sock, abort if kernel does not support it
+   *
+   * \param[in] sock Connected socket to send to, the class does not close it
+   *
+   */
+  ZerocopySender(int sock);
+
+  /*! Send \p nbytes from \p buf without copy
+   *
+   * Partial sends of stream sockets are continued until all bytes are out,
+   * EINTR and EAGAIN are retried, ENOBUFS (too much pinned memory) reaps completions before retry.
+   * A stream socket takes no kernel counter for zero bytes, so it sends nothing and the ticket is already done.
+   *
+   * \param[in]  buf    Buffer to send, it must stay unchanged until done(ticket)
+   * \param[in]  nbytes Number of bytes to send, for UDP it is one datagram
+   * \param[out] ticket Ticket of the buffer for done and wait
+   *
+   * \returns EXIT_SUCCESS or EXIT_FAILURE
+   */
+  int send(const char *buf, size_t nbytes, uint32_t &ticket);
+
+  /*! Check if the kernel released the buffer of \p ticket, it reaps the error queue without blocking
+   *
+   * \returns true if the buffer can be reused
+   */
+  bool done(uint32_t ticket);
+
+  /*! Block until the kernel releases the buffer of \p ticket
+   *
+   * \param[in] tout Timeout in seconds, negative value waits forever
+   *
+   * \returns EXIT_SUCCESS or EXIT_FAILURE on error or timeout
+   */
+  int wait(uint32_t ticket, double tout = -1);
+
+  /*! Read all pending completions from the error queue without blocking
+   *
+   * \returns Number of completion messages read, -1 on error
+   */
+  int reap();
+
+private:
+  int sock;           ///< Socket to send to
+  int stream = 0;     ///< 1 for a stream socket
+  uint32_t next = 0;  ///< Kernel counter of the next zero copy sendmsg
+  uint32_t upto = 0;  ///< All sendmsg calls before this counter are completed
+
+  std::vector<std::pair<uint32_t, uint32_t>> pending; ///< Completed ranges [lo, hi] after a gap, kernel may report out of order
+
+  void complete(uint32_t lo, uint32_t hi); ///< Record a completed range
+};
+
+#endif